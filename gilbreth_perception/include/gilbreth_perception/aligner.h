@@ -0,0 +1,68 @@
+#ifndef GILBRETH_PERCEPTION_ALIGNER_H
+#define GILBRETH_PERCEPTION_ALIGNER_H
+
+#include "gilbreth_perception/fine_alignment.h"
+#include "gilbreth_perception/latency_controller.h"
+#include "gilbreth_perception/part.h"
+#include "gilbreth_perception/planar_recognizer.h"
+#include "gilbreth_perception/stage_timer.h"
+#include <memory>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct AlignerParameters
+{
+  float down_sample = 0.01f;        /** @brief leaf size of the models and of the incoming clouds */
+  bool planar = false;              /** @brief x, y and yaw search instead of the fine alignment */
+  PlanarParameters planar_params;
+  FineAlignmentParameters fine_alignment_params;
+  bool print_detailed_info = false;
+};
+
+/**
+ * @brief Pose of a cloud whose part is already known, by the fine alignment from the translation of the model
+ * centroid onto the cloud centroid, or by the planar search.
+ */
+class Aligner
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  explicit Aligner(const AlignerParameters& params);
+
+  /**
+   * @brief Loads and prepares the model of every part, the model ids follow the order of the parts.
+   */
+  bool loadModels(const std::vector<PartDescription>& parts);
+
+  std::size_t getModelCount() const
+  {
+    return parts_.size();
+  }
+
+  /**
+   * @brief Aligns the model to the cloud, coarsened to the leaf size of the operating point first, timed as the
+   * downsample and the planar or fine_alignment stages. False for an unknown model or a failed planar search or
+   * fine alignment.
+   */
+  bool align(int model_id, const Cloud::ConstPtr& scene, const OperatingPoint& operating_point, StageTimer& timer,
+             Detection& detection) const;
+
+private:
+  AlignerParameters params_;
+  std::vector<PartDescription> parts_;
+  std::vector<Eigen::Vector3f> model_centroids_;
+  std::unique_ptr<PlanarRecognizer> planar_recognizer_;
+  std::unique_ptr<FineAlignment> fine_alignment_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_ALIGNER_H
@@ -0,0 +1,80 @@
+#ifndef GILBRETH_PERCEPTION_BINARY_DESCRIPTOR_INDEX_H
+#define GILBRETH_PERCEPTION_BINARY_DESCRIPTOR_INDEX_H
+
+#include <array>
+#include <cstdint>
+#include <pcl/correspondence.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Alternative to DescriptorIndex over binarized SHOT descriptors. Each of the 352 bins becomes one bit, set
+ * when the bin is above the mean of that bin over the model descriptors. Matching is an exhaustive XOR and popcount
+ * scan of the model codes, which for a few thousand model descriptors stays in cache and beats a tree traversal.
+ */
+class BinaryDescriptorIndex
+{
+public:
+  typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+  static const int WORDS = 6;   /** @brief 352 bits rounded up to 64 bit words */
+  typedef std::array<std::uint64_t, WORDS> Code;
+
+  BinaryDescriptorIndex();
+
+  /**
+   * @brief Learns the bin thresholds and encodes the model descriptors, the position of each cloud in the list is
+   * used as its model id.
+   */
+  void build(const std::vector<DescriptorCloud::Ptr>& model_descriptors);
+
+  /**
+   * @brief Same contract as DescriptorIndex::match with the Hamming distance in place of the squared distance.
+   * @param max_distance  Maximum number of differing bits of a correspondence
+   */
+  void match(const DescriptorCloud& scene_descriptors, int max_distance, const std::vector<int>& models,
+             std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const;
+
+  std::size_t getModelCount() const
+  {
+    return model_count_;
+  }
+
+  std::size_t size() const
+  {
+    return codes_.size();
+  }
+
+  std::size_t getCodeBytes() const
+  {
+    return codes_.size() * sizeof(Code);
+  }
+
+  const char* getKernelName() const
+  {
+    return kernel_name_;
+  }
+
+private:
+  typedef void (*ScanKernel)(const Code* codes, std::size_t count, const Code& query, int* distances);
+
+  Code encode(const pcl::SHOT352& descriptor) const;
+
+  std::vector<float> thresholds_;
+  std::vector<Code> codes_;
+  std::size_t model_count_;
+  std::vector<int> model_ids_;      /** @brief model of each encoded descriptor */
+  std::vector<int> model_indices_;  /** @brief index of each encoded descriptor within its model */
+  ScanKernel kernel_;
+  const char* kernel_name_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_BINARY_DESCRIPTOR_INDEX_H
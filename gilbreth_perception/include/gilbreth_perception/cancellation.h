@@ -0,0 +1,43 @@
+#ifndef GILBRETH_PERCEPTION_CANCELLATION_H
+#define GILBRETH_PERCEPTION_CANCELLATION_H
+
+#include <atomic>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Flag shared by the tasks of a computation that asks them to stop. Cancellation is cooperative, a task
+ * only stops at the points where it checks isCancelled().
+ */
+class CancellationToken
+{
+public:
+  CancellationToken():
+    cancelled_(false)
+  {
+  }
+
+  CancellationToken(const CancellationToken&) = delete;
+  CancellationToken& operator=(const CancellationToken&) = delete;
+
+  void cancel()
+  {
+    cancelled_.store(true, std::memory_order_release);
+  }
+
+  bool isCancelled() const
+  {
+    return cancelled_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<bool> cancelled_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_CANCELLATION_H
@@ -0,0 +1,67 @@
+#ifndef GILBRETH_PERCEPTION_COARSE_FILTER_H
+#define GILBRETH_PERCEPTION_COARSE_FILTER_H
+
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Whole cluster signature that is cheap enough to compute for every cluster.
+ */
+struct ShapeSignature
+{
+  Eigen::Vector3f extents = Eigen::Vector3f::Zero();   /** @brief oriented bounding box extents, largest first */
+  std::size_t points = 0;
+};
+
+/**
+ * @brief Extents along the principal axes of the cloud.
+ */
+ShapeSignature computeShapeSignature(const pcl::PointCloud<pcl::PointXYZ>& cloud);
+
+/**
+ * @brief First stage of the recognition cascade, ranks the models by how well their signature matches a cluster
+ * so that only the best few go through local feature recognition.
+ */
+class CoarseFilter
+{
+public:
+  /**
+   * @param top_k         Number of models kept per cluster, 0 keeps them all
+   * @param min_extent    Extents are clamped to this length (m), keeps the thin axis of flat parts from dominating
+   */
+  explicit CoarseFilter(std::size_t top_k = 0, float min_extent = 0.01f);
+
+  void addModel(const pcl::PointCloud<pcl::PointXYZ>& model);
+
+  /**
+   * @brief Ids of the top_k models closest to the cluster, in increasing id order.
+   */
+  std::vector<int> select(const pcl::PointCloud<pcl::PointXYZ>& cluster) const;
+
+  /**
+   * @brief Sum of the absolute log ratios of the extents and point counts, 0 for identical signatures.
+   */
+  float distance(const ShapeSignature& a, const ShapeSignature& b) const;
+
+  std::size_t size() const
+  {
+    return signatures_.size();
+  }
+
+private:
+  std::size_t top_k_;
+  float min_extent_;
+  std::vector<ShapeSignature> signatures_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_COARSE_FILTER_H
@@ -0,0 +1,94 @@
+#ifndef GILBRETH_PERCEPTION_COMPRESSED_DESCRIPTOR_INDEX_H
+#define GILBRETH_PERCEPTION_COMPRESSED_DESCRIPTOR_INDEX_H
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <pcl/correspondence.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Drop-in alternative to DescriptorIndex that matches compressed SHOT descriptors. A PCA projection learned
+ * from the model descriptors reduces them to a few dimensions, which are quantized to int8 with one common step so
+ * that integer squared distances stay proportional to the float ones. Matching is an exhaustive scan with the widest
+ * int8 distance kernel the cpu supports (AVX-512, AVX2 or scalar).
+ *
+ * The projected distance never exceeds the full one, so the same threshold keeps every match of the uncompressed
+ * index up to the quantization error, along with some extra ones.
+ */
+class CompressedDescriptorIndex
+{
+public:
+  typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+  typedef std::int32_t (*DistanceKernel)(const std::int8_t* a, const std::int8_t* b, int size);
+
+  CompressedDescriptorIndex();
+
+  /**
+   * @brief Learns the projection and encodes the model descriptors, the position of each cloud in the list is
+   * used as its model id.
+   * @param dimensions  Number of principal components kept
+   * @return false when there are fewer finite descriptors than dimensions
+   */
+  bool build(const std::vector<DescriptorCloud::Ptr>& model_descriptors, int dimensions);
+
+  /**
+   * @brief Same contract as DescriptorIndex::match, distances are the dequantized squared distances.
+   */
+  void match(const DescriptorCloud& scene_descriptors, float max_sqr_distance, const std::vector<int>& models,
+             std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const;
+
+  std::size_t getModelCount() const
+  {
+    return model_count_;
+  }
+
+  std::size_t size() const
+  {
+    return model_ids_.size();
+  }
+
+  int getDimensions() const
+  {
+    return dimensions_;
+  }
+
+  /**
+   * @brief Bytes used by the encoded model descriptors
+   */
+  std::size_t getCodeBytes() const
+  {
+    return codes_.size();
+  }
+
+  const char* getKernelName() const
+  {
+    return kernel_name_;
+  }
+
+private:
+  void encode(const pcl::SHOT352& descriptor, std::int8_t* code) const;
+
+  Eigen::MatrixXf projection_;      /** @brief dimensions x 352, rows are the principal directions */
+  Eigen::VectorXf mean_;
+  float step_;                      /** @brief quantization step of every projected coordinate */
+  int dimensions_;
+  int stride_;                      /** @brief code length padded to the kernel width */
+  std::vector<std::int8_t> codes_;
+  std::size_t model_count_;
+  std::vector<int> model_ids_;      /** @brief model of each encoded descriptor */
+  std::vector<int> model_indices_;  /** @brief index of each encoded descriptor within its model */
+  DistanceKernel kernel_;
+  const char* kernel_name_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_COMPRESSED_DESCRIPTOR_INDEX_H
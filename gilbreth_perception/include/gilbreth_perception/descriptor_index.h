@@ -0,0 +1,63 @@
+#ifndef GILBRETH_PERCEPTION_DESCRIPTOR_INDEX_H
+#define GILBRETH_PERCEPTION_DESCRIPTOR_INDEX_H
+
+#include <pcl/correspondence.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Single search index over the SHOT descriptors of every model. Each stacked descriptor is labeled
+ * with the model it came from so that one query per scene descriptor yields the matches of all models.
+ */
+class DescriptorIndex
+{
+public:
+  typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+
+  DescriptorIndex();
+
+  /**
+   * @brief Builds the index, the position of each cloud in the list is used as its model id.
+   */
+  void build(const std::vector<DescriptorCloud::Ptr>& model_descriptors);
+
+  /**
+   * @brief Finds, for every given model, the closest model descriptor of each scene descriptor that lies within the
+   * squared distance threshold.
+   * @param scene_descriptors   Scene keypoint descriptors, non-finite entries are skipped
+   * @param max_sqr_distance    Maximum squared descriptor distance of a correspondence
+   * @param models              Ids of the models to match, the lists of the other models are left empty
+   * @param model_scene_corrs   One list per model, index_query is the model keypoint and index_match the scene
+   *                            keypoint
+   */
+  void match(const DescriptorCloud& scene_descriptors, float max_sqr_distance, const std::vector<int>& models,
+             std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const;
+
+  std::size_t getModelCount() const
+  {
+    return model_count_;
+  }
+
+  std::size_t size() const
+  {
+    return model_ids_.size();
+  }
+
+private:
+  pcl::KdTreeFLANN<pcl::SHOT352> tree_;
+  std::size_t model_count_;
+  std::vector<int> model_ids_;      /** @brief model of each stacked descriptor */
+  std::vector<int> model_indices_;  /** @brief index of each stacked descriptor within its model */
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_DESCRIPTOR_INDEX_H
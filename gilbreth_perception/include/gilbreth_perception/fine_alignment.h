@@ -0,0 +1,116 @@
+#ifndef GILBRETH_PERCEPTION_FINE_ALIGNMENT_H
+#define GILBRETH_PERCEPTION_FINE_ALIGNMENT_H
+
+#include "gilbreth_perception/voxel_pyramid.h"
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/kdtree.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct FineAlignmentParameters
+{
+  int max_iterations = 30;                    /** @brief per pyramid level */
+  float max_correspondence_distance = 0.02f;  /** @brief pairs further apart (m) are not used, doubled per coarser level */
+  float trim_ratio = 0.9f;                    /** @brief fraction of the closest pairs kept in each iteration */
+  float translation_epsilon = 1e-4f;          /** @brief converged once the update is below this translation (m) */
+  float rotation_epsilon = 1e-3f;             /** @brief and below this rotation (rad) */
+  float relative_residual_epsilon = 1e-3f;    /** @brief or once the mean squared residual changes less than this ratio */
+  int normal_k_neighbors = 10;                /** @brief neighbors used to estimate the model normals */
+  int pyramid_levels = 1;                     /** @brief resolution levels, 1 only aligns at the model resolution */
+  float leaf_size = 0.01f;                    /** @brief leaf size of the finest level, see buildPyramid */
+};
+
+struct FineAlignmentResult
+{
+  Eigen::Matrix4f transformation;   /** @brief model to scene */
+  float fitness_score;              /** @brief mean squared point distance of the kept pairs */
+  int iterations;                   /** @brief over all the levels */
+  bool converged;                   /** @brief at the finest level */
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * @brief Point-to-plane icp refining a model to scene pose. The scene is registered onto the model, so that the
+ * model normals and search tree are computed once in addModel() and shared by every call, and the result is
+ * inverted. Each iteration keeps the trim_ratio closest pairs and stops as soon as the pose or the residual stop
+ * changing. With several pyramid levels the pose is first aligned on the coarsest clouds and promoted level by
+ * level, so that most iterations touch a fraction of the points. refine() is const and can be called concurrently.
+ */
+class FineAlignment
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  explicit FineAlignment(const FineAlignmentParameters& params = FineAlignmentParameters());
+
+  /**
+   * @brief Precomputes the pyramid of the model and the normals and search tree of each level, returns its id.
+   */
+  std::size_t addModel(const Cloud::ConstPtr& model);
+
+  std::size_t size() const
+  {
+    return models_.size();
+  }
+
+  /**
+   * @param scene   Scene pyramid built with the leaf size of the parameters, levels beyond those of the model are
+   *                not used
+   * @param guess   Initial model to scene transformation
+   * @param max_iterations  Iterations per level for this call, 0 uses the parameters
+   * @param finest_level    Last level aligned, see finestLevel() for a scene coarser than the leaf size
+   * @return false when there are too few pairs to constrain the pose, result then holds the guess
+   */
+  bool refine(std::size_t model_id, const CloudPyramid& scene, const Eigen::Matrix4f& guess,
+              FineAlignmentResult& result, int max_iterations = 0, int finest_level = 0) const;
+
+  /**
+   * @brief Builds the scene pyramid and refines on it.
+   */
+  bool refine(std::size_t model_id, const Cloud::ConstPtr& scene, const Eigen::Matrix4f& guess,
+              FineAlignmentResult& result, int max_iterations = 0, int finest_level = 0) const;
+
+  /**
+   * @brief Fraction of the finite scene points lying within max_distance of the model placed at model_to_scene,
+   * measured against the finest model level. Used to verify a recognition hypothesis before it is refined.
+   * @param min_ratio   When positive the scene points are visited in a scattered order and the count stops as soon
+   *                    as a SequentialInlierTest rejects this ratio, the result is then an estimate below it
+   */
+  float inlierRatio(std::size_t model_id, const Cloud& scene, const Eigen::Matrix4f& model_to_scene,
+                    float max_distance, float min_ratio = 0.0f) const;
+
+  const FineAlignmentParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Level
+  {
+    Cloud::ConstPtr cloud;
+    pcl::PointCloud<pcl::Normal>::Ptr normals;
+    pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+  };
+
+  typedef std::vector<Level> Model;   /** @brief finest level first */
+
+  /**
+   * @brief Iterates on one level, updates the scene to model transformation and returns whether it converged.
+   */
+  bool refineLevel(const Level& model, const Cloud& scene, float max_correspondence_distance, int max_iterations,
+                   Eigen::Matrix4f& scene_to_model, FineAlignmentResult& result) const;
+
+  FineAlignmentParameters params_;
+  std::vector<Model> models_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_FINE_ALIGNMENT_H
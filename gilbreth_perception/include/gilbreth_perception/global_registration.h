@@ -0,0 +1,120 @@
+#ifndef GILBRETH_PERCEPTION_GLOBAL_REGISTRATION_H
+#define GILBRETH_PERCEPTION_GLOBAL_REGISTRATION_H
+
+#include <Eigen/Core>
+#include <pcl/correspondence.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/search.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct GlobalRegistrationParameters
+{
+  float tuple_scale = 0.9f;                   /** @brief two correspondences are consistent when their model and scene
+                                                  edge lengths are within this ratio */
+  std::size_t max_correspondences = 300;      /** @brief closest feature matches kept before the consistency test */
+  int iterations = 64;                        /** @brief graduated non-convexity iterations */
+  float division_factor = 1.4f;               /** @brief shrink factor of the robust kernel scale */
+  float max_correspondence_distance = 0.01f;  /** @brief final robust kernel scale (m) */
+};
+
+struct GlobalRegistrationResult
+{
+  Eigen::Matrix4f transformation;   /** @brief model to scene */
+  float fitness_score;              /** @brief same definition as pcl::Registration::getFitnessScore */
+  std::size_t inliers;              /** @brief correspondences left after the consistency pruning */
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * @brief Deterministic feature based registration in the spirit of Fast Global Registration (Zhou et al.). Mutual
+ * nearest FPFH matches are computed once, pruned to a set of pairwise geometrically consistent correspondences and
+ * the pose is solved by a weighted closed form alignment under a Geman-McClure kernel whose scale is annealed down
+ * to the correspondence distance. There is no random sampling, so the run time only depends on the cloud sizes.
+ * align() is const and can be called concurrently.
+ */
+class GlobalRegistration
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::PointCloud<pcl::FPFHSignature33> Features;
+  typedef pcl::search::Search<pcl::PointXYZ> Search;
+
+  /**
+   * @brief Scene side data shared by every model, see setScene()
+   */
+  struct Scene
+  {
+    Cloud::ConstPtr cloud;
+    Features::ConstPtr features;
+    pcl::KdTreeFLANN<pcl::FPFHSignature33> feature_tree;
+  };
+
+  explicit GlobalRegistration(const GlobalRegistrationParameters& params = GlobalRegistrationParameters());
+
+  /**
+   * @brief Builds the feature search tree of the model, returns its id.
+   */
+  std::size_t addModel(const Cloud::ConstPtr& cloud, const Features::ConstPtr& features);
+
+  std::size_t size() const
+  {
+    return models_.size();
+  }
+
+  /**
+   * @brief Builds the feature search tree of the scene, once per scene.
+   */
+  static void setScene(const Cloud::ConstPtr& cloud, const Features::ConstPtr& features, Scene& scene);
+
+  /**
+   * @param scene_tree  Search structure whose input cloud is the scene cloud, used for the fitness score
+   * @param max_range   Squared distance cut-off of the fitness score, as in pcl::Registration::getFitnessScore,
+   *                    0 skips the score when the hypothesis is verified by the caller
+   */
+  bool align(std::size_t model_id, const Scene& scene, const Search& scene_tree, double max_range,
+             GlobalRegistrationResult& result) const;
+
+  const GlobalRegistrationParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Model
+  {
+    Cloud::ConstPtr cloud;
+    Features::ConstPtr features;
+    pcl::KdTreeFLANN<pcl::FPFHSignature33>::Ptr feature_tree;
+  };
+
+  /**
+   * @brief Mutual nearest neighbors in feature space, index_query is the model point and index_match the scene point
+   */
+  void matchFeatures(const Model& model, const Scene& scene, pcl::Correspondences& corrs) const;
+
+  /**
+   * @brief Greedy clique of correspondences whose pairwise model and scene distances agree
+   */
+  void pruneInconsistent(const Model& model, const Scene& scene, pcl::Correspondences& corrs) const;
+
+  /**
+   * @brief Graduated non-convexity from the unweighted least squares pose, false when no weighted solve succeeded
+   */
+  bool solve(const Model& model, const Scene& scene, const pcl::Correspondences& corrs,
+             Eigen::Matrix4f& transformation) const;
+
+  GlobalRegistrationParameters params_;
+  std::vector<Model> models_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_GLOBAL_REGISTRATION_H
@@ -0,0 +1,189 @@
+#ifndef GILBRETH_PERCEPTION_HOUGH_GROUPING_H
+#define GILBRETH_PERCEPTION_HOUGH_GROUPING_H
+
+#include "gilbreth_perception/cancellation.h"
+#include "gilbreth_perception/model_cache.h"
+#include "gilbreth_perception/thread_pool.h"
+#include <Eigen/Core>
+#include <cstdint>
+#include <memory>
+#include <pcl/correspondence.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct HoughParameters
+{
+  float bin_size = 0.05f;         /** @brief side (m) of the cubic bins of the centroid votes */
+  float threshold = 1.0f;         /** @brief votes a bin needs to be a maximum, in [-1, 0) a fraction of the
+                                       highest bin as with pcl::Hough3DGrouping */
+  bool interpolation = true;      /** @brief spreads each vote over the 8 closest bins */
+  bool distance_weight = false;   /** @brief weights the votes down with the descriptor distance */
+  int ransac_iterations = 10000;  /** @brief of the rejection of the inconsistent voters of a maximum */
+};
+
+/**
+ * @brief Trained model side of the Hough voting, the vector from every model keypoint to the model centroid
+ * expressed in the local reference frame of the keypoint. Immutable once built, so a single instance serves any
+ * number of concurrent scenes.
+ */
+class HoughModel
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::PointCloud<pcl::ReferenceFrame> Frames;
+
+  /**
+   * @brief Trains the votes.
+   */
+  HoughModel(const Cloud::ConstPtr& keypoints, const Frames::ConstPtr& rf);
+
+  /**
+   * @brief Restores the votes of a previous training, isValid() is false when they do not match the keypoints.
+   */
+  HoughModel(const Cloud::ConstPtr& keypoints, const Frames::ConstPtr& rf, const HoughVotes& votes);
+
+  bool isValid() const
+  {
+    return votes_.size() == keypoints_->size() && rf_->size() == keypoints_->size();
+  }
+
+  const Cloud::ConstPtr& getKeypoints() const
+  {
+    return keypoints_;
+  }
+
+  const Frames::ConstPtr& getReferenceFrames() const
+  {
+    return rf_;
+  }
+
+  const HoughVotes& getVotes() const
+  {
+    return votes_;
+  }
+
+private:
+  Cloud::ConstPtr keypoints_;
+  Frames::ConstPtr rf_;
+  HoughVotes votes_;
+};
+
+/**
+ * @brief Sparse 3D Hough space over a grid anchored at the origin, bins only exist once voted for. Each worker
+ * fills its own accumulator without locking and the accumulators are merged at the end.
+ */
+class HoughAccumulator
+{
+public:
+  struct Maximum
+  {
+    double weight;
+    std::vector<int> voters;    /** @brief correspondence indices, increasing */
+  };
+
+  explicit HoughAccumulator(const HoughParameters& params = HoughParameters());
+
+  void vote(const Eigen::Vector3f& position, double weight, int voter);
+
+  /**
+   * @brief Adds the bins of another accumulator with the same bin size.
+   */
+  void merge(const HoughAccumulator& other);
+
+  /**
+   * @brief Bins reaching the threshold that no neighbor exceeds, by decreasing weight.
+   */
+  void findMaxima(std::vector<Maximum>& maxima) const;
+
+  std::size_t size() const
+  {
+    return bins_.size();
+  }
+
+private:
+  struct Bin
+  {
+    double weight = 0.0;
+    std::vector<int> voters;
+  };
+
+  void add(std::int64_t x, std::int64_t y, std::int64_t z, double weight, int voter);
+
+  HoughParameters params_;
+  std::unordered_map<std::int64_t, Bin> bins_;
+};
+
+/**
+ * @brief Model instances found in a scene, as pcl::Hough3DGrouping::recognize() returns them, strongest first.
+ */
+struct HoughInstances
+{
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > transformations;   /** @brief model to scene */
+  std::vector<pcl::Correspondences> clustered_corrs;
+};
+
+/**
+ * @brief Correspondence grouping of pcl::Hough3DGrouping split into stages that run on a thread pool. Every
+ * correspondence casts the centroid vote of its model keypoint, rotated into the reference frame of its scene
+ * keypoint, into a worker local accumulator. The accumulators of a model are merged, and the voters of every
+ * maximum are filtered by RANSAC into an instance. Votes, maxima and RANSAC runs of all the models are spread over
+ * all the workers, so that a single model with many correspondences uses every core. Stateless, recognize() can
+ * run concurrently on several scenes against the same models.
+ */
+class HoughGrouping
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::PointCloud<pcl::ReferenceFrame> Frames;
+
+  explicit HoughGrouping(const HoughParameters& params = HoughParameters());
+
+  /**
+   * @param models          Models to group, corrs holds their correspondences in the same order
+   * @param corrs           index_query is the model keypoint, index_match the scene keypoint
+   * @param instances       One entry per model, empty when the grouping was cancelled
+   */
+  void recognize(const std::vector<const HoughModel*>& models, const Cloud::ConstPtr& scene_keypoints,
+                 const Frames& scene_rf, const std::vector<pcl::CorrespondencesConstPtr>& corrs, ThreadPool& pool,
+                 const CancellationToken& cancellation, std::vector<HoughInstances>& instances) const;
+
+  /**
+   * @brief Single model on the calling thread.
+   */
+  void recognize(const HoughModel& model, const Cloud::ConstPtr& scene_keypoints, const Frames& scene_rf,
+                 const pcl::Correspondences& corrs, HoughInstances& instances) const;
+
+  const HoughParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  /**
+   * @brief Votes of the correspondences [begin, end).
+   */
+  void vote(const HoughModel& model, const Cloud& scene_keypoints, const Frames& scene_rf,
+            const pcl::Correspondences& corrs, std::size_t begin, std::size_t end, float max_distance,
+            HoughAccumulator& accumulator) const;
+
+  /**
+   * @brief Keeps the voters of a maximum consistent with a rigid transformation.
+   */
+  void cluster(const HoughModel& model, const Cloud::ConstPtr& scene_keypoints, const pcl::Correspondences& corrs,
+               const HoughAccumulator::Maximum& maximum, Eigen::Matrix4f& transformation,
+               pcl::Correspondences& clustered) const;
+
+  HoughParameters params_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_HOUGH_GROUPING_H
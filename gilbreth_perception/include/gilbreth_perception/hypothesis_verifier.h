@@ -0,0 +1,124 @@
+#ifndef GILBRETH_PERCEPTION_HYPOTHESIS_VERIFIER_H
+#define GILBRETH_PERCEPTION_HYPOTHESIS_VERIFIER_H
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/search.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct VerificationParameters
+{
+  float max_sqr_distance = 1e-4f;     /** @brief a point is an inlier within this squared distance of the scene */
+  float decision_threshold = 100.0f;  /** @brief likelihood ratio rejecting a hypothesis, a good one is rejected
+                                           with a probability of at most its inverse */
+  float bad_inlier_ratio = 0.5f;      /** @brief inlier ratio of a bad hypothesis, relative to the target ratio */
+  unsigned int seed = 42;             /** @brief of the order in which the model points are checked */
+};
+
+/**
+ * @brief Wald's sequential probability ratio test between a hypothesis reaching the target inlier ratio and a bad
+ * one reaching bad_inlier_ratio times the target, fed one point at a time in a random order. Every inlier lowers
+ * the likelihood ratio of the bad hypothesis and every outlier raises it, the test rejects as soon as it exceeds the
+ * decision threshold, usually after a few dozen points for a clearly wrong pose.
+ */
+class SequentialInlierTest
+{
+public:
+  /**
+   * @param target_ratio  Inlier ratio a good hypothesis is expected to reach, 0 never rejects
+   */
+  SequentialInlierTest(float target_ratio, const VerificationParameters& params):
+    log_ratio_(0.0),
+    log_threshold_(std::log(std::max(1.0, static_cast<double>(params.decision_threshold)))),
+    enabled_(target_ratio > 0.0f)
+  {
+    const double good = std::min(0.999, static_cast<double>(target_ratio));
+    const double bad = std::max(1e-3, std::min(good * params.bad_inlier_ratio, good - 1e-3));
+    log_inlier_ = std::log(bad / good);
+    log_outlier_ = std::log((1.0 - bad) / (1.0 - good));
+  }
+
+  /**
+   * @return false once the hypothesis is rejected
+   */
+  bool add(bool inlier)
+  {
+    if(!enabled_)
+    {
+      return true;
+    }
+    log_ratio_ += inlier ? log_inlier_ : log_outlier_;
+    return log_ratio_ <= log_threshold_;
+  }
+
+private:
+  double log_ratio_;      /** @brief log likelihood ratio of the bad over the good hypothesis */
+  double log_threshold_;
+  double log_inlier_;
+  double log_outlier_;
+  bool enabled_;
+};
+
+struct VerificationResult
+{
+  float inlier_ratio;       /** @brief over the evaluated points */
+  float fitness_score;      /** @brief mean squared distance of the inliers, as pcl::Registration::getFitnessScore */
+  std::size_t evaluated;    /** @brief model points checked before the decision */
+  bool rejected;            /** @brief stopped early, the ratio is then only an estimate */
+};
+
+/**
+ * @brief Scores model to scene hypotheses by the fraction of model points landing within max_sqr_distance of the
+ * scene. The points of every model are shuffled once in addModel(), so that any prefix is a random subset, and
+ * verify() stops with a SequentialInlierTest as soon as the hypothesis is unlikely to reach the target ratio.
+ * Only the surviving hypotheses pay for the complete pass. verify() is const and can be called concurrently.
+ */
+class HypothesisVerifier
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::search::Search<pcl::PointXYZ> Search;
+
+  explicit HypothesisVerifier(const VerificationParameters& params = VerificationParameters());
+
+  /**
+   * @brief Keeps the finite points of the model in a random order, returns its id.
+   */
+  std::size_t addModel(const Cloud& model);
+
+  std::size_t size() const
+  {
+    return models_.size();
+  }
+
+  /**
+   * @param scene_tree      Search structure whose input cloud is the scene
+   * @param model_to_scene  Hypothesis
+   * @param target_ratio    Inlier ratio to reach, typically the best one verified so far, 0 scores every point
+   * @return false when the hypothesis was rejected or the model has no points
+   */
+  bool verify(std::size_t model_id, const Search& scene_tree, const Eigen::Matrix4f& model_to_scene,
+              float target_ratio, VerificationResult& result) const;
+
+  const VerificationParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  VerificationParameters params_;
+  std::vector<std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > > models_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_HYPOTHESIS_VERIFIER_H
@@ -0,0 +1,139 @@
+#ifndef GILBRETH_PERCEPTION_KEYPOINT_DETECTOR_H
+#define GILBRETH_PERCEPTION_KEYPOINT_DETECTOR_H
+
+#include <memory>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/search.h>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct KeypointParameters
+{
+  std::string method = "uniform";   /** @brief uniform, iss or harris */
+  float spacing = 0.01f;            /** @brief uniform sampling leaf, minimum distance between salient keypoints */
+  float salient_radius = 0.03f;     /** @brief neighborhood of the saliency measure */
+  int min_neighbors = 5;            /** @brief points with fewer neighbors are never keypoints */
+  float gamma_21 = 0.975f;          /** @brief iss, upper bound of the ratio of the second to the first eigenvalue */
+  float gamma_32 = 0.975f;          /** @brief iss, upper bound of the ratio of the third to the second eigenvalue */
+  float harris_k = 0.04f;           /** @brief harris, weight of the squared trace in the response */
+};
+
+/**
+ * @brief Keypoint stage shared by the models and the scenes. Every call takes a budget, so that the number of
+ * descriptors, reference frames and correspondences per cloud is bounded whatever the size of the part.
+ */
+class KeypointDetector
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::PointCloud<pcl::Normal> Normals;
+  typedef pcl::search::Search<pcl::PointXYZ> Search;
+
+  explicit KeypointDetector(const KeypointParameters& params):
+    params_(params)
+  {
+  }
+
+  virtual ~KeypointDetector()
+  {
+  }
+
+  /**
+   * @param normals   Normals of the cloud, only used by the detectors that need them
+   * @param search    Search structure whose input cloud is the cloud
+   * @param budget    Maximum number of keypoints, 0 is unbounded
+   */
+  virtual void detect(const Cloud::ConstPtr& cloud, const Normals& normals, const Search& search, std::size_t budget,
+                      Cloud& keypoints) const = 0;
+
+  const KeypointParameters& getParameters() const
+  {
+    return params_;
+  }
+
+protected:
+  KeypointParameters params_;
+};
+
+/**
+ * @brief Voxel grid sampling at the spacing, the budget keeps evenly spread samples.
+ */
+class UniformKeypointDetector final : public KeypointDetector
+{
+public:
+  explicit UniformKeypointDetector(const KeypointParameters& params):
+    KeypointDetector(params)
+  {
+  }
+
+  void detect(const Cloud::ConstPtr& cloud, const Normals& normals, const Search& search, std::size_t budget,
+              Cloud& keypoints) const override;
+};
+
+/**
+ * @brief Keeps the most salient points first, each accepted keypoint suppressing the candidates closer than the
+ * spacing, until the budget is reached. Derived defines the saliency through
+ * bool saliency(const Cloud&, const Normals&, const std::vector<int>& neighbors, float& value) const, false when the
+ * point is not a candidate. It is resolved at compile time, so the per point measure inlines into the search loop.
+ */
+template <typename Derived>
+class SalientKeypointDetector : public KeypointDetector
+{
+public:
+  explicit SalientKeypointDetector(const KeypointParameters& params):
+    KeypointDetector(params)
+  {
+  }
+
+  void detect(const Cloud::ConstPtr& cloud, const Normals& normals, const Search& search, std::size_t budget,
+              Cloud& keypoints) const override;
+};
+
+/**
+ * @brief Intrinsic shape signature saliency, the smallest eigenvalue of the neighborhood scatter matrix of the
+ * points whose eigenvalues are well separated, so flat and linear regions are skipped.
+ */
+class IssKeypointDetector final : public SalientKeypointDetector<IssKeypointDetector>
+{
+public:
+  explicit IssKeypointDetector(const KeypointParameters& params):
+    SalientKeypointDetector<IssKeypointDetector>(params)
+  {
+  }
+
+  bool saliency(const Cloud& cloud, const Normals& normals, const std::vector<int>& neighbors, float& value) const;
+};
+
+/**
+ * @brief Harris 3D response on the covariance of the normals of the neighborhood, high on corners. Every point with
+ * enough finite normals is a candidate, ranked by the response.
+ */
+class HarrisKeypointDetector final : public SalientKeypointDetector<HarrisKeypointDetector>
+{
+public:
+  explicit HarrisKeypointDetector(const KeypointParameters& params):
+    SalientKeypointDetector<HarrisKeypointDetector>(params)
+  {
+  }
+
+  bool saliency(const Cloud& cloud, const Normals& normals, const std::vector<int>& neighbors, float& value) const;
+};
+
+extern template class SalientKeypointDetector<IssKeypointDetector>;
+extern template class SalientKeypointDetector<HarrisKeypointDetector>;
+
+/**
+ * @brief Detector of the method of the parameters, empty for an unknown method.
+ */
+std::unique_ptr<KeypointDetector> createKeypointDetector(const KeypointParameters& params);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_KEYPOINT_DETECTOR_H
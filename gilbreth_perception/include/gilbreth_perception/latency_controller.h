@@ -0,0 +1,109 @@
+#ifndef GILBRETH_PERCEPTION_LATENCY_CONTROLLER_H
+#define GILBRETH_PERCEPTION_LATENCY_CONTROLLER_H
+
+#include "gilbreth_perception/stage_timer.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct LatencyControllerParameters
+{
+  double target_latency = 0.0;  /** @brief seconds per cloud including the wait in the queue, 0 disables */
+  double gain = 0.3;            /** @brief level change for a latency twice the target */
+  double headroom = 0.8;        /** @brief fraction of the target below which the resolution is restored */
+  double smoothing = 0.3;       /** @brief weight of the newest cloud in the average latency */
+};
+
+/**
+ * @brief Nominal values of the knobs and how far the controller may degrade them. A knob whose range is empty is
+ * left at its nominal value.
+ */
+struct OperatingRange
+{
+  float leaf_size = 0.0f;           /** @brief nominal voxel leaf of the incoming clouds, 0 keeps every point */
+  float max_leaf_size = 0.0f;
+  int keypoint_budget = 0;          /** @brief nominal scene keypoint budget, 0 is unbounded and never degraded */
+  int min_keypoint_budget = 0;
+  int icp_iterations = 30;          /** @brief nominal fine alignment iterations per level */
+  int min_icp_iterations = 30;
+};
+
+struct OperatingPoint
+{
+  float leaf_size;
+  int keypoint_budget;
+  int icp_iterations;
+  double predicted_latency;   /** @brief seconds, as of the last update */
+  std::size_t queue_depth;    /** @brief as of the last update */
+};
+
+/**
+ * @brief Feedback controller trading resolution for latency between clouds. Each knob has a degradation level in
+ * [0, 1] mapped linearly onto its range. After every cloud the latency a new cloud can expect, the smoothed
+ * processing time scaled by the clouds queued per worker, is compared with the target. Above it the levels rise in
+ * proportion to the relative error, split over the knobs by the time their stages took on that cloud, so the
+ * stages that dominate are cheapened first. Below headroom times the target every level falls back toward the
+ * nominal point. Thread-safe.
+ */
+class LatencyController
+{
+public:
+  enum Knob
+  {
+    RESOLUTION = 0,   /** @brief leaf size, drives every stage that scales with the points */
+    KEYPOINTS,        /** @brief keypoint budget, drives the descriptors and the matching */
+    ITERATIONS,       /** @brief icp iteration cap */
+    KNOB_COUNT
+  };
+
+  LatencyController(const LatencyControllerParameters& params, const OperatingRange& range);
+
+  /**
+   * @brief Charges the time of a stage to a knob, unassigned stages are charged to RESOLUTION.
+   */
+  void assignStage(const std::string& stage, Knob knob);
+
+  OperatingPoint getOperatingPoint() const;
+
+  /**
+   * @param stages        Stages of the cloud just processed
+   * @param latency       Seconds spent on the cloud
+   * @param queue_depth   Clouds waiting to be processed
+   * @param workers       Threads taking clouds from the queue
+   */
+  void update(const std::vector<StageTimer::Stage>& stages, double latency, std::size_t queue_depth,
+              std::size_t workers);
+
+  bool isEnabled() const
+  {
+    return params_.target_latency > 0.0;
+  }
+
+  const LatencyControllerParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  bool isAdjustable(Knob knob) const;
+
+  const LatencyControllerParameters params_;
+  const OperatingRange range_;
+  mutable std::mutex mutex_;
+  std::map<std::string, Knob> stage_knobs_;
+  double levels_[KNOB_COUNT];
+  double smoothed_latency_;
+  double predicted_latency_;
+  std::size_t queue_depth_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_LATENCY_CONTROLLER_H
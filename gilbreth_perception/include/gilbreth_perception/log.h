@@ -0,0 +1,61 @@
+#ifndef GILBRETH_PERCEPTION_LOG_H
+#define GILBRETH_PERCEPTION_LOG_H
+
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+enum class LogLevel
+{
+  DEBUG,
+  INFO,
+  WARN,
+  ERROR
+};
+
+typedef std::function<void(LogLevel, const std::string&)> LogSink;
+
+/**
+ * @brief Destination of the messages of the perception core, the nodes forward them to rosconsole. An empty sink
+ * restores the default, which writes the warnings and errors to stderr. Not meant to change while logging.
+ */
+void setLogSink(const LogSink& sink);
+
+void log(LogLevel level, const std::string& message);
+
+} // namespace perception
+} // namespace gilbreth
+
+#define GILBRETH_LOG_STREAM(level, args) \
+  do \
+  { \
+    std::ostringstream gilbreth_log_stream; \
+    gilbreth_log_stream << args; \
+    ::gilbreth::perception::log(level, gilbreth_log_stream.str()); \
+  } while(0)
+
+#define GILBRETH_LOG_STREAM_COND(cond, level, args) \
+  do \
+  { \
+    if(cond) \
+    { \
+      GILBRETH_LOG_STREAM(level, args); \
+    } \
+  } while(0)
+
+#define GILBRETH_INFO_STREAM(args) GILBRETH_LOG_STREAM(::gilbreth::perception::LogLevel::INFO, args)
+#define GILBRETH_WARN_STREAM(args) GILBRETH_LOG_STREAM(::gilbreth::perception::LogLevel::WARN, args)
+#define GILBRETH_ERROR_STREAM(args) GILBRETH_LOG_STREAM(::gilbreth::perception::LogLevel::ERROR, args)
+#define GILBRETH_INFO_STREAM_COND(cond, args) \
+  GILBRETH_LOG_STREAM_COND(cond, ::gilbreth::perception::LogLevel::INFO, args)
+#define GILBRETH_WARN_STREAM_COND(cond, args) \
+  GILBRETH_LOG_STREAM_COND(cond, ::gilbreth::perception::LogLevel::WARN, args)
+#define GILBRETH_ERROR_STREAM_COND(cond, args) \
+  GILBRETH_LOG_STREAM_COND(cond, ::gilbreth::perception::LogLevel::ERROR, args)
+
+#endif // GILBRETH_PERCEPTION_LOG_H
@@ -0,0 +1,75 @@
+#ifndef GILBRETH_PERCEPTION_MODEL_CACHE_H
+#define GILBRETH_PERCEPTION_MODEL_CACHE_H
+
+#include <cstdint>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+static const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+/** @brief Vectors from each model keypoint to the model centroid in the keypoint reference frame, see HoughModel */
+typedef std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > HoughVotes;
+
+/**
+ * @brief All the preprocessed data of a single model, unused members (e.g. FPFH features in correspondence
+ * grouping mode) are left empty.
+ */
+struct CachedModel
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud;                  /** @brief downsampled model cloud */
+  pcl::PointCloud<pcl::PointXYZ>::Ptr keypoints;
+  pcl::PointCloud<pcl::SHOT352>::Ptr descriptors;
+  pcl::PointCloud<pcl::ReferenceFrame>::Ptr rf;
+  std::vector<pcl::PointCloud<pcl::FPFHSignature33>::Ptr> features;   /** @brief per pyramid level, finest first */
+  HoughVotes hough_votes;
+};
+
+/**
+ * @brief FNV-1a hash of a block of bytes, pass a previous result as the seed in order to chain several blocks.
+ */
+std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed = FNV_OFFSET_BASIS);
+
+std::uint64_t hashString(const std::string& str, std::uint64_t seed = FNV_OFFSET_BASIS);
+
+/**
+ * @brief Chains the contents of a file into the hash, returns false when the file can not be read.
+ */
+bool hashFile(const std::string& file_path, std::uint64_t& hash);
+
+/**
+ * @brief Versioned binary file holding the preprocessed recognition models. The file is memory mapped on load
+ * and is only accepted when its key matches the one computed from the current model list, point cloud files
+ * and recognition parameters.
+ */
+class ModelCache
+{
+public:
+  explicit ModelCache(const std::string& file_path);
+
+  bool load(std::uint64_t key, std::vector<CachedModel>& models) const;
+
+  /**
+   * @brief Writes to a temporary file first and renames it so that readers never see a partial cache.
+   */
+  bool save(std::uint64_t key, const std::vector<CachedModel>& models) const;
+
+  const std::string& getFilePath() const
+  {
+    return file_path_;
+  }
+
+private:
+  std::string file_path_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_MODEL_CACHE_H
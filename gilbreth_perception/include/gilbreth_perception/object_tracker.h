@@ -0,0 +1,111 @@
+#ifndef GILBRETH_PERCEPTION_OBJECT_TRACKER_H
+#define GILBRETH_PERCEPTION_OBJECT_TRACKER_H
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <mutex>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct TrackingParameters
+{
+  Eigen::Vector3f belt_velocity = -Eigen::Vector3f::UnitY(); /** @brief m/s in the sensor frame */
+  float max_centroid_distance = 0.03f;  /** @brief (m) between the predicted and the observed centroid */
+  float max_extent_difference = 0.02f;  /** @brief (m) per axis of the bounding boxes, larger when partly seen */
+  double max_age = 5.0;                 /** @brief (s) without an observation before a track is dropped */
+};
+
+struct TrackPrediction
+{
+  int track_id;
+  std::string name;             /** @brief of the recognized model */
+  Eigen::Matrix4f pose;         /** @brief model to sensor, moved along the belt to the time of the cluster */
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+struct TrackerStats
+{
+  std::uint64_t matched = 0;      /** @brief clusters matched to a single track */
+  std::uint64_t ambiguous = 0;    /** @brief clusters matching several tracks */
+  std::uint64_t unmatched = 0;    /** @brief clusters matching no track */
+};
+
+/**
+ * @brief Recognized objects moving with the belt. A track holds the pose, the centroid and the bounding box of its
+ * last observation, and predicts them at a later time by a translation along the belt velocity. A cluster matches
+ * a track when its centroid lies within max_centroid_distance of the prediction and its bounding box has the same
+ * extents, a track matches at most one cluster per stamp. Thread-safe.
+ */
+class ObjectTracker
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  explicit ObjectTracker(const TrackingParameters& params = TrackingParameters());
+
+  /**
+   * @brief Predicts the track of the cluster at its stamp and claims it for that stamp. Also drops the tracks
+   * older than max_age.
+   * @return false when no track or more than one track matches
+   */
+  bool match(const Cloud& cluster, double stamp, TrackPrediction& prediction);
+
+  /**
+   * @brief Records an observation of a track, or starts a new track when the id is negative or dropped.
+   * @param pose    Model to sensor at the stamp
+   * @return id of the track
+   */
+  int update(int track_id, const std::string& name, const Cloud& cluster, double stamp, const Eigen::Matrix4f& pose);
+
+  /**
+   * @brief Forgets a track whose prediction did not fit its cluster.
+   */
+  void drop(int track_id);
+
+  void clear();
+
+  std::size_t size() const;
+
+  TrackerStats getStats() const;
+
+  const TrackingParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Track
+  {
+    int id;
+    std::string name;
+    Eigen::Matrix4f pose;
+    Eigen::Vector3f centroid;
+    Eigen::Vector3f extent;
+    double stamp;
+    double claimed_stamp;   /** @brief of the last cluster matched, before its observation is recorded */
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /**
+   * @return false when the cluster has no finite point
+   */
+  static bool describe(const Cloud& cluster, Eigen::Vector3f& centroid, Eigen::Vector3f& extent);
+
+  const TrackingParameters params_;
+  mutable std::mutex mutex_;
+  std::vector<Track, Eigen::aligned_allocator<Track> > tracks_;
+  int next_id_;
+  TrackerStats stats_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_OBJECT_TRACKER_H
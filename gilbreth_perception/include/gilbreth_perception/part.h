@@ -0,0 +1,57 @@
+#ifndef GILBRETH_PERCEPTION_PART_H
+#define GILBRETH_PERCEPTION_PART_H
+
+#include "gilbreth_perception/symmetry.h"
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Part of the catalogue, one entry of the part_list in model_list.yaml.
+ */
+struct PartDescription
+{
+  std::string name;
+  std::string path;                 /** @brief of the model cloud */
+  std::string entry;                /** @brief serialized description, identical for an unchanged part */
+  Symmetry symmetry;
+  std::vector<double> pick_pose;    /** @brief x, y, z, roll, pitch and yaw in the model frame */
+};
+
+/**
+ * @brief Part found in a cloud and the pick point of its pose, both in the frame of the cloud.
+ */
+struct Detection
+{
+  std::string name;
+  int model_id = -1;
+  float fitness_score = 0.0f;
+  float inlier_ratio = -1.0f;       /** @brief registration, race and tracking only */
+  Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+  int track_id = -1;                /** @brief tracker entry the pose was predicted from, -1 for a recognized cloud */
+  Eigen::Vector3f pick_position = Eigen::Vector3f::Zero();
+  Eigen::Vector3f pick_orientation = Eigen::Vector3f::Zero();   /** @brief roll, pitch and yaw */
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * @brief Loads the model cloud of a part, downsampled to leaf_size unless it is 0.
+ */
+bool loadPartCloud(const std::string& path, float leaf_size, pcl::PointCloud<pcl::PointXYZ>::Ptr& cloud);
+
+/**
+ * @brief Moves the pick point of the part to the detected pose. False when the pick pose does not have 6 values.
+ */
+bool setPickPoint(const PartDescription& part, Detection& detection);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_PART_H
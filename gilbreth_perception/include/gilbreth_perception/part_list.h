@@ -0,0 +1,31 @@
+#ifndef GILBRETH_PERCEPTION_PART_LIST_H
+#define GILBRETH_PERCEPTION_PART_LIST_H
+
+#include "gilbreth_perception/part.h"
+#include "gilbreth_perception/symmetry.h"
+#include <string>
+#include <vector>
+#include <XmlRpcValue.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Reads an optional "symmetry" entry of a part in model_list.yaml, parts without one are not symmetric.
+ * Throws XmlRpc::XmlRpcException on malformed entries.
+ */
+bool loadSymmetry(XmlRpc::XmlRpcValue& part, Symmetry& symmetry);
+
+/**
+ * @brief Reads the part_list of model_list.yaml, the model paths are relative to package_path. False on an invalid
+ * symmetry entry, throws XmlRpc::XmlRpcException on malformed entries.
+ */
+bool loadPartList(XmlRpc::XmlRpcValue& part_list, const std::string& package_path,
+                  std::vector<PartDescription>& parts);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_PART_LIST_H
@@ -0,0 +1,105 @@
+#ifndef GILBRETH_PERCEPTION_PLANAR_RECOGNIZER_H
+#define GILBRETH_PERCEPTION_PLANAR_RECOGNIZER_H
+
+#include "gilbreth_perception/symmetry.h"
+#include <Eigen/Geometry>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/kdtree.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct PlanarParameters
+{
+  Eigen::Vector3f plane_normal = Eigen::Vector3f::UnitZ();  /** @brief belt normal in the sensor frame */
+  int yaw_steps = 36;                                       /** @brief yaw hypotheses over a full turn */
+  int max_iterations = 20;                                  /** @brief planar icp iteration cap */
+  float max_correspondence_distance = 0.02f;
+  float transformation_epsilon = 1e-4f;                     /** @brief stop once the yaw (rad) and translation (m) updates are smaller */
+};
+
+struct PlanarResult
+{
+  Eigen::Matrix4f transformation;   /** @brief model to scene */
+  float score;                      /** @brief symmetric truncated mean squared distance, lower is better */
+  int iterations;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * @brief Pose search for parts resting flat on the conveyor. The model and scene are assumed to differ only by a
+ * translation and a rotation about the belt normal, so the search sweeps the yaw with the centroids aligned and
+ * then refines x, y and yaw with an icp restricted to that subspace. The height along the normal is taken from the
+ * centroids and never changes. Parts whose symmetry axis is the belt normal only sweep one symmetry period.
+ * All the methods taking a model id are const and can be called concurrently.
+ */
+class PlanarRecognizer
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+  typedef pcl::search::Search<pcl::PointXYZ> Search;
+
+  explicit PlanarRecognizer(const PlanarParameters& params = PlanarParameters());
+
+  /**
+   * @brief Precomputes the centroid and search tree of the model, returns its id.
+   * @param symmetry  Symmetry of the model with its center set, the resulting poses are canonicalized with it
+   */
+  std::size_t addModel(const Cloud::ConstPtr& model, const Symmetry& symmetry = Symmetry());
+
+  std::size_t size() const
+  {
+    return models_.size();
+  }
+
+  /**
+   * @brief Yaw sweep followed by the planar icp.
+   * @param model_id    Id returned by addModel
+   * @param scene_tree  Search structure whose input cloud is the scene cluster
+   */
+  bool recognize(std::size_t model_id, const Search& scene_tree, PlanarResult& result) const;
+
+  /**
+   * @brief Planar icp only, starting from an initial model to scene transformation.
+   */
+  bool refine(std::size_t model_id, const Search& scene_tree, const Eigen::Matrix4f& guess, PlanarResult& result) const;
+
+  const PlanarParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Model
+  {
+    Cloud::ConstPtr cloud;
+    pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+    Eigen::Vector3f centroid;
+    std::size_t stride;                 /** @brief point stride used during the yaw sweep */
+    Symmetry symmetry;
+    float yaw_range;                    /** @brief yaw interval holding one pose of each equivalence class */
+  };
+
+  /**
+   * @brief Mean of the squared nearest neighbor distances of the transformed source points into the target,
+   * each distance truncated at the maximum correspondence distance.
+   */
+  float truncatedDistance(const Cloud& source, const Eigen::Affine3f& pose, const Search& target_tree,
+                          std::size_t stride) const;
+
+  float score(const Model& model, const Search& scene_tree, const Eigen::Affine3f& pose) const;
+
+  PlanarParameters params_;
+  Eigen::Vector3f e1_;    /** @brief in-plane basis, (e1, e2, normal) is right handed */
+  Eigen::Vector3f e2_;
+  std::vector<Model> models_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_PLANAR_RECOGNIZER_H
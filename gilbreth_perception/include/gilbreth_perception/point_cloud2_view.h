@@ -0,0 +1,30 @@
+#ifndef GILBRETH_PERCEPTION_POINT_CLOUD2_VIEW_H
+#define GILBRETH_PERCEPTION_POINT_CLOUD2_VIEW_H
+
+#include "gilbreth_perception/point_cloud_view.h"
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <sensor_msgs/PointCloud2.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Checks the field layout of the message once, float32 x, y and z fields in host byte order within the
+ * point step and a buffer holding every row, and views its buffer in place. The message has to outlive the view.
+ * False with the error logged for any other layout.
+ */
+bool makeXyzView(const sensor_msgs::PointCloud2& msg, XyzView& view);
+
+/**
+ * @brief Copies the finite points of the message into a cloud through the view, in place of pcl::fromROSMsg for
+ * the algorithms that need a PCL cloud.
+ */
+bool copyToCloud(const sensor_msgs::PointCloud2& msg, pcl::PointCloud<pcl::PointXYZ>& cloud);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_POINT_CLOUD2_VIEW_H
@@ -0,0 +1,117 @@
+#ifndef GILBRETH_PERCEPTION_POINT_CLOUD_VIEW_H
+#define GILBRETH_PERCEPTION_POINT_CLOUD_VIEW_H
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <cstring>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Read-only strided view of the x, y and z coordinates of a packed point buffer, e.g. the data of a
+ * sensor_msgs::PointCloud2 or of a pcl::PointCloud<pcl::PointXYZ>. Each of the height rows holds width points of
+ * point_step bytes, with the coordinates stored as native float32 at their offsets. The view does not own the
+ * buffer, which has to outlive it. Points may be NaN unless the source is dense.
+ */
+class XyzView
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  XyzView() = default;
+
+  /**
+   * @brief Layout of the buffer, checked by the producer of the view, see makeXyzView() for ROS messages.
+   */
+  XyzView(const std::uint8_t* data, std::size_t width, std::size_t height, std::size_t point_step,
+          std::size_t row_step, std::uint32_t x_offset, std::uint32_t y_offset, std::uint32_t z_offset,
+          bool is_dense);
+
+  /**
+   * @brief View of a PCL cloud, valid until its points are modified.
+   */
+  static XyzView fromCloud(const Cloud& cloud);
+
+  std::size_t size() const
+  {
+    return width_ * height_;
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  std::size_t getWidth() const
+  {
+    return width_;
+  }
+
+  std::size_t getHeight() const
+  {
+    return height_;
+  }
+
+  bool isDense() const
+  {
+    return is_dense_;
+  }
+
+  /**
+   * @brief First byte of a row, the points follow every point_step bytes.
+   */
+  const std::uint8_t* row(std::size_t r) const
+  {
+    return data_ + r * row_step_;
+  }
+
+  /**
+   * @brief Coordinates of the point in column c of a row returned by row().
+   */
+  Eigen::Vector3f point(const std::uint8_t* row, std::size_t c) const
+  {
+    const std::uint8_t* p = row + c * point_step_;
+    Eigen::Vector3f xyz;
+    // the buffer carries no alignment guarantee, memcpy compiles to plain loads
+    std::memcpy(&xyz[0], p + x_offset_, sizeof(float));
+    std::memcpy(&xyz[1], p + y_offset_, sizeof(float));
+    std::memcpy(&xyz[2], p + z_offset_, sizeof(float));
+    return xyz;
+  }
+
+  Eigen::Vector3f point(std::size_t i) const
+  {
+    return point(row(i / width_), i % width_);
+  }
+
+  /**
+   * @brief Copies the finite points into an unorganized cloud, for the algorithms that need a PCL cloud.
+   */
+  void copyTo(Cloud& cloud) const;
+
+  /**
+   * @brief Copies the points inside the axis aligned box, bounds included, in a single pass over the buffer.
+   */
+  void cropTo(const Eigen::Vector3f& min, const Eigen::Vector3f& max, Cloud& cloud) const;
+
+private:
+  const std::uint8_t* data_ = nullptr;
+  std::size_t width_ = 0;
+  std::size_t height_ = 0;
+  std::size_t point_step_ = 0;
+  std::size_t row_step_ = 0;
+  std::uint32_t x_offset_ = 0;
+  std::uint32_t y_offset_ = 4;
+  std::uint32_t z_offset_ = 8;
+  bool is_dense_ = true;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_POINT_CLOUD_VIEW_H
@@ -0,0 +1,192 @@
+#ifndef GILBRETH_PERCEPTION_RECOGNITION_PIPELINE_H
+#define GILBRETH_PERCEPTION_RECOGNITION_PIPELINE_H
+
+#include "gilbreth_perception/cancellation.h"
+#include "gilbreth_perception/keypoint_detector.h"
+#include "gilbreth_perception/spatial_index.h"
+#include "gilbreth_perception/stage_timer.h"
+#include <memory>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/search.h>
+#include <type_traits>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct PipelineParameters
+{
+  int normal_k_neighbors = 10;      /** @brief of the scene normals and of the grouping model normals */
+  float descriptor_radius = 0.02f;  /** @brief of the grouping descriptors and reference frames */
+  float feature_radius = 0.02f;     /** @brief of the registration features and of their model normals */
+  bool uniform_grid = true;         /** @brief serves the scene radius searches from a grid sized to the radius */
+  KeypointParameters keypoints;
+};
+
+/**
+ * @brief SHOT descriptor policy of the correspondence grouping.
+ */
+struct ShotDescriptor
+{
+  typedef pcl::SHOT352 Descriptor;
+
+  /**
+   * @param search    Radius search over the surface, empty lets pcl build a kd-tree
+   */
+  template <typename PointT>
+  static void compute(const typename pcl::PointCloud<PointT>::ConstPtr& keypoints,
+                      const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+                      const typename pcl::PointCloud<PointT>::ConstPtr& surface,
+                      const typename pcl::search::Search<PointT>::Ptr& search, float radius,
+                      pcl::PointCloud<Descriptor>& descriptors);
+};
+
+/**
+ * @brief FPFH feature policy of the global registration, one feature per point of the cloud.
+ */
+struct FpfhRegistration
+{
+  typedef pcl::FPFHSignature33 Feature;
+
+  template <typename PointT>
+  static void compute(const typename pcl::PointCloud<PointT>::ConstPtr& cloud,
+                      const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+                      const typename pcl::search::Search<PointT>::Ptr& search, float radius,
+                      pcl::PointCloud<Feature>& features);
+};
+
+/**
+ * @brief Keypoints of a cloud with their descriptors and BOARD reference frames, the input of the Hough grouping.
+ */
+template <typename PointT, typename Descriptor>
+struct DescribedCloud
+{
+  typename pcl::PointCloud<PointT>::Ptr keypoints;
+  typename pcl::PointCloud<Descriptor>::Ptr descriptors;
+  pcl::PointCloud<pcl::ReferenceFrame>::Ptr rf;
+};
+
+/**
+ * @brief Per point stages of the recognition, the same for the models and the scenes so that both sides are always
+ * described alike. The configuration is chosen once when the node starts, every stage below runs in a
+ * SpecializedRecognitionPipeline compiled for its point type and policies.
+ */
+template <typename PointT, typename Descriptor, typename Feature>
+class RecognitionPipeline
+{
+public:
+  typedef pcl::PointCloud<PointT> Cloud;
+  typedef pcl::PointCloud<Feature> Features;
+  typedef DescribedCloud<PointT, Descriptor> Described;
+  typedef SceneIndex<PointT> Index;
+
+  explicit RecognitionPipeline(const PipelineParameters& params):
+    params_(params)
+  {
+  }
+
+  virtual ~RecognitionPipeline()
+  {
+  }
+
+  /**
+   * @brief Grouping side of a model.
+   * @param keypoint_budget   0 is unbounded
+   */
+  virtual void describeModel(const typename Cloud::ConstPtr& model, std::size_t keypoint_budget,
+                             Described& described) const = 0;
+
+  /**
+   * @brief Grouping side of a scene, timed as the normals, keypoints, descriptors and reference_frames stages.
+   * @param index   Set to the scene, with a grid at the descriptor radius
+   * @return false when cancelled
+   */
+  virtual bool describeScene(const typename Cloud::ConstPtr& scene, std::size_t keypoint_budget, Index& index,
+                             StageTimer& timer, const CancellationToken& cancellation, Described& described) const = 0;
+
+  /**
+   * @brief Registration side of a model.
+   * @param level   Pyramid level of the cloud, the feature radius is scaled with its leaf size by 2^level
+   */
+  virtual void computeModelFeatures(const typename Cloud::ConstPtr& model, int level, Features& features) const = 0;
+
+  /**
+   * @brief Registration side of a scene, timed as the registration_normals and features stages.
+   * @param level   Pyramid level of the cloud, as for the models
+   * @param index   Set to the scene, with a grid at the feature radius
+   * @return false when cancelled
+   */
+  virtual bool computeSceneFeatures(const typename Cloud::ConstPtr& scene, int level, Index& index, StageTimer& timer,
+                                    const CancellationToken& cancellation, Features& features) const = 0;
+
+  const PipelineParameters& getParameters() const
+  {
+    return params_;
+  }
+
+protected:
+  PipelineParameters params_;
+};
+
+/**
+ * @brief Pipeline of one configuration. The keypoint detector is held by its final type and the descriptor and
+ * registration policies are static, so nothing below the entry points dispatches at runtime. Only the explicit
+ * instantiations of recognition_pipeline.cpp exist, a new point type or policy needs its own.
+ */
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+class SpecializedRecognitionPipeline final :
+    public RecognitionPipeline<PointT, typename DescriptorPolicy::Descriptor, typename RegistrationPolicy::Feature>
+{
+public:
+  typedef RecognitionPipeline<PointT, typename DescriptorPolicy::Descriptor, typename RegistrationPolicy::Feature> Base;
+  typedef typename Base::Cloud Cloud;
+  typedef typename Base::Features Features;
+  typedef typename Base::Described Described;
+  typedef typename Base::Index Index;
+
+  static_assert(std::is_same<typename KeypointPolicy::Cloud::PointType, PointT>::value,
+                "the keypoint detector works on another point type");
+
+  explicit SpecializedRecognitionPipeline(const PipelineParameters& params);
+
+  void describeModel(const typename Cloud::ConstPtr& model, std::size_t keypoint_budget,
+                     Described& described) const override;
+
+  bool describeScene(const typename Cloud::ConstPtr& scene, std::size_t keypoint_budget, Index& index,
+                     StageTimer& timer, const CancellationToken& cancellation, Described& described) const override;
+
+  void computeModelFeatures(const typename Cloud::ConstPtr& model, int level, Features& features) const override;
+
+  bool computeSceneFeatures(const typename Cloud::ConstPtr& scene, int level, Index& index, StageTimer& timer,
+                            const CancellationToken& cancellation, Features& features) const override;
+
+private:
+  /**
+   * @brief Descriptors and reference frames of the keypoints over the surface.
+   */
+  void describe(const typename Cloud::ConstPtr& surface, const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+                const typename pcl::search::Search<PointT>::Ptr& search, Described& described) const;
+
+  const KeypointPolicy keypoint_detector_;
+};
+
+typedef RecognitionPipeline<pcl::PointXYZ, pcl::SHOT352, pcl::FPFHSignature33> XyzRecognitionPipeline;
+
+extern template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, UniformKeypointDetector,
+                                                     FpfhRegistration>;
+extern template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, IssKeypointDetector,
+                                                     FpfhRegistration>;
+extern template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, HarrisKeypointDetector,
+                                                     FpfhRegistration>;
+
+/**
+ * @brief Pipeline of the keypoint method of the parameters, empty for an unknown method.
+ */
+std::unique_ptr<XyzRecognitionPipeline> createRecognitionPipeline(const PipelineParameters& params);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_RECOGNITION_PIPELINE_H
@@ -0,0 +1,212 @@
+#ifndef GILBRETH_PERCEPTION_RECOGNIZER_H
+#define GILBRETH_PERCEPTION_RECOGNIZER_H
+
+#include "gilbreth_perception/cancellation.h"
+#include "gilbreth_perception/fine_alignment.h"
+#include "gilbreth_perception/global_registration.h"
+#include "gilbreth_perception/hough_grouping.h"
+#include "gilbreth_perception/hypothesis_verifier.h"
+#include "gilbreth_perception/keypoint_detector.h"
+#include "gilbreth_perception/latency_controller.h"
+#include "gilbreth_perception/object_tracker.h"
+#include "gilbreth_perception/part.h"
+#include "gilbreth_perception/planar_recognizer.h"
+#include "gilbreth_perception/recognition_pipeline.h"
+#include "gilbreth_perception/stage_timer.h"
+#include "gilbreth_perception/thread_pool.h"
+#include "gilbreth_perception/vocabulary_tree.h"
+#include "gilbreth_perception/voxel_pyramid.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Everything the recognition of a cluster depends on, see the recognition block of config/parameters.yaml.
+ * The defaults are the values shipped there.
+ */
+struct RecognizerParameters
+{
+  float down_sample = 0.01f;                  /** @brief leaf size of the models and of the incoming clusters */
+  bool icp = false;                           /** @brief registration instead of the correspondence grouping */
+  bool planar = false;                        /** @brief x, y and yaw search instead of either of the above */
+  bool race = false;                          /** @brief registration and grouping concurrently */
+  bool print_detailed_info = true;
+  int threads = 0;                            /** @brief model evaluation workers, 0 uses one per core */
+
+  // correspondence grouping
+  float descr_rad_cg = 0.1f;
+  float descr_dis_thrd = 0.2f;
+  HoughParameters hough_params;               /** @brief the bin size also merges the poses of symmetric parts */
+  KeypointParameters keypoint_params;
+  int keypoint_scene_budget = 0;              /** @brief nominal, 0 is unbounded */
+  int keypoint_model_budget = 0;
+  int k_nearest_neighbors = 10;
+  std::string descriptor_matching = "flann";  /** @brief flann, pca_int8, binary or vocabulary */
+  int descriptor_pca_dimensions = 48;
+  int max_hamming_distance = 80;
+  VocabularyParameters vocabulary_params;
+  int vocabulary_shortlist = 10;
+
+  // registration
+  float descr_rad_icp = 0.0f;
+  float min_sample_distance = 0.05f;
+  float max_correspondence_distance = 0.01f;
+  int nr_iterations = 100;
+  std::string registration_method = "sac_ia"; /** @brief sac_ia or fgr */
+  GlobalRegistrationParameters global_registration_params;
+  VerificationParameters verification_params; /** @brief inlier distance from verification_inlier_distance */
+  float verification_inlier_distance = 0.01f; /** @brief (m) */
+
+  // race
+  float race_min_inlier_ratio = 0.6f;
+  float race_inlier_distance = 0.01f;
+
+  // symmetry, prefilter and search structures
+  float symmetry_merge_angle = 0.35f;
+  int symmetry_continuous_divisor = 8;
+  float symmetry_stop_inlier_ratio = 0.7f; /** @brief SAC-IA of a symmetric part stops at this ratio, 0 disables */
+  int prefilter_top_k = 0;
+  bool uniform_grid = true;
+
+  // planar search and fine alignment
+  PlanarParameters planar_params;
+  int iterations = 100;                       /** @brief nominal fine alignment iterations per level */
+  int pyramid_levels = 3;
+  FineAlignmentParameters fine_alignment_params;   /** @brief iterations, levels, leaf and neighbors from above */
+
+  // tracking
+  bool tracking = false;
+  TrackingParameters tracking_params;
+  float tracking_min_inlier_ratio = 0.6f;
+  float tracking_inlier_distance = 0.01f;
+
+  // model cache, empty disables
+  std::string model_cache_file;
+  std::uint64_t cache_seed = 0;               /** @brief hash of the configuration the cached models depend on */
+};
+
+/**
+ * @brief Recognition of the part in a segmented cluster and of its pose, by the planar search, the registration,
+ * the correspondence grouping or a race of the latter two, followed by the fine alignment. The models live in a
+ * catalogue that recognition reads through an immutable snapshot, updates build a new one next to it and swap the
+ * pointer so that the clusters in flight finish on the models they started with. recognize() may be called
+ * concurrently.
+ */
+class Recognizer
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  /**
+   * @brief Receives the detection of a cluster as soon as it is final, a race publishes before the losing strategy
+   * has stopped.
+   */
+  typedef std::function<void(const Detection&)> DetectionCallback;
+
+  /**
+   * @brief Validates the parameters and starts the workers, empty with the error logged for invalid parameters.
+   */
+  static std::unique_ptr<Recognizer> create(const RecognizerParameters& params);
+
+  ~Recognizer();
+
+  Recognizer(const Recognizer&) = delete;
+  Recognizer& operator=(const Recognizer&) = delete;
+
+  /**
+   * @brief Prepares the first catalogue, from the model cache of the last run when it holds the same models.
+   */
+  bool loadCatalogue(const std::vector<PartDescription>& parts);
+
+  /**
+   * @brief Prepares a catalogue of the parts next to the current one, reusing the data of the unchanged parts, and
+   * swaps it in. The current catalogue is kept when a part can not be prepared. Updates are not meant to run
+   * concurrently with each other, only with recognize().
+   */
+  bool updateCatalogue(const std::vector<PartDescription>& parts);
+
+  std::size_t getModelCount() const;
+
+  /**
+   * @brief Leaf size, scene keypoint budget and fine alignment iterations of the configuration.
+   */
+  OperatingPoint getNominalOperatingPoint() const;
+
+  /**
+   * @brief Recognizes the part of a cluster at the down_sample resolution, coarsened to the operating point first.
+   * The detection goes to the callback, the stages are recorded in the timer.
+   * @param stamp   Seconds, moves the tracked objects along the belt
+   * @return false when nothing was recognized
+   */
+  bool recognize(const Cloud::ConstPtr& cluster, double stamp, const OperatingPoint& operating_point,
+                 StageTimer& timer, const DetectionCallback& on_detection);
+
+  const RecognizerParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Catalogue;
+  typedef std::vector<Detection, Eigen::aligned_allocator<Detection> > Detections;
+
+  Recognizer(const RecognizerParameters& params, std::unique_ptr<const XyzRecognitionPipeline> pipeline);
+
+  bool useRegistration() const;
+  bool useGrouping() const;
+
+  bool loadModels(const std::vector<PartDescription>& parts, const Catalogue* previous, Catalogue& catalogue);
+  bool computeCacheKey(const std::vector<PartDescription>& parts, std::uint64_t& key) const;
+  bool loadModelCache(std::uint64_t key, Catalogue& catalogue) const;
+  void saveModelCache(std::uint64_t key, const Catalogue& catalogue) const;
+  CloudPyramid modelPyramid(const Cloud::Ptr& model) const;
+  void prepareModel(const Cloud::Ptr& model, Catalogue& catalogue) const;
+  void reuseModel(const Catalogue& previous, std::size_t previous_id, Catalogue& catalogue) const;
+  void loadICPConfig(std::size_t model_id, Catalogue& catalogue) const;
+  void loadCGConfig(std::size_t model_id, Catalogue& catalogue) const;
+  void buildCatalogueIndexes(Catalogue& catalogue) const;
+  void buildDescriptorIndex(Catalogue& catalogue) const;
+
+  bool predictFromTrack(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                        StageTimer& timer, Detection& result);
+  int sacIaIterations(const Catalogue& catalogue, std::size_t model_id) const;
+  int selectBestFitness(const Catalogue& catalogue, const Detections& results,
+                        const std::vector<int>& candidates) const;
+  int selectBestVerified(const Catalogue& catalogue, const Detections& results,
+                         const std::vector<int>& candidates) const;
+  bool raceStrategies(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                      const std::vector<int>& candidates, const OperatingPoint& operating_point, StageTimer& timer,
+                      const DetectionCallback& on_detection);
+  bool recognizePlanar(const Catalogue& catalogue, const Cloud::ConstPtr& scene, const std::vector<int>& candidates,
+                       StageTimer& timer, Detection& result);
+  bool recognizeByRegistration(const Catalogue& catalogue, const CloudPyramid& scene_pyramid,
+                               const std::vector<int>& candidates, ThreadPool& pool,
+                               const CancellationToken& cancellation, StageTimer& timer, Detection& result);
+  bool recognizeByGrouping(const Catalogue& catalogue, const CloudPyramid& scene_pyramid,
+                           const std::vector<int>& candidates, const OperatingPoint& operating_point,
+                           const CancellationToken& cancellation, StageTimer& timer, Detection& result);
+  void finishDetection(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                       Detection result, const OperatingPoint& operating_point, StageTimer& timer,
+                       const DetectionCallback& on_detection);
+
+  const RecognizerParameters params_;
+  const std::unique_ptr<const XyzRecognitionPipeline> recognition_pipeline_;
+  std::shared_ptr<const Catalogue> catalogue_;   /** read and replaced with std::atomic_load and std::atomic_store */
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::unique_ptr<ThreadPool> race_pool_;        /** registration workers when racing */
+  std::unique_ptr<ObjectTracker> tracker_;       /** only when tracking the non planar methods */
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_RECOGNIZER_H
@@ -0,0 +1,17 @@
+#ifndef GILBRETH_PERCEPTION_ROS_LOG_H
+#define GILBRETH_PERCEPTION_ROS_LOG_H
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Routes the messages of the perception core to rosconsole, under the name of the calling node.
+ */
+void forwardLogToRos();
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_ROS_LOG_H
@@ -0,0 +1,64 @@
+#ifndef GILBRETH_PERCEPTION_SEGMENTATION_H
+#define GILBRETH_PERCEPTION_SEGMENTATION_H
+
+#include "gilbreth_perception/point_cloud_view.h"
+#include "gilbreth_perception/stage_timer.h"
+#include <Eigen/Core>
+#include <pcl/PCLHeader.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct SegmentationParameters
+{
+  float down_sample = 0.01f;
+  Eigen::Vector3f roi_min = Eigen::Vector3f(-0.22543f, -0.2874f, 0.0f);   /** @brief camera frame region of interest */
+  Eigen::Vector3f roi_max = Eigen::Vector3f(0.192618f, 0.283763f, 0.7162f);
+  int min_cluster_size = 100;
+  int max_cluster_size = 50000;
+  float cluster_tolerance = 0.1f;
+  bool print_detailed_info = true;
+};
+
+/**
+ * @brief Splits a camera frame into the clusters of the parts on the belt: region of interest, voxel grid and
+ * euclidean clustering, timed as the passthrough, downsample and clustering stages.
+ */
+class Segmenter
+{
+public:
+  typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+  explicit Segmenter(const SegmentationParameters& params);
+
+  /**
+   * @brief The clusters carry the header of the scene.
+   * @return false when no point lies in the region of interest or no cluster was found
+   */
+  bool segment(const Cloud::ConstPtr& scene, StageTimer& timer, std::vector<Cloud::Ptr>& clusters) const;
+
+  /**
+   * @brief Segments a frame read in place, e.g. the buffer of a sensor_msgs::PointCloud2, only the points in the
+   * region of interest are copied. The view has no header, the clusters carry the one of the frame.
+   */
+  bool segment(const XyzView& scene, const pcl::PCLHeader& header, StageTimer& timer,
+               std::vector<Cloud::Ptr>& clusters) const;
+
+  const SegmentationParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  SegmentationParameters params_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_SEGMENTATION_H
@@ -0,0 +1,325 @@
+#ifndef GILBRETH_PERCEPTION_SPATIAL_INDEX_H
+#define GILBRETH_PERCEPTION_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <Eigen/Core>
+#include <limits>
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/search/search.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Spatial hash of the points into cubic cells. Radius searches only visit the cells overlapping the query
+ * ball, so with a cell size close to the search radius a query touches 27 cells and no tree is traversed. K nearest
+ * searches grow a shell of cells around the query until the k-th neighbor is provably found.
+ */
+template <typename PointT>
+class UniformGridSearch : public pcl::search::Search<PointT>
+{
+public:
+  typedef boost::shared_ptr<UniformGridSearch<PointT> > Ptr;
+  typedef typename pcl::search::Search<PointT>::PointCloudConstPtr PointCloudConstPtr;
+  typedef typename pcl::search::Search<PointT>::IndicesConstPtr IndicesConstPtr;
+  using pcl::search::Search<PointT>::nearestKSearch;
+  using pcl::search::Search<PointT>::radiusSearch;
+
+  explicit UniformGridSearch(float cell_size, bool sorted = true):
+    pcl::search::Search<PointT>("UniformGridSearch", sorted),
+    cell_size_(cell_size),
+    inv_cell_size_(1.0f / cell_size)
+  {
+  }
+
+  void setInputCloud(const PointCloudConstPtr& cloud, const IndicesConstPtr& indices = IndicesConstPtr()) override
+  {
+    this->input_ = cloud;
+    this->indices_ = indices;
+    build();
+  }
+
+  int nearestKSearch(const PointT& point, int k, std::vector<int>& k_indices,
+                     std::vector<float>& k_sqr_distances) const override
+  {
+    k_indices.clear();
+    k_sqr_distances.clear();
+    if(k <= 0 || cells_.empty())
+    {
+      return 0;
+    }
+
+    // max-heap of the k best candidates
+    std::vector<std::pair<float, int> > best;
+    const Eigen::Vector3i center = cellOf(point.x, point.y, point.z);
+    const int max_ring = (center - min_cell_).cwiseAbs().cwiseMax((max_cell_ - center).cwiseAbs()).maxCoeff();
+    for(int ring = 0; ring <= max_ring; ring++)
+    {
+      for(int dx = -ring; dx <= ring; dx++)
+      {
+        for(int dy = -ring; dy <= ring; dy++)
+        {
+          for(int dz = -ring; dz <= ring; dz++)
+          {
+            if(std::max(std::abs(dx), std::max(std::abs(dy), std::abs(dz))) != ring)
+            {
+              continue;   // interior, visited by a previous ring
+            }
+
+            visitCell(center + Eigen::Vector3i(dx, dy, dz), [&](int index, float sqr_distance)
+            {
+              if(best.size() < static_cast<std::size_t>(k))
+              {
+                best.push_back(std::make_pair(sqr_distance, index));
+                std::push_heap(best.begin(), best.end());
+              }
+              else if(sqr_distance < best.front().first)
+              {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = std::make_pair(sqr_distance, index);
+                std::push_heap(best.begin(), best.end());
+              }
+            }, point);
+          }
+        }
+      }
+
+      // points outside of the visited cells are at least ring cells away from the query
+      const float reach = ring * cell_size_;
+      if(best.size() == static_cast<std::size_t>(k) && best.front().first <= reach * reach)
+      {
+        break;
+      }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    for(const std::pair<float, int>& b : best)
+    {
+      k_indices.push_back(b.second);
+      k_sqr_distances.push_back(b.first);
+    }
+    return static_cast<int>(k_indices.size());
+  }
+
+  int radiusSearch(const PointT& point, double radius, std::vector<int>& k_indices,
+                   std::vector<float>& k_sqr_distances, unsigned int max_nn = 0) const override
+  {
+    k_indices.clear();
+    k_sqr_distances.clear();
+    if(cells_.empty())
+    {
+      return 0;
+    }
+
+    const float r = static_cast<float>(radius);
+    const float sqr_radius = r * r;
+    const Eigen::Vector3i lo = cellOf(point.x - r, point.y - r, point.z - r).cwiseMax(min_cell_);
+    const Eigen::Vector3i hi = cellOf(point.x + r, point.y + r, point.z + r).cwiseMin(max_cell_);
+    for(int x = lo.x(); x <= hi.x(); x++)
+    {
+      for(int y = lo.y(); y <= hi.y(); y++)
+      {
+        for(int z = lo.z(); z <= hi.z(); z++)
+        {
+          visitCell(Eigen::Vector3i(x, y, z), [&](int index, float sqr_distance)
+          {
+            if(sqr_distance <= sqr_radius)
+            {
+              k_indices.push_back(index);
+              k_sqr_distances.push_back(sqr_distance);
+            }
+          }, point);
+        }
+      }
+    }
+
+    const bool truncate = max_nn > 0 && k_indices.size() > max_nn;
+    if(this->sorted_results_ || truncate)
+    {
+      sortResults(k_indices, k_sqr_distances);
+    }
+    if(truncate)
+    {
+      k_indices.resize(max_nn);
+      k_sqr_distances.resize(max_nn);
+    }
+    return static_cast<int>(k_indices.size());
+  }
+
+  float getCellSize() const
+  {
+    return cell_size_;
+  }
+
+private:
+  struct Range
+  {
+    int begin;
+    int end;
+  };
+
+  Eigen::Vector3i cellOf(float x, float y, float z) const
+  {
+    return Eigen::Vector3i(static_cast<int>(std::floor(x * inv_cell_size_)),
+                           static_cast<int>(std::floor(y * inv_cell_size_)),
+                           static_cast<int>(std::floor(z * inv_cell_size_)));
+  }
+
+  static std::uint64_t keyOf(const Eigen::Vector3i& cell)
+  {
+    // 21 bits per axis, cells further apart than that only share a bucket and are still told apart by distance
+    const std::uint64_t mask = (1ULL << 21) - 1;
+    return ((static_cast<std::uint64_t>(cell.x()) & mask) << 42) |
+           ((static_cast<std::uint64_t>(cell.y()) & mask) << 21) |
+           (static_cast<std::uint64_t>(cell.z()) & mask);
+  }
+
+  template <typename Visitor>
+  void visitCell(const Eigen::Vector3i& cell, Visitor visitor, const PointT& point) const
+  {
+    typename std::unordered_map<std::uint64_t, Range>::const_iterator it = cells_.find(keyOf(cell));
+    if(it == cells_.end())
+    {
+      return;
+    }
+
+    const pcl::PointCloud<PointT>& cloud = *this->input_;
+    for(int i = it->second.begin; i < it->second.end; i++)
+    {
+      const PointT& p = cloud[cell_points_[i]];
+      const float dx = p.x - point.x;
+      const float dy = p.y - point.y;
+      const float dz = p.z - point.z;
+      visitor(cell_points_[i], dx * dx + dy * dy + dz * dz);
+    }
+  }
+
+  void build()
+  {
+    cells_.clear();
+    cell_points_.clear();
+    min_cell_ = Eigen::Vector3i::Constant(std::numeric_limits<int>::max());
+    max_cell_ = Eigen::Vector3i::Constant(std::numeric_limits<int>::min());
+
+    const pcl::PointCloud<PointT>& cloud = *this->input_;
+    std::vector<std::pair<std::uint64_t, int> > keyed;
+    keyed.reserve(this->indices_ ? this->indices_->size() : cloud.size());
+    const std::size_t count = this->indices_ ? this->indices_->size() : cloud.size();
+    for(std::size_t n = 0; n < count; n++)
+    {
+      const int i = this->indices_ ? (*this->indices_)[n] : static_cast<int>(n);
+      const PointT& p = cloud[i];
+      if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+      {
+        continue;
+      }
+      const Eigen::Vector3i cell = cellOf(p.x, p.y, p.z);
+      min_cell_ = min_cell_.cwiseMin(cell);
+      max_cell_ = max_cell_.cwiseMax(cell);
+      keyed.push_back(std::make_pair(keyOf(cell), i));
+    }
+
+    // points of a cell are stored contiguously, the map only holds the range
+    std::sort(keyed.begin(), keyed.end());
+    cell_points_.resize(keyed.size());
+    cells_.reserve(keyed.size());
+    for(std::size_t i = 0; i < keyed.size(); i++)
+    {
+      cell_points_[i] = keyed[i].second;
+      if(i == 0 || keyed[i].first != keyed[i - 1].first)
+      {
+        cells_[keyed[i].first] = Range{static_cast<int>(i), static_cast<int>(i)};
+      }
+      cells_[keyed[i].first].end = static_cast<int>(i) + 1;
+    }
+  }
+
+  static void sortResults(std::vector<int>& indices, std::vector<float>& sqr_distances)
+  {
+    std::vector<std::pair<float, int> > sorted(indices.size());
+    for(std::size_t i = 0; i < indices.size(); i++)
+    {
+      sorted[i] = std::make_pair(sqr_distances[i], indices[i]);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for(std::size_t i = 0; i < sorted.size(); i++)
+    {
+      sqr_distances[i] = sorted[i].first;
+      indices[i] = sorted[i].second;
+    }
+  }
+
+  float cell_size_;
+  float inv_cell_size_;
+  Eigen::Vector3i min_cell_;
+  Eigen::Vector3i max_cell_;
+  std::unordered_map<std::uint64_t, Range> cells_;
+  std::vector<int> cell_points_;
+};
+
+/**
+ * @brief Search structures over one scene cloud. They are built once per cloud and handed to every stage that
+ * searches the scene (normals, descriptors, reference frames, registration and fitness) instead of each stage
+ * building its own.
+ */
+template <typename PointT>
+class SceneIndex
+{
+public:
+  typedef pcl::search::Search<PointT> Search;
+  typedef pcl::search::KdTree<PointT> KdTree;
+
+  /**
+   * @param grid_cell_size  Cell size of the uniform grid serving the radius searches, usually the search radius.
+   *                        0 serves them from the kd-tree.
+   */
+  void setInputCloud(const typename pcl::PointCloud<PointT>::ConstPtr& cloud, float grid_cell_size = 0.0f)
+  {
+    kdtree_.reset(new KdTree());
+    kdtree_->setInputCloud(cloud);
+
+    grid_.reset();
+    if(grid_cell_size > 0.0f)
+    {
+      grid_.reset(new UniformGridSearch<PointT>(grid_cell_size));
+      grid_->setInputCloud(cloud);
+    }
+  }
+
+  /**
+   * @brief Used for the nearest and k nearest neighbor searches and by the pcl registration classes.
+   */
+  const typename KdTree::Ptr& getKdTree() const
+  {
+    return kdtree_;
+  }
+
+  /**
+   * @brief Used for the fixed radius searches.
+   */
+  typename Search::Ptr getRadiusSearch() const
+  {
+    if(grid_)
+    {
+      return grid_;
+    }
+    return kdtree_;
+  }
+
+private:
+  typename KdTree::Ptr kdtree_;
+  typename UniformGridSearch<PointT>::Ptr grid_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_SPATIAL_INDEX_H
@@ -0,0 +1,145 @@
+#ifndef GILBRETH_PERCEPTION_STAGE_TIMER_H
+#define GILBRETH_PERCEPTION_STAGE_TIMER_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Wall-clock durations of the stages run on one cloud, measured with the steady clock so that stages
+ * running on several threads are not over-counted as they are with std::clock(). A stage recorded several times
+ * accumulates its durations, stages keep the order in which they were first recorded. Thread-safe.
+ */
+class StageTimer
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Stage
+  {
+    std::string name;
+    double duration;    /** @brief seconds */
+  };
+
+  /**
+   * @brief Records the time spent between its construction and destruction, or stop(), under a stage.
+   */
+  class Scope
+  {
+  public:
+    Scope(StageTimer& timer, const std::string& name):
+      timer_(timer),
+      name_(name),
+      start_(Clock::now()),
+      stopped_(false)
+    {
+    }
+
+    ~Scope()
+    {
+      stop();
+    }
+
+    void stop()
+    {
+      if(!stopped_)
+      {
+        stopped_ = true;
+        timer_.add(name_, std::chrono::duration<double>(Clock::now() - start_).count());
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    StageTimer& timer_;
+    std::string name_;
+    Clock::time_point start_;
+    bool stopped_;
+  };
+
+  /**
+   * @brief The total is measured from construction.
+   */
+  StageTimer();
+
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+
+  void add(const std::string& name, double seconds);
+
+  /**
+   * @brief Seconds since construction.
+   */
+  double elapsed() const;
+
+  std::vector<Stage> getStages() const;
+
+  void setPoints(std::size_t points);
+  void setKeypoints(std::size_t keypoints);
+
+  /**
+   * @brief Name of the recognized or aligned part, left empty when the cloud failed.
+   */
+  void setResult(const std::string& result);
+
+  std::size_t getPoints() const;
+  std::size_t getKeypoints() const;
+  std::string getResult() const;
+
+private:
+  const Clock::time_point start_;
+  mutable std::mutex mutex_;
+  std::vector<Stage> stages_;
+  std::size_t points_;
+  std::size_t keypoints_;
+  std::string result_;
+};
+
+/**
+ * @brief Rolling percentiles of the stage durations over the last window clouds that ran each stage. Thread-safe.
+ */
+class LatencyStatistics
+{
+public:
+  struct Percentiles
+  {
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    std::size_t samples = 0;
+  };
+
+  explicit LatencyStatistics(std::size_t window = 200);
+
+  void add(const std::string& stage, double seconds);
+
+  /**
+   * @brief Nearest rank percentiles of the stage, all zero before its first sample.
+   */
+  Percentiles getPercentiles(const std::string& stage) const;
+
+private:
+  struct Window
+  {
+    std::vector<double> samples;
+    std::size_t next = 0;   /** @brief oldest sample once the window is full */
+  };
+
+  const std::size_t window_;
+  mutable std::mutex mutex_;
+  std::map<std::string, Window> stages_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_STAGE_TIMER_H
@@ -0,0 +1,72 @@
+#ifndef GILBRETH_PERCEPTION_SYMMETRY_H
+#define GILBRETH_PERCEPTION_SYMMETRY_H
+
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+#include <string>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Rotational symmetry of a part about an axis through its centroid, expressed in the model frame.
+ */
+struct Symmetry
+{
+  enum Type
+  {
+    NONE,
+    N_FOLD,
+    CONTINUOUS
+  };
+
+  Type type = NONE;
+  int order = 1;                                      /** @brief number of equivalent poses of an n-fold part */
+  Eigen::Vector3f axis = Eigen::Vector3f::UnitZ();
+  Eigen::Vector3f center = Eigen::Vector3f::Zero();
+
+  bool isSymmetric() const
+  {
+    return type == CONTINUOUS || (type == N_FOLD && order > 1);
+  }
+
+  /**
+   * @brief Spin about the axis between two consecutive equivalent poses, 0 for continuous symmetry
+   */
+  float period() const;
+};
+
+typedef std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > PoseList;
+
+/**
+ * @brief Sets the type and order of a symmetry from its model_list.yaml names, none, n_fold or continuous. False
+ * for an unknown type or an n-fold symmetry without a positive order.
+ */
+bool parseSymmetry(const std::string& type, int order, Symmetry& symmetry);
+
+/**
+ * @brief Picks a unique representative among the model to scene poses that only differ by a spin about the
+ * symmetry axis. The spin is removed for continuous symmetry and reduced to [-period/2, period/2] otherwise.
+ */
+Eigen::Matrix4f canonicalizePose(const Eigen::Matrix4f& model_to_scene, const Symmetry& symmetry);
+
+/**
+ * @brief True when both poses place the model center within max_translation of each other and differ by less
+ * than max_angle once the spin about the symmetry axis is discounted.
+ */
+bool equivalentPoses(const Eigen::Matrix4f& a, const Eigen::Matrix4f& b, const Symmetry& symmetry,
+                     float max_translation, float max_angle);
+
+/**
+ * @brief Labels every pose with the index of the first pose it is equivalent to.
+ */
+std::vector<int> groupEquivalentPoses(const PoseList& poses, const Symmetry& symmetry, float max_translation,
+                                      float max_angle);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_SYMMETRY_H
@@ -0,0 +1,68 @@
+#ifndef GILBRETH_PERCEPTION_THREAD_POOL_H
+#define GILBRETH_PERCEPTION_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Fixed set of worker threads that run a task over a range of items. Every item is handed the id of
+ * the worker running it so that callers can keep per-worker state (e.g. stateful pcl algorithms) without
+ * locking.
+ */
+class ThreadPool
+{
+public:
+  typedef std::function<void(std::size_t worker_id, std::size_t item)> Task;
+
+  /**
+   * @param num_threads   Number of workers, 0 uses one per hardware thread
+   */
+  explicit ThreadPool(std::size_t num_threads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t size() const
+  {
+    return workers_.size();
+  }
+
+  /**
+   * @brief Runs the task for every item in [0, count) and blocks until all of them are done. The first
+   * exception thrown by a task is rethrown here once the remaining items have finished.
+   */
+  void parallelFor(std::size_t count, const Task& task);
+
+private:
+  void workerLoop(std::size_t worker_id);
+
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;            /** @brief serializes concurrent parallelFor calls */
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  const Task* task_;
+  std::size_t count_;
+  std::size_t next_item_;
+  std::size_t pending_;
+  std::uint64_t generation_;
+  std::exception_ptr error_;
+  bool stop_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_THREAD_POOL_H
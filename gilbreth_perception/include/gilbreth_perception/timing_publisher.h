@@ -0,0 +1,61 @@
+#ifndef GILBRETH_PERCEPTION_TIMING_PUBLISHER_H
+#define GILBRETH_PERCEPTION_TIMING_PUBLISHER_H
+
+#include "gilbreth_perception/latency_controller.h"
+#include "gilbreth_perception/stage_timer.h"
+#include <ros/ros.h>
+#include <std_msgs/Header.h>
+#include <string>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Publishes a gilbreth_msgs::PipelineTiming message per processed cloud, with the durations of the stages
+ * and their rolling percentiles over the clouds published so far. Can be called from several threads.
+ */
+class TimingPublisher
+{
+public:
+  /**
+   * @param node    Name reported in the messages
+   * @param window  Clouds kept per stage for the percentiles
+   */
+  TimingPublisher(ros::NodeHandle& nh, const std::string& topic, const std::string& node, std::size_t window);
+
+  /**
+   * @brief Adds the stages of the cloud to the statistics and publishes them, the total is the time elapsed since
+   * the construction of the timer.
+   */
+  void publish(const std_msgs::Header& header, const StageTimer& timer);
+
+private:
+  ros::Publisher publisher_;
+  std::string node_;
+  LatencyStatistics statistics_;
+};
+
+/**
+ * @brief Publishes a gilbreth_msgs::OperatingPoint message with the resolution a LatencyController chose.
+ */
+class OperatingPointPublisher
+{
+public:
+  /**
+   * @param node    Name reported in the messages
+   */
+  OperatingPointPublisher(ros::NodeHandle& nh, const std::string& topic, const std::string& node);
+
+  void publish(const std_msgs::Header& header, const LatencyController& controller);
+
+private:
+  ros::Publisher publisher_;
+  std::string node_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_TIMING_PUBLISHER_H
@@ -0,0 +1,121 @@
+#ifndef GILBRETH_PERCEPTION_VOCABULARY_TREE_H
+#define GILBRETH_PERCEPTION_VOCABULARY_TREE_H
+
+#include <pcl/correspondence.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+struct VocabularyParameters
+{
+  int branching = 10;                       /** @brief children of every node */
+  int depth = 4;                            /** @brief levels below the root, up to branching^depth words */
+  int kmeans_iterations = 10;               /** @brief Lloyd iterations per node */
+  std::size_t max_training_descriptors = 50000;   /** @brief model descriptors sampled to learn the tree */
+};
+
+/**
+ * @brief Hierarchical k-means vocabulary over SHOT descriptors with an inverted file from each visual word to the
+ * models and model descriptors it contains. Quantizing a descriptor costs branching * depth distances and the
+ * voting only visits the models sharing a word with the scene, so that shortlisting candidate models stays roughly
+ * independent of the catalogue size. Models are compared by the intersection of their tf-idf weighted word
+ * histograms, words present in every model get no weight.
+ */
+class VocabularyTree
+{
+public:
+  typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+
+  explicit VocabularyTree(const VocabularyParameters& params = VocabularyParameters());
+
+  /**
+   * @brief Learns the vocabulary and fills the inverted file, the position of each cloud in the list is used as
+   * its model id.
+   * @return false when there are no finite model descriptors
+   */
+  bool build(const std::vector<DescriptorCloud::Ptr>& model_descriptors);
+
+  /**
+   * @brief Word of a descriptor, found by descending to the closest child at every level.
+   */
+  int quantize(const pcl::SHOT352& descriptor) const;
+
+  /**
+   * @brief Ids of the top_k models among the candidates whose word histograms are most similar to the scene, in
+   * increasing id order. Models sharing no weighted word with the scene are not returned.
+   */
+  std::vector<int> shortlist(const DescriptorCloud& scene_descriptors, std::size_t top_k,
+                             const std::vector<int>& candidates) const;
+
+  /**
+   * @brief Same contract as DescriptorIndex::match restricted to the given models, each scene descriptor is only
+   * compared with the model descriptors of its own word.
+   */
+  void match(const DescriptorCloud& scene_descriptors, float max_sqr_distance, const std::vector<int>& models,
+             std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const;
+
+  std::size_t getModelCount() const
+  {
+    return models_.size();
+  }
+
+  std::size_t getWordCount() const
+  {
+    return inverted_file_.size();
+  }
+
+  const VocabularyParameters& getParameters() const
+  {
+    return params_;
+  }
+
+private:
+  struct Node
+  {
+    int first_child;    /** @brief index of the first of the consecutive children, -1 for a leaf */
+    int child_count;
+    int word;           /** @brief word of a leaf, -1 otherwise */
+  };
+
+  struct Entry
+  {
+    int model;
+    int index;          /** @brief descriptor index within the model */
+  };
+
+  struct Posting
+  {
+    int model;
+    float weight;       /** @brief normalized tf-idf weight of the word in the model */
+  };
+
+  /**
+   * @brief Clusters the given training descriptors below a node, whose center is already set.
+   */
+  void split(int node, std::vector<const float*>& descriptors, int level);
+
+  const float* center(int node) const
+  {
+    return &centers_[static_cast<std::size_t>(node) * DESCRIPTOR_SIZE];
+  }
+
+  static const int DESCRIPTOR_SIZE = 352;
+
+  VocabularyParameters params_;
+  std::vector<Node> nodes_;
+  std::vector<float> centers_;                          /** @brief DESCRIPTOR_SIZE floats per node */
+  std::vector<float> idf_;                              /** @brief per word */
+  std::vector<std::vector<Posting> > inverted_file_;    /** @brief models of each word */
+  std::vector<std::vector<Entry> > word_entries_;       /** @brief model descriptors of each word */
+  std::vector<DescriptorCloud::Ptr> models_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_VOCABULARY_TREE_H
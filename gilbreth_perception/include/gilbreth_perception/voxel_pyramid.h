@@ -0,0 +1,36 @@
+#ifndef GILBRETH_PERCEPTION_VOXEL_PYRAMID_H
+#define GILBRETH_PERCEPTION_VOXEL_PYRAMID_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Clouds of decreasing resolution, the finest level first.
+ */
+typedef std::vector<pcl::PointCloud<pcl::PointXYZ>::ConstPtr> CloudPyramid;
+
+/**
+ * @brief Level 0 is the cloud itself and level k its voxelization at leaf_size * 2^k. Building stops early once a
+ * level would be left with too few points to register.
+ * @param levels  Maximum number of levels, 1 only holds the cloud
+ */
+CloudPyramid buildPyramid(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr& cloud, float leaf_size, int levels);
+
+/**
+ * @brief First level of a pyramid built at leaf_size whose leaf reaches cloud_leaf_size, the leaf the cloud was
+ * voxelized at. The finer levels only repeat the cloud at a coarser resolution than their leaf and do not match the
+ * same levels of a pyramid built from a finer cloud.
+ * @return in [0, levels - 1]
+ */
+int finestLevel(float leaf_size, float cloud_leaf_size, int levels);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_VOXEL_PYRAMID_H
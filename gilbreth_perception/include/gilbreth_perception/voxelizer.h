@@ -0,0 +1,37 @@
+#ifndef GILBRETH_PERCEPTION_VOXELIZER_H
+#define GILBRETH_PERCEPTION_VOXELIZER_H
+
+#include "gilbreth_perception/point_cloud_view.h"
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief Cubic occupancy grid of a cloud scaled so that its longest side spans the grid.
+ */
+struct OccupancyGrid
+{
+  unsigned int size = 0;        /** @brief voxels per side */
+  float voxel_size = 0.0f;      /** @brief meters */
+  std::vector<int> occupancy;   /** @brief 0 or 1 per voxel, indexed by x * size^2 + z * size + y */
+};
+
+/**
+ * @brief Voxelizes a non empty cloud into a grid of grid_size voxels per side.
+ */
+void voxelize(const pcl::PointCloud<pcl::PointXYZ>& cloud, unsigned int grid_size, OccupancyGrid& grid);
+
+/**
+ * @brief Voxelizes the finite points of a buffer read in place, at least one of them.
+ */
+void voxelize(const XyzView& cloud, unsigned int grid_size, OccupancyGrid& grid);
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_VOXELIZER_H
@@ -0,0 +1,197 @@
+#ifndef GILBRETH_PERCEPTION_WORK_QUEUE_H
+#define GILBRETH_PERCEPTION_WORK_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+/**
+ * @brief What a push does when the queue is full.
+ */
+enum class OverflowPolicy
+{
+  DROP_OLDEST,    /** @brief the oldest queued item is discarded to make room */
+  DROP_NEWEST,    /** @brief the pushed item is discarded */
+  BLOCK           /** @brief the producer waits for room */
+};
+
+/**
+ * @brief Parses "drop_oldest", "drop_newest" or "block".
+ */
+inline bool parseOverflowPolicy(const std::string& name, OverflowPolicy& policy)
+{
+  if(name == "drop_oldest")
+  {
+    policy = OverflowPolicy::DROP_OLDEST;
+  }
+  else if(name == "drop_newest")
+  {
+    policy = OverflowPolicy::DROP_NEWEST;
+  }
+  else if(name == "block")
+  {
+    policy = OverflowPolicy::BLOCK;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+struct WorkQueueStats
+{
+  std::uint64_t pushed = 0;           /** @brief items accepted */
+  std::uint64_t popped = 0;
+  std::uint64_t dropped_oldest = 0;   /** @brief queued items discarded by DROP_OLDEST */
+  std::uint64_t dropped_newest = 0;   /** @brief pushed items discarded by DROP_NEWEST or after close() */
+  std::uint64_t blocked = 0;          /** @brief pushes that had to wait under BLOCK */
+  std::size_t high_water_mark = 0;    /** @brief largest queue length seen */
+
+  std::uint64_t dropped() const
+  {
+    return dropped_oldest + dropped_newest;
+  }
+};
+
+/**
+ * @brief Bounded multi-producer multi-consumer FIFO with an explicit overflow policy and counters of what the
+ * policy did.
+ */
+template <typename T>
+class WorkQueue
+{
+public:
+  WorkQueue(std::size_t capacity, OverflowPolicy policy):
+    capacity_(capacity > 0 ? capacity : 1),
+    policy_(policy),
+    closed_(false)
+  {
+  }
+
+  WorkQueue(const WorkQueue&) = delete;
+  WorkQueue& operator=(const WorkQueue&) = delete;
+
+  /**
+   * @return false when the item was discarded, either by DROP_NEWEST or because the queue is closed
+   */
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(!closed_ && items_.size() >= capacity_)
+    {
+      switch(policy_)
+      {
+      case OverflowPolicy::DROP_OLDEST:
+        items_.pop_front();
+        stats_.dropped_oldest++;
+        break;
+      case OverflowPolicy::DROP_NEWEST:
+        stats_.dropped_newest++;
+        return false;
+      case OverflowPolicy::BLOCK:
+        stats_.blocked++;
+        not_full_.wait(lock, [this]()
+        {
+          return closed_ || items_.size() < capacity_;
+        });
+        break;
+      }
+    }
+
+    if(closed_)
+    {
+      stats_.dropped_newest++;
+      return false;
+    }
+
+    items_.push_back(std::move(item));
+    stats_.pushed++;
+    stats_.high_water_mark = std::max(stats_.high_water_mark, items_.size());
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Waits for an item, returns false once the queue is closed and drained.
+   */
+  bool pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]()
+    {
+      return closed_ || !items_.empty();
+    });
+    if(items_.empty())
+    {
+      return false;
+    }
+
+    item = std::move(items_.front());
+    items_.pop_front();
+    stats_.popped++;
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Wakes every waiting producer and consumer, later pushes are rejected and pops drain what is left.
+   */
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+  }
+
+  std::size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  OverflowPolicy policy() const
+  {
+    return policy_;
+  }
+
+  WorkQueueStats getStats() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+private:
+  const std::size_t capacity_;
+  const OverflowPolicy policy_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  WorkQueueStats stats_;
+  bool closed_;
+};
+
+} // namespace perception
+} // namespace gilbreth
+
+#endif // GILBRETH_PERCEPTION_WORK_QUEUE_H
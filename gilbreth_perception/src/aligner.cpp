@@ -0,0 +1,137 @@
+#include "gilbreth_perception/aligner.h"
+#include "gilbreth_perception/log.h"
+#include <pcl/common/centroid.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/search/kdtree.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+Aligner::Aligner(const AlignerParameters& params):
+  params_(params)
+{
+}
+
+bool Aligner::loadModels(const std::vector<PartDescription>& parts)
+{
+  GILBRETH_INFO_STREAM("Preparing Point Cloud Models");
+  std::vector<PartDescription> loaded = parts;
+  std::vector<Cloud::Ptr> models(parts.size());
+  std::vector<Eigen::Vector3f> centroids(parts.size());
+  for(std::size_t i = 0; i < parts.size(); i++)
+  {
+    if(!loadPartCloud(parts[i].path, params_.down_sample, models[i]))
+    {
+      return false;
+    }
+    Eigen::Vector4f centroid;
+    pcl::compute3DCentroid(*models[i], centroid);
+    centroids[i] = centroid.head<3>();
+  }
+
+  if(params_.planar)
+  {
+    planar_recognizer_.reset(new PlanarRecognizer(params_.planar_params));
+    for(std::size_t i = 0; i < models.size(); i++)
+    {
+      // symmetry axes pass through the model centroids
+      loaded[i].symmetry.center = centroids[i];
+      planar_recognizer_->addModel(models[i], loaded[i].symmetry);
+    }
+  }
+  else
+  {
+    // model normals and search trees are computed once for every alignment
+    fine_alignment_.reset(new FineAlignment(params_.fine_alignment_params));
+    for(const Cloud::Ptr& model : models)
+    {
+      fine_alignment_->addModel(model);
+    }
+  }
+
+  parts_.swap(loaded);
+  model_centroids_.swap(centroids);
+  return true;
+}
+
+bool Aligner::align(int model_id, const Cloud::ConstPtr& scene, const OperatingPoint& operating_point,
+                    StageTimer& timer, Detection& detection) const
+{
+  if(model_id < 0 || model_id >= static_cast<int>(parts_.size()))
+  {
+    GILBRETH_ERROR_STREAM("Alignment has no model " << model_id);
+    return false;
+  }
+
+  detection = Detection();
+  detection.name = parts_[model_id].name;
+  detection.model_id = model_id;
+
+  Cloud::ConstPtr cloud = scene;
+  if(operating_point.leaf_size > params_.down_sample)
+  {
+    StageTimer::Scope stage(timer, "downsample");
+    Cloud::Ptr coarse(new Cloud());
+    pcl::VoxelGrid<pcl::PointXYZ> sor;
+    sor.setInputCloud(scene);
+    sor.setLeafSize(operating_point.leaf_size, operating_point.leaf_size, operating_point.leaf_size);
+    sor.filter(*coarse);
+    cloud = coarse;
+  }
+
+  StageTimer::Scope alignment_stage(timer, params_.planar ? "planar" : "fine_alignment");
+  if(params_.planar)
+  {
+    // x, y and yaw search on the belt plane
+    pcl::search::KdTree<pcl::PointXYZ> tree;
+    tree.setInputCloud(cloud);
+    PlanarResult planar_result;
+    if(!planar_recognizer_->recognize(model_id, tree, planar_result))
+    {
+      GILBRETH_ERROR_STREAM("Planar alignment failed for object: " << detection.name << ".");
+      return false;
+    }
+    detection.fitness_score = planar_result.score;
+    detection.pose = planar_result.transformation;
+  }
+  else
+  {
+    // the correspondence distance of the fine alignment is bounded, the model is first moved onto the cloud
+    Eigen::Vector4f centroid;
+    if(pcl::compute3DCentroid(*cloud, centroid) == 0)
+    {
+      GILBRETH_ERROR_STREAM("Fine alignment got no finite point for object: " << detection.name << ".");
+      return false;
+    }
+    Eigen::Matrix4f guess = Eigen::Matrix4f::Identity();
+    guess.block<3, 1>(0, 3) = centroid.head<3>() - model_centroids_[model_id];
+
+    FineAlignmentResult refinement;
+    // a coarsened cloud stops on the first level whose model leaf reaches its own
+    const FineAlignmentParameters& fine_params = fine_alignment_->getParameters();
+    const int finest_level = finestLevel(fine_params.leaf_size, operating_point.leaf_size, fine_params.pyramid_levels);
+    if(!fine_alignment_->refine(model_id, cloud, guess, refinement, operating_point.icp_iterations, finest_level))
+    {
+      GILBRETH_ERROR_STREAM("Fine alignment failed for object: " << detection.name << ".");
+      return false;
+    }
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Fine alignment " <<
+                              (refinement.converged ? "converged" : "stopped") << " after " <<
+                              refinement.iterations << " iterations, with score: " << refinement.fitness_score);
+    detection.fitness_score = refinement.fitness_score;
+    detection.pose = refinement.transformation;
+  }
+  alignment_stage.stop();
+
+  if(!setPickPoint(parts_[model_id], detection))
+  {
+    GILBRETH_ERROR_STREAM("Alignment has no valid pick pose for object: " << detection.name << ".");
+    return false;
+  }
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -1,57 +1,105 @@
 #include "gilbreth_msgs/ObjectDetection.h"
 #include "gilbreth_msgs/ObjectType.h"
-#include <cstdio>
-#include <ctime>
-#include <fstream>
+#include "gilbreth_perception/aligner.h"
+#include "gilbreth_perception/latency_controller.h"
+#include "gilbreth_perception/part_list.h"
+#include "gilbreth_perception/point_cloud2_view.h"
+#include "gilbreth_perception/ros_log.h"
+#include "gilbreth_perception/stage_timer.h"
+#include "gilbreth_perception/timing_publisher.h"
+#include <algorithm>
 #include <geometry_msgs/PointStamped.h>
-#include <iostream>
-#include <pcl/ModelCoefficients.h>
-#include <pcl/common/transforms.h>
-#include <pcl/console/parse.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/filters/voxel_grid.h>
-#include <pcl/io/pcd_io.h>
-#include <pcl/kdtree/impl/kdtree_flann.hpp>
-#include <pcl/kdtree/kdtree_flann.h>
-#include <pcl/keypoints/uniform_sampling.h>
+#include <memory>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/registration/ia_ransac.h>
-#include <pcl/registration/icp.h>
-#include <pcl/sample_consensus/method_types.h>
-#include <pcl/sample_consensus/model_types.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <tf/transform_listener.h>
+#include <XmlRpcException.h>
 
 static const std::string WORLD_FRAME = "world";
 typedef pcl::PointXYZ PointType;
-typedef pcl::Normal NormalType;
 
 class AlignmentClass {
 public:
   explicit AlignmentClass(ros::NodeHandle &nh) {
     // initializing parameters
-    down_sample = 0.01;
-    print_detailed_info = false;
     iterations = 10;
+    k_nearest_neighbors = 10;
+    telemetry_window = 200;
+    max_leaf_size = 0.0;
+    min_iterations = 0;
     pub_tf = nh.advertise<gilbreth_msgs::ObjectDetection>("recognition_result_world", 10);
-    scene.reset(new pcl::PointCloud<PointType>());
     loadParameter();
+    timing_publisher.reset(new gilbreth::perception::TimingPublisher(nh, "alignment_timing", "alignment_node",
+                                                                     std::max(1, telemetry_window)));
+    // the subscriber queue is not observable, so only the processing time drives the controller
+    gilbreth::perception::OperatingRange range;
+    range.leaf_size = aligner_params.down_sample;
+    range.max_leaf_size = max_leaf_size;
+    range.icp_iterations = iterations;
+    range.min_icp_iterations = min_iterations;
+    latency_controller.reset(new gilbreth::perception::LatencyController(latency_params, range));
+    latency_controller->assignStage("fine_alignment", gilbreth::perception::LatencyController::ITERATIONS);
+    operating_point_publisher.reset(new gilbreth::perception::OperatingPointPublisher(nh, "alignment_operating_point",
+                                                                                      "alignment_node"));
     loadModel();
   }
   void loadParameter() {
-    // General parameters
-    std::map<std::string, float> parameter_map;
-    std::map<std::string, bool> switch_map;
-    ros::NodeHandle ph("~");
-    ph.getParam("parameters", parameter_map);
-    ph.getParam("switches", switch_map);
-    down_sample = parameter_map["down_sample"];
-    print_detailed_info = switch_map["print_detailed_info"];
-    iterations = parameter_map["iteration"];
+    // General parameters, shared with the recognition node
+    try
+    {
+      XmlRpc::XmlRpcValue parameter_map;
+      XmlRpc::XmlRpcValue switch_map;
+      XmlRpc::XmlRpcValue planar_map;
+      XmlRpc::XmlRpcValue fine_alignment_map;
+      XmlRpc::XmlRpcValue pyramid_map;
+      XmlRpc::XmlRpcValue telemetry_map;
+      XmlRpc::XmlRpcValue latency_map;
+      ros::NodeHandle ph("~");
+      ph.getParam("recognition", parameter_map);
+      ph.getParam("recognition/switches", switch_map);
+      ph.getParam("recognition/planar", planar_map);
+      ph.getParam("recognition/fine_alignment", fine_alignment_map);
+      ph.getParam("recognition/pyramid", pyramid_map);
+      ph.getParam("recognition/telemetry", telemetry_map);
+      ph.getParam("recognition/latency_control", latency_map);
+      aligner_params.down_sample = static_cast<double>(parameter_map["down_sample"]);
+      aligner_params.print_detailed_info = static_cast<bool>(switch_map["print_detailed_info"]);
+      iterations = static_cast<int>(parameter_map["iteration"]);
+      k_nearest_neighbors = static_cast<int>(parameter_map["k_nearest_neighbors"]);
+      aligner_params.planar = static_cast<bool>(switch_map["planar"]);
+      telemetry_window = static_cast<int>(telemetry_map["window"]);
+      latency_params.target_latency = static_cast<double>(latency_map["target_latency"]);
+      latency_params.gain = static_cast<double>(latency_map["gain"]);
+      latency_params.headroom = static_cast<double>(latency_map["headroom"]);
+      max_leaf_size = static_cast<double>(latency_map["max_leaf_size"]);
+      min_iterations = static_cast<int>(latency_map["min_iterations"]);
+      gilbreth::perception::PlanarParameters& planar_params = aligner_params.planar_params;
+      planar_params.plane_normal = Eigen::Vector3f(static_cast<double>(planar_map["plane_normal"][0]),
+                                                   static_cast<double>(planar_map["plane_normal"][1]),
+                                                   static_cast<double>(planar_map["plane_normal"][2]));
+      planar_params.yaw_steps = static_cast<int>(planar_map["yaw_steps"]);
+      planar_params.max_iterations = static_cast<int>(planar_map["iterations"]);
+      planar_params.max_correspondence_distance = static_cast<double>(planar_map["max_correspondence_distance"]);
+      planar_params.transformation_epsilon = static_cast<double>(planar_map["transformation_epsilon"]);
+      gilbreth::perception::FineAlignmentParameters& fine_alignment_params = aligner_params.fine_alignment_params;
+      fine_alignment_params.max_iterations = iterations;
+      fine_alignment_params.normal_k_neighbors = k_nearest_neighbors;
+      fine_alignment_params.pyramid_levels = static_cast<int>(pyramid_map["levels"]);
+      fine_alignment_params.leaf_size = aligner_params.down_sample;
+      fine_alignment_params.max_correspondence_distance =
+          static_cast<double>(fine_alignment_map["max_correspondence_distance"]);
+      fine_alignment_params.trim_ratio = static_cast<double>(fine_alignment_map["trim_ratio"]);
+      fine_alignment_params.translation_epsilon = static_cast<double>(fine_alignment_map["translation_epsilon"]);
+      fine_alignment_params.rotation_epsilon = static_cast<double>(fine_alignment_map["rotation_epsilon"]);
+      fine_alignment_params.relative_residual_epsilon =
+          static_cast<double>(fine_alignment_map["relative_residual_epsilon"]);
+    }
+    catch(XmlRpc::XmlRpcException& e)
+    {
+      ROS_ERROR("Alignment failed to load algorithm parameters: %s",e.getMessage().c_str());
+    }
   }
 
   void loadModel() {
@@ -63,91 +111,63 @@ public:
     ph.getParam("package_path", package_path);
 
     ROS_INFO("Loading Point Cloud Models");
-    std::vector<pcl::PointCloud<PointType>::Ptr> model_raw_list;
-    for (int i = 0; i < model_map.size(); i++) {
-      pcl::PointCloud<PointType>::Ptr model_raw(new pcl::PointCloud<PointType>());
-      std::string model_path = model_map[i]["path"];
-      if (pcl::io::loadPCDFile(package_path + model_path, *model_raw) < 0) {
-        ROS_ERROR("Error loading model cloud.");
+    std::vector<gilbreth::perception::PartDescription> parts;
+    try {
+      if (!gilbreth::perception::loadPartList(model_map, package_path, parts)) {
         return;
       }
-      model_raw_list.push_back(model_raw);
-      model_name.push_back(model_map[i]["name"]);
-      std::vector<double> pick_pose_sub;
-      double pick_pose_sub_element;
-      for (int j = 0; j < model_map[i]["pick_pose"].size(); j++) {
-        pick_pose_sub_element = model_map[i]["pick_pose"][j];
-        pick_pose_sub.push_back(pick_pose_sub_element);
-      }
-      pick_pose.push_back(pick_pose_sub);
+    } catch (XmlRpc::XmlRpcException& e) {
+      ROS_ERROR("Alignment failed to load model parameters: %s", e.getMessage().c_str());
+      return;
     }
 
-    // Downsample models
-    ROS_INFO("Preparing Point Cloud Models");
-    pcl::VoxelGrid<pcl::PointXYZ> sor;
-    for (int i = 0; i < model_raw_list.size(); i++) {
-      pcl::PointCloud<PointType>::Ptr model(new pcl::PointCloud<PointType>());
-      if (down_sample > 0) {
-        sor.setInputCloud(model_raw_list[i]);
-        sor.setLeafSize(down_sample, down_sample, down_sample);
-        sor.filter(*model);
-      } else
-        model = model_raw_list[i];
-      model_list.push_back(model);
+    aligner.reset(new gilbreth::perception::Aligner(aligner_params));
+    if (!aligner->loadModels(parts)) {
+      aligner.reset();
     }
   }
 
   void objectCallBack(const gilbreth_msgs::ObjectType::ConstPtr &object_type) {
-    std::clock_t start;
-    double duration;
-    Result result;
-    result.item_name = model_name[object_type->type];
-    result.item_id = object_type->type;
-    // Load scene
-    pcl::fromROSMsg(object_type->pcd, *scene);
-    // Use ICP to align model to scene
-    start = std::clock();
-    pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> icp;
-    icp.setMaximumIterations(iterations);
-    icp.setInputSource(model_list[result.item_id]);
-    icp.setInputTarget(scene);
-    pcl::PointCloud<pcl::PointXYZ> final;
-    icp.align(final);
-    Eigen::Matrix4f icp_transformation = icp.getFinalTransformation();
-    // Transform pick up point from model to scene
-    pcl::PointCloud<PointType>::Ptr pick_point_cloud(new pcl::PointCloud<PointType>());
-    pcl::PointCloud<PointType>::Ptr rotated_pick_point_cloud(new pcl::PointCloud<PointType>());
-    pcl::PointXYZ pick_point;
-    pick_point.x = pick_pose[result.item_id][0];
-    pick_point.y = pick_pose[result.item_id][1];
-    pick_point.z = pick_pose[result.item_id][2];
-    pick_point_cloud->push_back(pick_point);
-    pcl::transformPointCloud(*pick_point_cloud, *rotated_pick_point_cloud, icp_transformation);
-    // Generate output message
-    gilbreth_msgs::ObjectDetection data;
-    gilbreth_msgs::ObjectDetection data_tf;
+    if (!aligner) {
+      ROS_ERROR("Alignment has no models");
+      return;
+    }
+
+    gilbreth::perception::StageTimer timer;
+    const gilbreth::perception::OperatingPoint operating_point = latency_controller->getOperatingPoint();
+    pcl::PointCloud<PointType>::Ptr scene(new pcl::PointCloud<PointType>());
+    // Load scene, the coordinates of the pcd field are copied once for the alignment
+    {
+      gilbreth::perception::StageTimer::Scope stage(timer, "conversion");
+      if (!gilbreth::perception::copyToCloud(object_type->pcd, *scene)) {
+        return;
+      }
+    }
+    timer.setPoints(scene->size());
+
+    gilbreth::perception::Detection detection;
+    if (!aligner->align(object_type->type, scene, operating_point, timer, detection)) {
+      timing_publisher->publish(object_type->header, timer);
+      updateOperatingPoint(object_type->header, timer);
+      return;
+    }
+
+    // Transform pick up point from the sensor to the world frame
+    gilbreth::perception::StageTimer::Scope tf_stage(timer, "tf");
     geometry_msgs::PointStamped sensor_point;
     geometry_msgs::PointStamped world_point;
-
     tf::Quaternion q;
-    q.setEuler(pick_pose[result.item_id][4], pick_pose[result.item_id][3], pick_pose[result.item_id][5]);
-    data.name = result.item_name;
-    data.pose.position.x = rotated_pick_point_cloud->points[0].x;
-    data.pose.position.y = rotated_pick_point_cloud->points[0].y;
-    data.pose.position.z = rotated_pick_point_cloud->points[0].z;
-
-    data.pose.orientation.x = q.getX();
-    data.pose.orientation.y = q.getY();
-    data.pose.orientation.z = q.getZ();
-    data.pose.orientation.w = q.getW();
-    // Transform point to world coordination
-    sensor_point.point.x = data.pose.position.x;
-    sensor_point.point.y = data.pose.position.y;
-    sensor_point.point.z = data.pose.position.z;
+    q.setEuler(detection.pick_orientation[1], detection.pick_orientation[0], detection.pick_orientation[2]);
+    sensor_point.point.x = detection.pick_position.x();
+    sensor_point.point.y = detection.pick_position.y();
+    sensor_point.point.z = detection.pick_position.z();
     sensor_point.header.frame_id = "depth_camera_camera_link_optical";
     listener.transformPoint(WORLD_FRAME, sensor_point, world_point);
+    tf_stage.stop();
 
-    data_tf.name = data.name;
+    gilbreth::perception::StageTimer::Scope publish_stage(timer, "publish");
+    gilbreth_msgs::ObjectDetection data_tf;
+    data_tf.name = detection.name;
     data_tf.pose.position.x = world_point.point.x;
     data_tf.pose.position.y = world_point.point.y;
     data_tf.pose.position.z = world_point.point.z;
@@ -159,44 +179,42 @@ public:
     data_tf.header.stamp = ros::Time::now();
     data_tf.header.frame_id = WORLD_FRAME;
     pub_tf.publish(data_tf);
+    publish_stage.stop();
 
-    duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    ROS_INFO_STREAM("Object: " << result.item_name << ".");
-    ROS_INFO_STREAM("Alignment runtime: " << duration << " seconds.");
+    timer.setResult(detection.name);
+    ROS_INFO_STREAM("Object: " << detection.name << ".");
+    ROS_INFO_STREAM("Alignment runtime: " << timer.elapsed() << " seconds.");
+    timing_publisher->publish(object_type->header, timer);
+    updateOperatingPoint(object_type->header, timer);
   }
 
 private:
-  struct Result {
-    std::string item_name;
-    int item_id;
-  };
+  void updateOperatingPoint(const std_msgs::Header& header, const gilbreth::perception::StageTimer& timer) {
+    latency_controller->update(timer.getStages(), timer.elapsed(), 0, 1);
+    operating_point_publisher->publish(header, *latency_controller);
+  }
+
   ros::Publisher pub_tf;
-  std::vector<std::vector<double>> pick_pose;
-  std::vector<std::string> model_name;
-  std::vector<pcl::PointCloud<PointType>::Ptr> model_list;
-  pcl::PointCloud<PointType>::Ptr scene;
   tf::TransformListener listener;
+  std::unique_ptr<gilbreth::perception::Aligner> aligner;
+  std::unique_ptr<gilbreth::perception::TimingPublisher> timing_publisher;
+  std::unique_ptr<gilbreth::perception::LatencyController> latency_controller;
+  std::unique_ptr<gilbreth::perception::OperatingPointPublisher> operating_point_publisher;
   // Algorithm params
-  float descr_dis_thrd;
-  float descr_rad;
-  float down_sample;
-  float min_sample_distance;
-  float max_correspondence_distance;
-  int nr_iterations;
-  bool visualizer;
-  bool icp;
-  float cg_size;
-  float cg_thresh;
-  bool print_detailed_info;
-  float key_point_sampling;
+  gilbreth::perception::AlignerParameters aligner_params;
   int k_nearest_neighbors;
   int iterations;
+  int telemetry_window;
+  gilbreth::perception::LatencyControllerParameters latency_params;
+  float max_leaf_size;
+  int min_iterations;
 };
 
 int main(int argc, char **argv) {
   // Initialize ROS
   ros::init(argc, argv, "alignment_node");
   ros::NodeHandle nh;
+  gilbreth::perception::forwardLogToRos();
   AlignmentClass alignmentNode(nh);
   // Create a ROS subscriber for the input point cloud
   ros::Subscriber sub_2 = nh.subscribe<gilbreth_msgs::ObjectType>("object_type", 100, &AlignmentClass::objectCallBack, &alignmentNode);
@@ -0,0 +1,195 @@
+#include "gilbreth_perception/binary_descriptor_index.h"
+#include <algorithm>
+#include <limits>
+
+static const int DESCRIPTOR_SIZE = 352;
+
+namespace
+{
+
+typedef gilbreth::perception::BinaryDescriptorIndex::Code Code;
+
+bool isFinite(const pcl::SHOT352& descriptor)
+{
+  return pcl_isfinite(descriptor.descriptor[0]);
+}
+
+inline int hammingDistance(const Code& a, const Code& b)
+{
+  int distance = 0;
+  for(int w = 0; w < gilbreth::perception::BinaryDescriptorIndex::WORDS; w++)
+  {
+    distance += __builtin_popcountll(a[w] ^ b[w]);
+  }
+  return distance;
+}
+
+void scanGeneric(const Code* codes, std::size_t count, const Code& query, int* distances)
+{
+  for(std::size_t k = 0; k < count; k++)
+  {
+    distances[k] = hammingDistance(codes[k], query);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// same loop, compiled so that the builtin becomes the popcnt instruction
+__attribute__((target("popcnt")))
+void scanPopcnt(const Code* codes, std::size_t count, const Code& query, int* distances)
+{
+  for(std::size_t k = 0; k < count; k++)
+  {
+    int distance = 0;
+    for(int w = 0; w < gilbreth::perception::BinaryDescriptorIndex::WORDS; w++)
+    {
+      distance += __builtin_popcountll(codes[k][w] ^ query[w]);
+    }
+    distances[k] = distance;
+  }
+}
+#endif
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+const int BinaryDescriptorIndex::WORDS;
+
+BinaryDescriptorIndex::BinaryDescriptorIndex():
+  thresholds_(DESCRIPTOR_SIZE, 0.0f),
+  model_count_(0),
+  kernel_(&scanGeneric),
+  kernel_name_("generic")
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if(__builtin_cpu_supports("popcnt"))
+  {
+    kernel_ = &scanPopcnt;
+    kernel_name_ = "popcnt";
+  }
+#endif
+}
+
+void BinaryDescriptorIndex::build(const std::vector<DescriptorCloud::Ptr>& model_descriptors)
+{
+  codes_.clear();
+  model_ids_.clear();
+  model_indices_.clear();
+  model_count_ = model_descriptors.size();
+
+  // each bin is thresholded at its mean over the model descriptors, which balances the bits
+  std::vector<double> sums(DESCRIPTOR_SIZE, 0.0);
+  for(std::size_t i = 0; i < model_descriptors.size(); i++)
+  {
+    const DescriptorCloud& descriptors = *model_descriptors[i];
+    for(std::size_t j = 0; j < descriptors.size(); j++)
+    {
+      if(!isFinite(descriptors[j]))
+      {
+        continue;
+      }
+      for(int b = 0; b < DESCRIPTOR_SIZE; b++)
+      {
+        sums[b] += descriptors[j].descriptor[b];
+      }
+      model_ids_.push_back(static_cast<int>(i));
+      model_indices_.push_back(static_cast<int>(j));
+    }
+  }
+
+  if(model_ids_.empty())
+  {
+    return;
+  }
+
+  for(int b = 0; b < DESCRIPTOR_SIZE; b++)
+  {
+    thresholds_[b] = static_cast<float>(sums[b] / model_ids_.size());
+  }
+
+  codes_.reserve(model_ids_.size());
+  for(std::size_t k = 0; k < model_ids_.size(); k++)
+  {
+    codes_.push_back(encode(model_descriptors[model_ids_[k]]->points[model_indices_[k]]));
+  }
+}
+
+BinaryDescriptorIndex::Code BinaryDescriptorIndex::encode(const pcl::SHOT352& descriptor) const
+{
+  Code code;
+  code.fill(0);
+  for(int b = 0; b < DESCRIPTOR_SIZE; b++)
+  {
+    if(descriptor.descriptor[b] > thresholds_[b])
+    {
+      code[b / 64] |= 1ULL << (b % 64);
+    }
+  }
+  return code;
+}
+
+void BinaryDescriptorIndex::match(const DescriptorCloud& scene_descriptors, int max_distance,
+                                  const std::vector<int>& models,
+                                  std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const
+{
+  model_scene_corrs.resize(model_count_);
+  for(pcl::CorrespondencesPtr& corrs : model_scene_corrs)
+  {
+    corrs.reset(new pcl::Correspondences());
+  }
+
+  if(codes_.empty())
+  {
+    return;
+  }
+
+  std::vector<bool> allowed(model_count_, false);
+  for(int id : models)
+  {
+    if(id >= 0 && static_cast<std::size_t>(id) < model_count_)
+    {
+      allowed[id] = true;
+    }
+  }
+
+  // the kernel scans every code at once, the distances of the other models are ignored
+  std::vector<int> distances(codes_.size());
+  std::vector<int> best_distance(model_count_);
+  std::vector<int> best_index(model_count_);
+  for(std::size_t i = 0; i < scene_descriptors.size(); ++i)
+  {
+    if(!isFinite(scene_descriptors[i])) //skipping NaNs
+    {
+      continue;
+    }
+
+    kernel_(codes_.data(), codes_.size(), encode(scene_descriptors[i]), distances.data());
+    std::fill(best_distance.begin(), best_distance.end(), max_distance + 1);
+    std::fill(best_index.begin(), best_index.end(), -1);
+    for(std::size_t k = 0; k < codes_.size(); k++)
+    {
+      const int model_id = model_ids_[k];
+      if(allowed[model_id] && distances[k] < best_distance[model_id])
+      {
+        best_distance[model_id] = distances[k];
+        best_index[model_id] = static_cast<int>(k);
+      }
+    }
+
+    for(std::size_t model_id = 0; model_id < model_count_; model_id++)
+    {
+      if(best_index[model_id] >= 0)
+      {
+        model_scene_corrs[model_id]->push_back(pcl::Correspondence(model_indices_[best_index[model_id]],
+                                                                   static_cast<int>(i),
+                                                                   static_cast<float>(best_distance[model_id])));
+      }
+    }
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
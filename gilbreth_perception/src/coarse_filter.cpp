@@ -0,0 +1,91 @@
+#include "gilbreth_perception/coarse_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <Eigen/Eigenvalues>
+#include <numeric>
+#include <pcl/common/centroid.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+ShapeSignature computeShapeSignature(const pcl::PointCloud<pcl::PointXYZ>& cloud)
+{
+  ShapeSignature signature;
+  signature.points = cloud.size();
+  if(cloud.size() < 3)
+  {
+    return signature;
+  }
+
+  Eigen::Matrix3f covariance;
+  Eigen::Vector4f centroid;
+  pcl::computeMeanAndCovarianceMatrix(cloud, covariance, centroid);
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+  const Eigen::Matrix3f axes = solver.eigenvectors();
+
+  Eigen::Vector3f min_proj = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_proj = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+  for(const pcl::PointXYZ& p : cloud.points)
+  {
+    const Eigen::Vector3f proj = axes.transpose() * (p.getVector3fMap() - centroid.head<3>());
+    min_proj = min_proj.cwiseMin(proj);
+    max_proj = max_proj.cwiseMax(proj);
+  }
+
+  signature.extents = max_proj - min_proj;
+  std::sort(signature.extents.data(), signature.extents.data() + 3, std::greater<float>());
+  return signature;
+}
+
+CoarseFilter::CoarseFilter(std::size_t top_k, float min_extent):
+  top_k_(top_k),
+  min_extent_(min_extent)
+{
+}
+
+void CoarseFilter::addModel(const pcl::PointCloud<pcl::PointXYZ>& model)
+{
+  signatures_.push_back(computeShapeSignature(model));
+}
+
+std::vector<int> CoarseFilter::select(const pcl::PointCloud<pcl::PointXYZ>& cluster) const
+{
+  std::vector<int> ids(signatures_.size());
+  std::iota(ids.begin(), ids.end(), 0);
+  if(top_k_ == 0 || top_k_ >= ids.size())
+  {
+    return ids;
+  }
+
+  const ShapeSignature signature = computeShapeSignature(cluster);
+  std::vector<float> distances(signatures_.size());
+  for(std::size_t i = 0; i < signatures_.size(); i++)
+  {
+    distances[i] = distance(signature, signatures_[i]);
+  }
+
+  // ties keep the lower id so the selection is deterministic
+  std::stable_sort(ids.begin(), ids.end(), [&distances](int a, int b) { return distances[a] < distances[b]; });
+  ids.resize(top_k_);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+float CoarseFilter::distance(const ShapeSignature& a, const ShapeSignature& b) const
+{
+  float d = 0.0f;
+  for(int i = 0; i < 3; i++)
+  {
+    d += std::abs(std::log(std::max(a.extents[i], min_extent_) / std::max(b.extents[i], min_extent_)));
+  }
+  d += std::abs(std::log(static_cast<float>(std::max<std::size_t>(a.points, 1)) /
+                         static_cast<float>(std::max<std::size_t>(b.points, 1))));
+  return d;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,235 @@
+#include "gilbreth_perception/compressed_descriptor_index.h"
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static const int DESCRIPTOR_SIZE = 352;
+static const int CODE_ALIGNMENT = 32;   // bytes consumed per step by the widest kernel
+static const float CODE_RANGE = 127.0f;
+
+namespace
+{
+
+bool isFinite(const pcl::SHOT352& descriptor)
+{
+  return pcl_isfinite(descriptor.descriptor[0]);
+}
+
+std::int32_t squaredDistanceScalar(const std::int8_t* a, const std::int8_t* b, int size)
+{
+  std::int32_t sum = 0;
+  for(int i = 0; i < size; i++)
+  {
+    const std::int32_t d = static_cast<std::int32_t>(a[i]) - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+std::int32_t squaredDistanceAvx2(const std::int8_t* a, const std::int8_t* b, int size)
+{
+  // int8 differences need 9 bits, so they are widened to int16 and squared and pair-summed by madd
+  __m256i acc = _mm256_setzero_si256();
+  for(int i = 0; i < size; i += 16)
+  {
+    const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    const __m256i d = _mm256_sub_epi16(va, vb);
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+  }
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+std::int32_t squaredDistanceAvx512(const std::int8_t* a, const std::int8_t* b, int size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  for(int i = 0; i < size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i d = _mm512_sub_epi16(va, vb);
+    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d, d));
+  }
+  return _mm512_reduce_add_epi32(acc);
+}
+#endif
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+CompressedDescriptorIndex::CompressedDescriptorIndex():
+  step_(1.0f),
+  dimensions_(0),
+  stride_(0),
+  model_count_(0),
+  kernel_(&squaredDistanceScalar),
+  kernel_name_("scalar")
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if(__builtin_cpu_supports("avx512bw"))
+  {
+    kernel_ = &squaredDistanceAvx512;
+    kernel_name_ = "avx512";
+  }
+  else if(__builtin_cpu_supports("avx2"))
+  {
+    kernel_ = &squaredDistanceAvx2;
+    kernel_name_ = "avx2";
+  }
+#endif
+}
+
+bool CompressedDescriptorIndex::build(const std::vector<DescriptorCloud::Ptr>& model_descriptors, int dimensions)
+{
+  codes_.clear();
+  model_ids_.clear();
+  model_indices_.clear();
+  model_count_ = model_descriptors.size();
+  dimensions_ = std::max(1, std::min(dimensions, DESCRIPTOR_SIZE));
+  stride_ = (dimensions_ + CODE_ALIGNMENT - 1) / CODE_ALIGNMENT * CODE_ALIGNMENT;
+
+  for(std::size_t i = 0; i < model_descriptors.size(); i++)
+  {
+    const DescriptorCloud& descriptors = *model_descriptors[i];
+    for(std::size_t j = 0; j < descriptors.size(); j++)
+    {
+      if(isFinite(descriptors[j]))
+      {
+        model_ids_.push_back(static_cast<int>(i));
+        model_indices_.push_back(static_cast<int>(j));
+      }
+    }
+  }
+
+  const std::size_t count = model_ids_.size();
+  if(count < static_cast<std::size_t>(dimensions_))
+  {
+    model_ids_.clear();
+    model_indices_.clear();
+    return false;
+  }
+
+  // principal directions of the model descriptors
+  Eigen::MatrixXf data(DESCRIPTOR_SIZE, count);
+  for(std::size_t k = 0; k < count; k++)
+  {
+    data.col(k) = Eigen::Map<const Eigen::VectorXf>(model_descriptors[model_ids_[k]]->points[model_indices_[k]].descriptor,
+                                                    DESCRIPTOR_SIZE);
+  }
+  mean_ = data.rowwise().mean();
+  data.colwise() -= mean_;
+  const Eigen::MatrixXf covariance = data * data.transpose() / static_cast<float>(count);
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXf> solver(covariance);
+
+  // eigenvalues are in increasing order
+  projection_ = solver.eigenvectors().rightCols(dimensions_).rowwise().reverse().transpose();
+
+  // one quantization step for every coordinate keeps the integer distances proportional to the float ones
+  const Eigen::MatrixXf projected = projection_ * data;
+  const float max_coefficient = projected.cwiseAbs().maxCoeff();
+  step_ = max_coefficient > 0.0f ? max_coefficient / CODE_RANGE : 1.0f;
+
+  codes_.assign(count * stride_, 0);
+  for(std::size_t k = 0; k < count; k++)
+  {
+    encode(model_descriptors[model_ids_[k]]->points[model_indices_[k]], &codes_[k * stride_]);
+  }
+  return true;
+}
+
+void CompressedDescriptorIndex::encode(const pcl::SHOT352& descriptor, std::int8_t* code) const
+{
+  const Eigen::VectorXf coefficients =
+      projection_ * (Eigen::Map<const Eigen::VectorXf>(descriptor.descriptor, DESCRIPTOR_SIZE) - mean_);
+  for(int d = 0; d < dimensions_; d++)
+  {
+    const float q = std::round(coefficients[d] / step_);
+    code[d] = static_cast<std::int8_t>(std::max(-CODE_RANGE, std::min(CODE_RANGE, q)));
+  }
+  std::fill(code + dimensions_, code + stride_, 0);
+}
+
+void CompressedDescriptorIndex::match(const DescriptorCloud& scene_descriptors, float max_sqr_distance,
+                                      const std::vector<int>& models,
+                                      std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const
+{
+  model_scene_corrs.resize(model_count_);
+  for(pcl::CorrespondencesPtr& corrs : model_scene_corrs)
+  {
+    corrs.reset(new pcl::Correspondences());
+  }
+
+  if(model_ids_.empty())
+  {
+    return;
+  }
+
+  std::vector<bool> allowed(model_count_, false);
+  for(int id : models)
+  {
+    if(id >= 0 && static_cast<std::size_t>(id) < model_count_)
+    {
+      allowed[id] = true;
+    }
+  }
+
+  const float sqr_step = step_ * step_;
+  const double scaled_threshold = std::floor(max_sqr_distance / sqr_step);
+  const std::int32_t threshold = static_cast<std::int32_t>(
+      std::min<double>(scaled_threshold, std::numeric_limits<std::int32_t>::max()));
+  std::vector<std::int8_t> code(stride_);
+  std::vector<std::int32_t> best_distance(model_count_);
+  std::vector<int> best_index(model_count_);
+  for(std::size_t i = 0; i < scene_descriptors.size(); ++i)
+  {
+    if(!isFinite(scene_descriptors[i])) //skipping NaNs
+    {
+      continue;
+    }
+
+    encode(scene_descriptors[i], code.data());
+    std::fill(best_distance.begin(), best_distance.end(), std::numeric_limits<std::int32_t>::max());
+    std::fill(best_index.begin(), best_index.end(), -1);
+    for(std::size_t k = 0; k < model_ids_.size(); k++)
+    {
+      const int model_id = model_ids_[k];
+      if(!allowed[model_id])
+      {
+        continue;
+      }
+      const std::int32_t distance = kernel_(&codes_[k * stride_], code.data(), stride_);
+      if(distance <= threshold && distance < best_distance[model_id])
+      {
+        best_distance[model_id] = distance;
+        best_index[model_id] = static_cast<int>(k);
+      }
+    }
+
+    for(std::size_t model_id = 0; model_id < model_count_; model_id++)
+    {
+      if(best_index[model_id] >= 0)
+      {
+        model_scene_corrs[model_id]->push_back(pcl::Correspondence(model_indices_[best_index[model_id]],
+                                                                   static_cast<int>(i),
+                                                                   best_distance[model_id] * sqr_step));
+      }
+    }
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
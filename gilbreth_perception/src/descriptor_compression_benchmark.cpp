@@ -0,0 +1,213 @@
+#include "gilbreth_perception/binary_descriptor_index.h"
+#include "gilbreth_perception/compressed_descriptor_index.h"
+#include "gilbreth_perception/descriptor_index.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <pcl/console/parse.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/keypoints/uniform_sampling.h>
+#include <set>
+#include <tuple>
+
+/**
+ * Compares the compressed and binary descriptor matching against the full SHOT matching used by the recognition
+ * node. Recall is the fraction of the full matches that the other index also returns.
+ */
+
+typedef pcl::PointXYZ PointType;
+typedef pcl::Normal NormalType;
+typedef std::tuple<int, int, int> Match;   // model, model keypoint, scene keypoint
+
+struct Parameters
+{
+  float down_sample = 0.01f;
+  float key_point_sampling = 0.01f;
+  float descr_rad = 0.1f;
+  float descr_dis_thrd = 0.2f;
+  int k_nearest_neighbors = 10;
+  int max_hamming_distance = 80;
+  int repetitions = 10;
+};
+
+static void printUsage(const char* program)
+{
+  std::cout << "Usage: " << program << " scene.pcd model.pcd [model.pcd ...] [options]\n"
+            << "  -dims <int>       compressed dimensions, may be given several times (default 32 48 64)\n"
+            << "  -down_sample <m>  voxel size (0.01)\n"
+            << "  -key_point_sampling <m> (0.01)\n"
+            << "  -descr_rad <m>    SHOT radius (0.1)\n"
+            << "  -descr_dis_thrd <d> squared descriptor distance threshold (0.2)\n"
+            << "  -k <int>          normal estimation neighbors (10)\n"
+            << "  -max_hamming_distance <int> binary descriptor threshold (80)\n"
+            << "  -repetitions <int> matching runs averaged in the timings (10)\n";
+}
+
+static bool computeDescriptors(const std::string& path, const Parameters& params,
+                               pcl::PointCloud<pcl::SHOT352>::Ptr& descriptors)
+{
+  pcl::PointCloud<PointType>::Ptr raw(new pcl::PointCloud<PointType>());
+  if(pcl::io::loadPCDFile(path, *raw) < 0)
+  {
+    std::cerr << "Failed to load " << path << std::endl;
+    return false;
+  }
+
+  pcl::PointCloud<PointType>::Ptr cloud(new pcl::PointCloud<PointType>());
+  pcl::VoxelGrid<PointType> sor;
+  sor.setInputCloud(raw);
+  sor.setLeafSize(params.down_sample, params.down_sample, params.down_sample);
+  sor.filter(*cloud);
+
+  pcl::PointCloud<NormalType>::Ptr normals(new pcl::PointCloud<NormalType>());
+  pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
+  norm_est.setKSearch(params.k_nearest_neighbors);
+  norm_est.setInputCloud(cloud);
+  norm_est.compute(*normals);
+
+  pcl::PointCloud<PointType>::Ptr keypoints(new pcl::PointCloud<PointType>());
+  pcl::UniformSampling<PointType> uniform_sampling;
+  uniform_sampling.setInputCloud(cloud);
+  uniform_sampling.setRadiusSearch(params.key_point_sampling);
+  uniform_sampling.filter(*keypoints);
+
+  descriptors.reset(new pcl::PointCloud<pcl::SHOT352>());
+  pcl::SHOTEstimationOMP<PointType, NormalType, pcl::SHOT352> descr_est;
+  descr_est.setRadiusSearch(params.descr_rad);
+  descr_est.setInputCloud(keypoints);
+  descr_est.setInputNormals(normals);
+  descr_est.setSearchSurface(cloud);
+  descr_est.compute(*descriptors);
+  return true;
+}
+
+template <typename Index, typename Threshold>
+static double timeMatching(const Index& index, const pcl::PointCloud<pcl::SHOT352>& scene, Threshold threshold,
+                           const Parameters& params, std::set<Match>& matches)
+{
+  std::vector<int> all(index.getModelCount());
+  for(std::size_t i = 0; i < all.size(); i++)
+  {
+    all[i] = static_cast<int>(i);
+  }
+
+  std::vector<pcl::CorrespondencesPtr> corrs;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int r = 0; r < params.repetitions; r++)
+  {
+    index.match(scene, threshold, all, corrs);
+  }
+  const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  matches.clear();
+  for(std::size_t m = 0; m < corrs.size(); m++)
+  {
+    for(const pcl::Correspondence& c : *corrs[m])
+    {
+      matches.insert(Match(static_cast<int>(m), c.index_query, c.index_match));
+    }
+  }
+  return elapsed / params.repetitions;
+}
+
+static std::size_t countFound(const std::set<Match>& reference, const std::set<Match>& matches)
+{
+  std::size_t found = 0;
+  for(const Match& match : reference)
+  {
+    found += matches.count(match);
+  }
+  return found;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<int> pcd_args = pcl::console::parse_file_extension_argument(argc, argv, ".pcd");
+  if(pcd_args.size() < 2)
+  {
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  Parameters params;
+  std::vector<int> dimensions;
+  pcl::console::parse_argument(argc, argv, "-down_sample", params.down_sample);
+  pcl::console::parse_argument(argc, argv, "-key_point_sampling", params.key_point_sampling);
+  pcl::console::parse_argument(argc, argv, "-descr_rad", params.descr_rad);
+  pcl::console::parse_argument(argc, argv, "-descr_dis_thrd", params.descr_dis_thrd);
+  pcl::console::parse_argument(argc, argv, "-k", params.k_nearest_neighbors);
+  pcl::console::parse_argument(argc, argv, "-max_hamming_distance", params.max_hamming_distance);
+  pcl::console::parse_argument(argc, argv, "-repetitions", params.repetitions);
+  pcl::console::parse_multiple_arguments(argc, argv, "-dims", dimensions);
+  if(dimensions.empty())
+  {
+    dimensions = {32, 48, 64};
+  }
+
+  pcl::PointCloud<pcl::SHOT352>::Ptr scene_descriptors;
+  if(!computeDescriptors(argv[pcd_args[0]], params, scene_descriptors))
+  {
+    return -1;
+  }
+
+  std::vector<pcl::PointCloud<pcl::SHOT352>::Ptr> model_descriptors;
+  std::size_t model_descriptor_count = 0;
+  for(std::size_t i = 1; i < pcd_args.size(); i++)
+  {
+    pcl::PointCloud<pcl::SHOT352>::Ptr descriptors;
+    if(!computeDescriptors(argv[pcd_args[i]], params, descriptors))
+    {
+      return -1;
+    }
+    model_descriptors.push_back(descriptors);
+    model_descriptor_count += descriptors->size();
+  }
+
+  gilbreth::perception::DescriptorIndex full_index;
+  full_index.build(model_descriptors);
+  std::set<Match> full_matches;
+  const double full_time = timeMatching(full_index, *scene_descriptors, params.descr_dis_thrd, params,
+                                         full_matches);
+
+  std::cout << scene_descriptors->size() << " scene descriptors, " << model_descriptor_count << " model descriptors in "
+            << model_descriptors.size() << " models\n\n"
+            << std::left << std::setw(12) << "index" << std::setw(6) << "dims" << std::setw(10) << "bytes"
+            << std::setw(10) << "match ms" << std::setw(9) << "matches" << std::setw(8) << "recall" << "extra\n"
+            << std::setw(12) << "full" << std::setw(6) << 352
+            << std::setw(10) << model_descriptor_count * sizeof(pcl::SHOT352::descriptor) << std::setw(10) << full_time
+            << std::setw(9) << full_matches.size() << std::setw(8) << 1.0 << 0 << "\n";
+
+  for(int dims : dimensions)
+  {
+    gilbreth::perception::CompressedDescriptorIndex compressed_index;
+    if(!compressed_index.build(model_descriptors, dims))
+    {
+      std::cout << std::setw(12) << "compressed" << std::setw(6) << dims << "too few model descriptors\n";
+      continue;
+    }
+
+    std::set<Match> compressed_matches;
+    const double compressed_time = timeMatching(compressed_index, *scene_descriptors, params.descr_dis_thrd,
+                                                   params, compressed_matches);
+    const std::size_t found = countFound(full_matches, compressed_matches);
+    const double recall = full_matches.empty() ? 1.0 : static_cast<double>(found) / full_matches.size();
+    std::cout << std::setw(12) << "compressed" << std::setw(6) << dims << std::setw(10) << compressed_index.getCodeBytes()
+              << std::setw(10) << compressed_time << std::setw(9) << compressed_matches.size() << std::setw(8) << recall
+              << compressed_matches.size() - found << " (" << compressed_index.getKernelName() << " kernel)\n";
+  }
+
+  gilbreth::perception::BinaryDescriptorIndex binary_index;
+  binary_index.build(model_descriptors);
+  std::set<Match> binary_matches;
+  const double binary_time = timeMatching(binary_index, *scene_descriptors, params.max_hamming_distance, params,
+                                          binary_matches);
+  const std::size_t found = countFound(full_matches, binary_matches);
+  const double recall = full_matches.empty() ? 1.0 : static_cast<double>(found) / full_matches.size();
+  std::cout << std::setw(12) << "binary" << std::setw(6) << 352 << std::setw(10) << binary_index.getCodeBytes()
+            << std::setw(10) << binary_time << std::setw(9) << binary_matches.size() << std::setw(8) << recall
+            << binary_matches.size() - found << " (" << binary_index.getKernelName() << " kernel)\n";
+  return 0;
+}
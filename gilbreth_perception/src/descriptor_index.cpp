@@ -0,0 +1,93 @@
+#include "gilbreth_perception/descriptor_index.h"
+#include <pcl/kdtree/impl/kdtree_flann.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+DescriptorIndex::DescriptorIndex():
+  model_count_(0)
+{
+}
+
+void DescriptorIndex::build(const std::vector<DescriptorCloud::Ptr>& model_descriptors)
+{
+  DescriptorCloud::Ptr stacked(new DescriptorCloud());
+  model_ids_.clear();
+  model_indices_.clear();
+  model_count_ = model_descriptors.size();
+
+  for(std::size_t i = 0; i < model_descriptors.size(); i++)
+  {
+    const DescriptorCloud& descriptors = *model_descriptors[i];
+    for(std::size_t j = 0; j < descriptors.size(); j++)
+    {
+      stacked->push_back(descriptors[j]);
+      model_ids_.push_back(static_cast<int>(i));
+      model_indices_.push_back(static_cast<int>(j));
+    }
+  }
+
+  // non-finite descriptors are dropped by the tree, its results still refer to the stacked cloud indices
+  stacked->is_dense = false;
+  tree_.setInputCloud(stacked);
+}
+
+void DescriptorIndex::match(const DescriptorCloud& scene_descriptors, float max_sqr_distance,
+                            const std::vector<int>& models,
+                            std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const
+{
+  model_scene_corrs.resize(model_count_);
+  for(pcl::CorrespondencesPtr& corrs : model_scene_corrs)
+  {
+    corrs.reset(new pcl::Correspondences());
+  }
+
+  if(model_ids_.empty())
+  {
+    return;
+  }
+
+  std::vector<bool> allowed(model_count_, false);
+  for(int id : models)
+  {
+    if(id >= 0 && static_cast<std::size_t>(id) < model_count_)
+    {
+      allowed[id] = true;
+    }
+  }
+
+  // the radius search returns every model descriptor within the threshold sorted by distance, so the first hit of
+  // each model is that model's nearest neighbor
+  const double radius = std::sqrt(max_sqr_distance);
+  std::vector<int> neigh_indices;
+  std::vector<float> neigh_sqr_dists;
+  std::vector<bool> matched(model_count_, false);
+  for(std::size_t i = 0; i < scene_descriptors.size(); ++i)
+  {
+    if(!pcl_isfinite(scene_descriptors[i].descriptor[0])) //skipping NaNs
+    {
+      continue;
+    }
+
+    int found_neighs = tree_.radiusSearch(scene_descriptors[i], radius, neigh_indices, neigh_sqr_dists);
+    std::fill(matched.begin(), matched.end(), false);
+    for(int k = 0; k < found_neighs; k++)
+    {
+      const int model_id = model_ids_[neigh_indices[k]];
+      if(!allowed[model_id] || matched[model_id] || neigh_sqr_dists[k] > max_sqr_distance)
+      {
+        continue;
+      }
+      matched[model_id] = true;
+      model_scene_corrs[model_id]->push_back(pcl::Correspondence(model_indices_[neigh_indices[k]],
+                                                                 static_cast<int>(i), neigh_sqr_dists[k]));
+    }
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
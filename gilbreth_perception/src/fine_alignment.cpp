@@ -0,0 +1,273 @@
+#include "gilbreth_perception/fine_alignment.h"
+#include "gilbreth_perception/hypothesis_verifier.h"
+#include <Eigen/Cholesky>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <pcl/features/normal_3d_omp.h>
+
+static const std::size_t MIN_PAIRS = 6;
+
+namespace
+{
+
+struct Pair
+{
+  Eigen::Vector3f source;   // scene point moved into the model frame
+  Eigen::Vector3f target;   // closest model point
+  Eigen::Vector3f normal;   // model normal at the target
+  float sqr_distance;
+};
+
+Eigen::Matrix4f rigidInverse(const Eigen::Matrix4f& transformation)
+{
+  return Eigen::Affine3f(transformation).inverse(Eigen::Isometry).matrix();
+}
+
+std::size_t gcd(std::size_t a, std::size_t b)
+{
+  while(b != 0)
+  {
+    const std::size_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+FineAlignment::FineAlignment(const FineAlignmentParameters& params):
+  params_(params)
+{
+}
+
+std::size_t FineAlignment::addModel(const Cloud::ConstPtr& model)
+{
+  Model m;
+  for(const Cloud::ConstPtr& cloud : buildPyramid(model, params_.leaf_size, params_.pyramid_levels))
+  {
+    Level level;
+    level.cloud = cloud;
+    level.tree.reset(new pcl::search::KdTree<pcl::PointXYZ>());
+    level.tree->setInputCloud(cloud);
+
+    level.normals.reset(new pcl::PointCloud<pcl::Normal>());
+    pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> norm_est;
+    norm_est.setKSearch(params_.normal_k_neighbors);
+    norm_est.setSearchMethod(level.tree);
+    norm_est.setInputCloud(cloud);
+    norm_est.compute(*level.normals);
+    m.push_back(level);
+  }
+
+  models_.push_back(m);
+  return models_.size() - 1;
+}
+
+bool FineAlignment::refine(std::size_t model_id, const Cloud::ConstPtr& scene, const Eigen::Matrix4f& guess,
+                           FineAlignmentResult& result, int max_iterations, int finest_level) const
+{
+  return refine(model_id, buildPyramid(scene, params_.leaf_size, params_.pyramid_levels), guess, result,
+                max_iterations, finest_level);
+}
+
+bool FineAlignment::refine(std::size_t model_id, const CloudPyramid& scene, const Eigen::Matrix4f& guess,
+                           FineAlignmentResult& result, int max_iterations, int finest_level) const
+{
+  result.transformation = guess;
+  result.fitness_score = std::numeric_limits<float>::max();
+  result.iterations = 0;
+  result.converged = false;
+  if(model_id >= models_.size() || scene.empty() || scene.front()->empty())
+  {
+    return false;
+  }
+
+  // coarse to fine, the correspondence distance follows the leaf size of the level
+  const Model& model = models_[model_id];
+  const int levels = static_cast<int>(std::min(model.size(), scene.size()));
+  const int last_level = std::max(0, std::min(finest_level, levels - 1));
+  Eigen::Matrix4f scene_to_model = rigidInverse(guess);
+  const int iterations = max_iterations > 0 ? max_iterations : params_.max_iterations;
+  for(int level = levels - 1; level >= last_level; level--)
+  {
+    const float max_correspondence_distance = params_.max_correspondence_distance * static_cast<float>(1 << level);
+    result.converged = refineLevel(model[level], *scene[level], max_correspondence_distance, iterations,
+                                   scene_to_model, result);
+  }
+
+  if(result.iterations == 0)
+  {
+    return false;
+  }
+
+  result.transformation = rigidInverse(scene_to_model);
+  return true;
+}
+
+float FineAlignment::inlierRatio(std::size_t model_id, const Cloud& scene, const Eigen::Matrix4f& model_to_scene,
+                                 float max_distance, float min_ratio) const
+{
+  if(model_id >= models_.size() || scene.empty())
+  {
+    return 0.0f;
+  }
+
+  // clusters are ordered along the scan, a stride coprime with the size visits every point once while any prefix
+  // samples the whole cluster
+  const std::size_t size = scene.size();
+  std::size_t stride = 1;
+  if(min_ratio > 0.0f)
+  {
+    stride = std::max<std::size_t>(1, static_cast<std::size_t>(size * 0.618));
+    while(stride > 1 && gcd(stride, size) != 1)
+    {
+      stride--;
+    }
+  }
+
+  const Level& model = models_[model_id].front();
+  const Eigen::Affine3f scene_to_model(rigidInverse(model_to_scene));
+  const float max_sqr_distance = max_distance * max_distance;
+  SequentialInlierTest test(min_ratio, VerificationParameters());
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+  std::size_t finite = 0;
+  std::size_t inliers = 0;
+  for(std::size_t i = 0, index = 0; i < size; i++, index = (index + stride) % size)
+  {
+    const pcl::PointXYZ& point = scene.points[index];
+    if(!pcl_isfinite(point.x) || !pcl_isfinite(point.y) || !pcl_isfinite(point.z))
+    {
+      continue;
+    }
+
+    finite++;
+    pcl::PointXYZ moved;
+    moved.getVector3fMap() = scene_to_model * point.getVector3fMap();
+    const bool inlier = model.tree->nearestKSearch(moved, 1, nn_indices, nn_dists) > 0 &&
+                        nn_dists[0] <= max_sqr_distance;
+    if(inlier)
+    {
+      inliers++;
+    }
+
+    if(!test.add(inlier))
+    {
+      break;
+    }
+  }
+  return finite > 0 ? static_cast<float>(inliers) / finite : 0.0f;
+}
+
+bool FineAlignment::refineLevel(const Level& model, const Cloud& scene, float max_correspondence_distance,
+                                int max_iterations, Eigen::Matrix4f& scene_to_model,
+                                FineAlignmentResult& result) const
+{
+  const float max_sqr_distance = max_correspondence_distance * max_correspondence_distance;
+  float previous_residual = std::numeric_limits<float>::max();
+  std::vector<Pair> pairs;
+  pairs.reserve(scene.size());
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+
+  for(int it = 0; it < max_iterations; it++)
+  {
+    const Eigen::Affine3f pose(scene_to_model);
+    pairs.clear();
+    for(const pcl::PointXYZ& point : scene.points)
+    {
+      if(!pcl_isfinite(point.x) || !pcl_isfinite(point.y) || !pcl_isfinite(point.z))
+      {
+        continue;
+      }
+
+      pcl::PointXYZ moved;
+      moved.getVector3fMap() = pose * point.getVector3fMap();
+      if(model.tree->nearestKSearch(moved, 1, nn_indices, nn_dists) < 1 || nn_dists[0] > max_sqr_distance)
+      {
+        continue;
+      }
+
+      const pcl::Normal& normal = model.normals->points[nn_indices[0]];
+      if(!pcl_isfinite(normal.normal_x))
+      {
+        continue;
+      }
+
+      Pair pair;
+      pair.source = moved.getVector3fMap();
+      pair.target = model.cloud->points[nn_indices[0]].getVector3fMap();
+      pair.normal = normal.getNormalVector3fMap();
+      pair.sqr_distance = nn_dists[0];
+      pairs.push_back(pair);
+    }
+
+    // trimming, the farthest pairs are most likely clutter or the parts of the model hidden in the scene
+    const std::size_t keep = static_cast<std::size_t>(std::ceil(pairs.size() * params_.trim_ratio));
+    if(keep < pairs.size())
+    {
+      std::nth_element(pairs.begin(), pairs.begin() + keep, pairs.end(), [](const Pair& a, const Pair& b)
+      {
+        return a.sqr_distance < b.sqr_distance;
+      });
+      pairs.resize(keep);
+    }
+
+    if(pairs.size() < MIN_PAIRS)
+    {
+      break;
+    }
+
+    // linearized point-to-plane least squares in the rotation vector and translation of the update
+    Eigen::Matrix<double, 6, 6> ata = Eigen::Matrix<double, 6, 6>::Zero();
+    Eigen::Matrix<double, 6, 1> atb = Eigen::Matrix<double, 6, 1>::Zero();
+    double residual = 0.0;
+    for(const Pair& pair : pairs)
+    {
+      const Eigen::Vector3d p = pair.source.cast<double>();
+      const Eigen::Vector3d n = pair.normal.cast<double>();
+      Eigen::Matrix<double, 6, 1> a;
+      a.head<3>() = p.cross(n);
+      a.tail<3>() = n;
+      ata += a * a.transpose();
+      atb -= a * n.dot(p - pair.target.cast<double>());
+      residual += pair.sqr_distance;
+    }
+    residual /= pairs.size();
+
+    const Eigen::Matrix<double, 6, 1> x = ata.ldlt().solve(atb);
+    const Eigen::Vector3d rotation = x.head<3>();
+    const double angle = rotation.norm();
+    Eigen::Matrix4f update = Eigen::Matrix4f::Identity();
+    if(angle > 0.0)
+    {
+      update.topLeftCorner<3, 3>() = Eigen::AngleAxisd(angle, rotation / angle).toRotationMatrix().cast<float>();
+    }
+    update.topRightCorner<3, 1>() = x.tail<3>().cast<float>();
+    scene_to_model = update * scene_to_model;
+
+    result.iterations++;
+    result.fitness_score = static_cast<float>(residual);
+
+    const bool small_update = x.tail<3>().norm() < params_.translation_epsilon && angle < params_.rotation_epsilon;
+    const bool flat_residual = previous_residual < std::numeric_limits<float>::max() &&
+                               std::abs(previous_residual - residual) <= params_.relative_residual_epsilon * previous_residual;
+    if(small_update || flat_residual)
+    {
+      return true;
+    }
+    previous_residual = static_cast<float>(residual);
+  }
+  return false;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,322 @@
+#include "gilbreth_perception/global_registration.h"
+#include <pcl/kdtree/impl/kdtree_flann.hpp>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+static const std::size_t MIN_CORRESPONDENCES = 3;
+static const int ITERATIONS_PER_SCALE = 4;
+
+namespace
+{
+
+bool isFinite(const pcl::FPFHSignature33& feature)
+{
+  return pcl_isfinite(feature.histogram[0]);
+}
+
+/**
+ * Weighted least squares rigid transformation mapping p onto q (Kabsch), false when the mean weight vanishes
+ */
+bool weightedRigidTransform(const std::vector<Eigen::Vector3f>& p, const std::vector<Eigen::Vector3f>& q,
+                            const std::vector<float>& w, Eigen::Matrix4f& transformation)
+{
+  float total = 0.0f;
+  Eigen::Vector3f pc = Eigen::Vector3f::Zero();
+  Eigen::Vector3f qc = Eigen::Vector3f::Zero();
+  for(std::size_t k = 0; k < p.size(); k++)
+  {
+    total += w[k];
+    pc += w[k] * p[k];
+    qc += w[k] * q[k];
+  }
+  if(!(total > std::numeric_limits<float>::epsilon() * static_cast<float>(p.size())))
+  {
+    return false;
+  }
+  pc /= total;
+  qc /= total;
+
+  Eigen::Matrix3f h = Eigen::Matrix3f::Zero();
+  for(std::size_t k = 0; k < p.size(); k++)
+  {
+    h += w[k] * (p[k] - pc) * (q[k] - qc).transpose();
+  }
+
+  Eigen::JacobiSVD<Eigen::Matrix3f> svd(h, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::Matrix3f d = Eigen::Matrix3f::Identity();
+  if((svd.matrixV() * svd.matrixU().transpose()).determinant() < 0.0f)
+  {
+    d(2, 2) = -1.0f;  // reflection
+  }
+  const Eigen::Matrix3f r = svd.matrixV() * d * svd.matrixU().transpose();
+
+  transformation = Eigen::Matrix4f::Identity();
+  transformation.topLeftCorner<3, 3>() = r;
+  transformation.topRightCorner<3, 1>() = qc - r * pc;
+  return true;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+GlobalRegistration::GlobalRegistration(const GlobalRegistrationParameters& params):
+  params_(params)
+{
+}
+
+std::size_t GlobalRegistration::addModel(const Cloud::ConstPtr& cloud, const Features::ConstPtr& features)
+{
+  Model m;
+  m.cloud = cloud;
+  m.features = features;
+  m.feature_tree.reset(new pcl::KdTreeFLANN<pcl::FPFHSignature33>());
+
+  // non-finite features are dropped by the tree, its results still refer to the feature cloud indices
+  Features::Ptr finite_checked(new Features(*features));
+  finite_checked->is_dense = false;
+  m.feature_tree->setInputCloud(finite_checked);
+
+  models_.push_back(m);
+  return models_.size() - 1;
+}
+
+void GlobalRegistration::setScene(const Cloud::ConstPtr& cloud, const Features::ConstPtr& features, Scene& scene)
+{
+  scene.cloud = cloud;
+  scene.features = features;
+  Features::Ptr finite_checked(new Features(*features));
+  finite_checked->is_dense = false;
+  scene.feature_tree.setInputCloud(finite_checked);
+}
+
+bool GlobalRegistration::align(std::size_t model_id, const Scene& scene, const Search& scene_tree, double max_range,
+                               GlobalRegistrationResult& result) const
+{
+  result.transformation = Eigen::Matrix4f::Identity();
+  result.fitness_score = std::numeric_limits<float>::max();
+  result.inliers = 0;
+  if(model_id >= models_.size() || !scene.cloud || scene.cloud->empty())
+  {
+    return false;
+  }
+
+  const Model& model = models_[model_id];
+  pcl::Correspondences corrs;
+  matchFeatures(model, scene, corrs);
+  pruneInconsistent(model, scene, corrs);
+  result.inliers = corrs.size();
+  if(corrs.size() < MIN_CORRESPONDENCES)
+  {
+    return false;
+  }
+
+  if(!solve(model, scene, corrs, result.transformation))
+  {
+    return false;
+  }
+  if(max_range <= 0.0)
+  {
+    return true;
+  }
+
+  // fitness over the whole model, comparable with the SAC-IA scores
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+  double fitness = 0.0;
+  int count = 0;
+  const Eigen::Affine3f pose(result.transformation);
+  for(const pcl::PointXYZ& point : model.cloud->points)
+  {
+    pcl::PointXYZ transformed;
+    transformed.getVector3fMap() = pose * point.getVector3fMap();
+    if(scene_tree.nearestKSearch(transformed, 1, nn_indices, nn_dists) > 0 && nn_dists[0] <= max_range)
+    {
+      fitness += nn_dists[0];
+      count++;
+    }
+  }
+  if(count > 0)
+  {
+    result.fitness_score = static_cast<float>(fitness / count);
+  }
+  return true;
+}
+
+void GlobalRegistration::matchFeatures(const Model& model, const Scene& scene, pcl::Correspondences& corrs) const
+{
+  const Features& model_features = *model.features;
+  const Features& scene_features = *scene.features;
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+
+  std::vector<int> scene_to_model(scene_features.size(), -1);
+  for(std::size_t j = 0; j < scene_features.size(); j++)
+  {
+    if(isFinite(scene_features[j]) && model.feature_tree->nearestKSearch(scene_features[j], 1, nn_indices, nn_dists) > 0)
+    {
+      scene_to_model[j] = nn_indices[0];
+    }
+  }
+
+  corrs.clear();
+  for(std::size_t i = 0; i < model_features.size(); i++)
+  {
+    if(isFinite(model_features[i]) && scene.feature_tree.nearestKSearch(model_features[i], 1, nn_indices, nn_dists) > 0 &&
+       scene_to_model[nn_indices[0]] == static_cast<int>(i))
+    {
+      corrs.push_back(pcl::Correspondence(static_cast<int>(i), nn_indices[0], nn_dists[0]));
+    }
+  }
+
+  // the consistency test is quadratic, only the most distinctive matches go through it
+  if(corrs.size() > params_.max_correspondences)
+  {
+    std::nth_element(corrs.begin(), corrs.begin() + params_.max_correspondences, corrs.end(),
+                     [](const pcl::Correspondence& a, const pcl::Correspondence& b)
+    {
+      return a.distance < b.distance;
+    });
+    corrs.resize(params_.max_correspondences);
+  }
+}
+
+void GlobalRegistration::pruneInconsistent(const Model& model, const Scene& scene, pcl::Correspondences& corrs) const
+{
+  const std::size_t n = corrs.size();
+  std::vector<char> consistent(n * n, 0);
+  std::vector<int> degree(n, 0);
+  for(std::size_t a = 0; a < n; a++)
+  {
+    const Eigen::Vector3f pa = model.cloud->points[corrs[a].index_query].getVector3fMap();
+    const Eigen::Vector3f qa = scene.cloud->points[corrs[a].index_match].getVector3fMap();
+    for(std::size_t b = a + 1; b < n; b++)
+    {
+      const float model_length = (model.cloud->points[corrs[b].index_query].getVector3fMap() - pa).norm();
+      const float scene_length = (scene.cloud->points[corrs[b].index_match].getVector3fMap() - qa).norm();
+      if(model_length * params_.tuple_scale <= scene_length && scene_length * params_.tuple_scale <= model_length)
+      {
+        consistent[a * n + b] = consistent[b * n + a] = 1;
+        degree[a]++;
+        degree[b]++;
+      }
+    }
+  }
+
+  // greedy clique, most connected correspondences first and the feature distance breaks ties
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+  {
+    if(degree[a] != degree[b])
+    {
+      return degree[a] > degree[b];
+    }
+    if(corrs[a].distance != corrs[b].distance)
+    {
+      return corrs[a].distance < corrs[b].distance;
+    }
+    return a < b;
+  });
+
+  std::vector<std::size_t> clique;
+  for(std::size_t candidate : order)
+  {
+    bool accepted = true;
+    for(std::size_t member : clique)
+    {
+      if(!consistent[candidate * n + member])
+      {
+        accepted = false;
+        break;
+      }
+    }
+    if(accepted)
+    {
+      clique.push_back(candidate);
+    }
+  }
+
+  pcl::Correspondences pruned;
+  for(std::size_t k : clique)
+  {
+    pruned.push_back(corrs[k]);
+  }
+  corrs.swap(pruned);
+}
+
+bool GlobalRegistration::solve(const Model& model, const Scene& scene, const pcl::Correspondences& corrs,
+                               Eigen::Matrix4f& transformation) const
+{
+  std::vector<Eigen::Vector3f> p(corrs.size());
+  std::vector<Eigen::Vector3f> q(corrs.size());
+  Eigen::Vector3f scene_center = Eigen::Vector3f::Zero();
+  for(std::size_t k = 0; k < corrs.size(); k++)
+  {
+    p[k] = model.cloud->points[corrs[k].index_query].getVector3fMap();
+    q[k] = scene.cloud->points[corrs[k].index_match].getVector3fMap();
+    scene_center += q[k];
+  }
+  scene_center /= static_cast<float>(corrs.size());
+
+  // the kernel starts as wide as the matched scene region so that every correspondence contributes
+  const float min_scale = params_.max_correspondence_distance * params_.max_correspondence_distance;
+  float scale = min_scale;
+  for(const Eigen::Vector3f& point : q)
+  {
+    scale = std::max(scale, (point - scene_center).squaredNorm());
+  }
+
+  // the unweighted solution seeds the first residuals
+  std::vector<float> weights(corrs.size(), 1.0f);
+  if(!weightedRigidTransform(p, q, weights, transformation))
+  {
+    return false;
+  }
+
+  bool solved = false;
+  for(int it = 0; it < params_.iterations; it++)
+  {
+    if(it > 0 && it % ITERATIONS_PER_SCALE == 0)
+    {
+      scale = std::max(min_scale, scale / params_.division_factor);
+    }
+
+    // Geman-McClure weights, relative to the largest so that a small scale does not underflow them
+    float max_weight = 0.0f;
+    for(std::size_t k = 0; k < corrs.size(); k++)
+    {
+      const Eigen::Vector3f residual = transformation.topLeftCorner<3, 3>() * p[k] +
+                                       transformation.topRightCorner<3, 1>() - q[k];
+      const float w = scale / (scale + residual.squaredNorm());
+      weights[k] = w * w;
+      max_weight = std::max(max_weight, weights[k]);
+    }
+    if(!(max_weight > 0.0f))
+    {
+      break;
+    }
+    for(float& weight : weights)
+    {
+      weight /= max_weight;
+    }
+
+    Eigen::Matrix4f update;
+    if(!weightedRigidTransform(p, q, weights, update))
+    {
+      break;
+    }
+    transformation = update;
+    solved = true;
+  }
+  return solved;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,368 @@
+#include "gilbreth_perception/hough_grouping.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <pcl/common/centroid.h>
+#include <pcl/registration/correspondence_rejection_sample_consensus.h>
+
+static const std::size_t VOTE_CHUNK_SIZE = 256;
+static const std::int64_t BIN_COORDINATE_OFFSET = 1 << 20;   /** @brief bins span +-2^20 cells per axis */
+
+namespace
+{
+
+std::int64_t binKey(std::int64_t x, std::int64_t y, std::int64_t z)
+{
+  return ((x + BIN_COORDINATE_OFFSET) << 42) | ((y + BIN_COORDINATE_OFFSET) << 21) | (z + BIN_COORDINATE_OFFSET);
+}
+
+bool isFinite(const pcl::ReferenceFrame& rf)
+{
+  return pcl_isfinite(rf.x_axis[0]) && pcl_isfinite(rf.y_axis[0]) && pcl_isfinite(rf.z_axis[0]);
+}
+
+float maxDistance(const pcl::Correspondences& corrs)
+{
+  float max_distance = 0.0f;
+  for(const pcl::Correspondence& corr : corrs)
+  {
+    max_distance = std::max(max_distance, corr.distance);
+  }
+  return max_distance;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+HoughModel::HoughModel(const Cloud::ConstPtr& keypoints, const Frames::ConstPtr& rf):
+  keypoints_(keypoints),
+  rf_(rf)
+{
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid(*keypoints_, centroid);
+  votes_.resize(keypoints_->size());
+  for(std::size_t i = 0; i < keypoints_->size() && i < rf_->size(); i++)
+  {
+    const pcl::ReferenceFrame& frame = rf_->points[i];
+    if(!isFinite(frame))
+    {
+      votes_[i].setConstant(std::numeric_limits<float>::quiet_NaN());
+      continue;
+    }
+
+    const Eigen::Vector3f to_centroid = centroid.head<3>() - keypoints_->points[i].getVector3fMap();
+    votes_[i] = Eigen::Vector3f(Eigen::Map<const Eigen::Vector3f>(frame.x_axis).dot(to_centroid),
+                                Eigen::Map<const Eigen::Vector3f>(frame.y_axis).dot(to_centroid),
+                                Eigen::Map<const Eigen::Vector3f>(frame.z_axis).dot(to_centroid));
+  }
+}
+
+HoughModel::HoughModel(const Cloud::ConstPtr& keypoints, const Frames::ConstPtr& rf, const HoughVotes& votes):
+  keypoints_(keypoints),
+  rf_(rf),
+  votes_(votes)
+{
+}
+
+HoughAccumulator::HoughAccumulator(const HoughParameters& params):
+  params_(params)
+{
+}
+
+void HoughAccumulator::vote(const Eigen::Vector3f& position, double weight, int voter)
+{
+  const Eigen::Vector3f cell = position / params_.bin_size;
+  if((cell.array().abs() >= static_cast<float>(BIN_COORDINATE_OFFSET - 1)).any())
+  {
+    return;
+  }
+
+  if(!params_.interpolation)
+  {
+    add(static_cast<std::int64_t>(std::floor(cell.x())), static_cast<std::int64_t>(std::floor(cell.y())),
+        static_cast<std::int64_t>(std::floor(cell.z())), weight, voter);
+    return;
+  }
+
+  // trilinear weights of the 8 bin centers around the vote
+  const Eigen::Vector3f shifted = cell.array() - 0.5f;
+  const Eigen::Vector3f base = shifted.array().floor();
+  const Eigen::Vector3f fraction = shifted - base;
+  for(int corner = 0; corner < 8; corner++)
+  {
+    double corner_weight = weight;
+    std::int64_t coordinates[3];
+    for(int axis = 0; axis < 3; axis++)
+    {
+      const bool upper = (corner >> axis) & 1;
+      corner_weight *= upper ? fraction[axis] : 1.0f - fraction[axis];
+      coordinates[axis] = static_cast<std::int64_t>(base[axis]) + (upper ? 1 : 0);
+    }
+    if(corner_weight > 0.0)
+    {
+      add(coordinates[0], coordinates[1], coordinates[2], corner_weight, voter);
+    }
+  }
+}
+
+void HoughAccumulator::add(std::int64_t x, std::int64_t y, std::int64_t z, double weight, int voter)
+{
+  Bin& bin = bins_[binKey(x, y, z)];
+  bin.weight += weight;
+  bin.voters.push_back(voter);
+}
+
+void HoughAccumulator::merge(const HoughAccumulator& other)
+{
+  for(const std::pair<const std::int64_t, Bin>& entry : other.bins_)
+  {
+    Bin& bin = bins_[entry.first];
+    bin.weight += entry.second.weight;
+    bin.voters.insert(bin.voters.end(), entry.second.voters.begin(), entry.second.voters.end());
+  }
+}
+
+void HoughAccumulator::findMaxima(std::vector<Maximum>& maxima) const
+{
+  maxima.clear();
+  double threshold = params_.threshold;
+  if(threshold < 0.0)
+  {
+    double highest = 0.0;
+    for(const std::pair<const std::int64_t, Bin>& entry : bins_)
+    {
+      highest = std::max(highest, entry.second.weight);
+    }
+    threshold = threshold >= -1.0 ? -threshold * highest : highest;
+  }
+
+  std::vector<std::int64_t> keys;
+  for(const std::pair<const std::int64_t, Bin>& entry : bins_)
+  {
+    if(entry.second.weight < threshold)
+    {
+      continue;
+    }
+
+    bool is_maximum = true;
+    for(std::int64_t dx = -1; dx <= 1 && is_maximum; dx++)
+    {
+      for(std::int64_t dy = -1; dy <= 1 && is_maximum; dy++)
+      {
+        for(std::int64_t dz = -1; dz <= 1 && is_maximum; dz++)
+        {
+          // the key of the neighbor is the key of the bin shifted along each packed coordinate
+          const std::int64_t key = entry.first + dx * (std::int64_t(1) << 42) + dy * (std::int64_t(1) << 21) + dz;
+          if(key == entry.first)
+          {
+            continue;
+          }
+          const std::unordered_map<std::int64_t, Bin>::const_iterator neighbor = bins_.find(key);
+          is_maximum = neighbor == bins_.end() || neighbor->second.weight <= entry.second.weight;
+        }
+      }
+    }
+
+    if(is_maximum)
+    {
+      keys.push_back(entry.first);
+    }
+  }
+
+  // the hash map order is arbitrary, the strongest maximum comes first and ties resolve by key
+  std::sort(keys.begin(), keys.end(), [this](std::int64_t a, std::int64_t b)
+  {
+    const double wa = bins_.at(a).weight;
+    const double wb = bins_.at(b).weight;
+    return wa > wb || (wa == wb && a < b);
+  });
+  for(std::int64_t key : keys)
+  {
+    const Bin& bin = bins_.at(key);
+    Maximum maximum;
+    maximum.weight = bin.weight;
+    maximum.voters = bin.voters;
+    std::sort(maximum.voters.begin(), maximum.voters.end());
+    maximum.voters.erase(std::unique(maximum.voters.begin(), maximum.voters.end()), maximum.voters.end());
+    maxima.push_back(maximum);
+  }
+}
+
+HoughGrouping::HoughGrouping(const HoughParameters& params):
+  params_(params)
+{
+}
+
+void HoughGrouping::recognize(const std::vector<const HoughModel*>& models, const Cloud::ConstPtr& scene_keypoints,
+                              const Frames& scene_rf, const std::vector<pcl::CorrespondencesConstPtr>& corrs,
+                              ThreadPool& pool, const CancellationToken& cancellation,
+                              std::vector<HoughInstances>& instances) const
+{
+  instances.assign(models.size(), HoughInstances());
+
+  // voting, chunks of the correspondences of every model go to worker local accumulators
+  struct Chunk
+  {
+    std::size_t model;
+    std::size_t begin;
+  };
+  std::vector<Chunk> chunks;
+  std::vector<float> max_distances(models.size(), 0.0f);
+  for(std::size_t m = 0; m < models.size(); m++)
+  {
+    for(std::size_t begin = 0; begin < corrs[m]->size(); begin += VOTE_CHUNK_SIZE)
+    {
+      chunks.push_back(Chunk{m, begin});
+    }
+    if(params_.distance_weight)
+    {
+      max_distances[m] = maxDistance(*corrs[m]);
+    }
+  }
+
+  std::vector<std::vector<HoughAccumulator> > accumulators(pool.size(),
+                                                           std::vector<HoughAccumulator>(models.size(),
+                                                                                         HoughAccumulator(params_)));
+  pool.parallelFor(chunks.size(), [&](std::size_t worker_id, std::size_t c)
+  {
+    if(cancellation.isCancelled())
+    {
+      return;
+    }
+    const Chunk& chunk = chunks[c];
+    const pcl::Correspondences& model_corrs = *corrs[chunk.model];
+    vote(*models[chunk.model], *scene_keypoints, scene_rf, model_corrs, chunk.begin,
+         std::min(model_corrs.size(), chunk.begin + VOTE_CHUNK_SIZE), max_distances[chunk.model],
+         accumulators[worker_id][chunk.model]);
+  });
+  if(cancellation.isCancelled())
+  {
+    return;
+  }
+
+  // merge per model and find its maxima
+  std::vector<std::vector<HoughAccumulator::Maximum> > maxima(models.size());
+  pool.parallelFor(models.size(), [&](std::size_t worker_id, std::size_t m)
+  {
+    if(cancellation.isCancelled())
+    {
+      return;
+    }
+    HoughAccumulator& merged = accumulators[0][m];
+    for(std::size_t w = 1; w < accumulators.size(); w++)
+    {
+      merged.merge(accumulators[w][m]);
+    }
+    merged.findMaxima(maxima[m]);
+  });
+  if(cancellation.isCancelled())
+  {
+    return;
+  }
+
+  // a RANSAC run per maximum, over all the models
+  std::vector<std::pair<std::size_t, std::size_t> > clusters;
+  for(std::size_t m = 0; m < models.size(); m++)
+  {
+    instances[m].transformations.resize(maxima[m].size());
+    instances[m].clustered_corrs.resize(maxima[m].size());
+    for(std::size_t k = 0; k < maxima[m].size(); k++)
+    {
+      clusters.push_back(std::make_pair(m, k));
+    }
+  }
+
+  pool.parallelFor(clusters.size(), [&](std::size_t worker_id, std::size_t c)
+  {
+    if(cancellation.isCancelled())
+    {
+      return;
+    }
+    const std::size_t m = clusters[c].first;
+    const std::size_t k = clusters[c].second;
+    cluster(*models[m], scene_keypoints, *corrs[m], maxima[m][k], instances[m].transformations[k],
+            instances[m].clustered_corrs[k]);
+  });
+  if(cancellation.isCancelled())
+  {
+    instances.assign(models.size(), HoughInstances());
+  }
+}
+
+void HoughGrouping::recognize(const HoughModel& model, const Cloud::ConstPtr& scene_keypoints, const Frames& scene_rf,
+                              const pcl::Correspondences& corrs, HoughInstances& instances) const
+{
+  HoughAccumulator accumulator(params_);
+  vote(model, *scene_keypoints, scene_rf, corrs, 0, corrs.size(), params_.distance_weight ? maxDistance(corrs) : 0.0f,
+       accumulator);
+
+  std::vector<HoughAccumulator::Maximum> maxima;
+  accumulator.findMaxima(maxima);
+  instances.transformations.resize(maxima.size());
+  instances.clustered_corrs.resize(maxima.size());
+  for(std::size_t k = 0; k < maxima.size(); k++)
+  {
+    cluster(model, scene_keypoints, corrs, maxima[k], instances.transformations[k], instances.clustered_corrs[k]);
+  }
+}
+
+void HoughGrouping::vote(const HoughModel& model, const Cloud& scene_keypoints, const Frames& scene_rf,
+                         const pcl::Correspondences& corrs, std::size_t begin, std::size_t end, float max_distance,
+                         HoughAccumulator& accumulator) const
+{
+  const HoughVotes& votes = model.getVotes();
+  for(std::size_t i = begin; i < end; i++)
+  {
+    const pcl::Correspondence& corr = corrs[i];
+    if(corr.index_query < 0 || corr.index_query >= static_cast<int>(votes.size()) || corr.index_match < 0 ||
+       corr.index_match >= static_cast<int>(scene_rf.size()))
+    {
+      continue;
+    }
+
+    const Eigen::Vector3f& model_vote = votes[corr.index_query];
+    const pcl::ReferenceFrame& frame = scene_rf.points[corr.index_match];
+    if(!pcl_isfinite(model_vote.x()) || !isFinite(frame))
+    {
+      continue;
+    }
+
+    const Eigen::Vector3f position = Eigen::Map<const Eigen::Vector3f>(frame.x_axis) * model_vote.x() +
+                                     Eigen::Map<const Eigen::Vector3f>(frame.y_axis) * model_vote.y() +
+                                     Eigen::Map<const Eigen::Vector3f>(frame.z_axis) * model_vote.z() +
+                                     scene_keypoints.points[corr.index_match].getVector3fMap();
+    double weight = 1.0;
+    if(params_.distance_weight && max_distance > 0.0f)
+    {
+      weight = 1.0 - corr.distance / max_distance;
+    }
+    accumulator.vote(position, weight, static_cast<int>(i));
+  }
+}
+
+void HoughGrouping::cluster(const HoughModel& model, const Cloud::ConstPtr& scene_keypoints,
+                            const pcl::Correspondences& corrs, const HoughAccumulator::Maximum& maximum,
+                            Eigen::Matrix4f& transformation, pcl::Correspondences& clustered) const
+{
+  pcl::Correspondences voters;
+  voters.reserve(maximum.voters.size());
+  for(int voter : maximum.voters)
+  {
+    voters.push_back(corrs[voter]);
+  }
+
+  pcl::registration::CorrespondenceRejectorSampleConsensus<pcl::PointXYZ> rejector;
+  rejector.setMaximumIterations(params_.ransac_iterations);
+  rejector.setInlierThreshold(params_.bin_size);
+  rejector.setInputSource(model.getKeypoints());
+  rejector.setInputTarget(scene_keypoints);
+  rejector.getRemainingCorrespondences(voters, clustered);
+  transformation = rejector.getBestTransformation();
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,82 @@
+#include "gilbreth_perception/hypothesis_verifier.h"
+#include <Eigen/Geometry>
+#include <random>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+HypothesisVerifier::HypothesisVerifier(const VerificationParameters& params):
+  params_(params)
+{
+}
+
+std::size_t HypothesisVerifier::addModel(const Cloud& model)
+{
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > points;
+  points.reserve(model.size());
+  for(const pcl::PointXYZ& point : model.points)
+  {
+    if(pcl_isfinite(point.x) && pcl_isfinite(point.y) && pcl_isfinite(point.z))
+    {
+      points.push_back(point.getVector3fMap());
+    }
+  }
+
+  // seeded per model so that the order, and so the decisions, do not depend on the other models
+  std::mt19937 generator(params_.seed + static_cast<unsigned int>(models_.size()));
+  std::shuffle(points.begin(), points.end(), generator);
+  models_.push_back(points);
+  return models_.size() - 1;
+}
+
+bool HypothesisVerifier::verify(std::size_t model_id, const Search& scene_tree,
+                                const Eigen::Matrix4f& model_to_scene, float target_ratio,
+                                VerificationResult& result) const
+{
+  result.inlier_ratio = 0.0f;
+  result.fitness_score = std::numeric_limits<float>::max();
+  result.evaluated = 0;
+  result.rejected = false;
+  if(model_id >= models_.size() || models_[model_id].empty())
+  {
+    return false;
+  }
+
+  SequentialInlierTest test(target_ratio, params_);
+  const Eigen::Affine3f pose(model_to_scene);
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+  std::size_t inliers = 0;
+  double fitness = 0.0;
+  for(const Eigen::Vector3f& point : models_[model_id])
+  {
+    pcl::PointXYZ transformed;
+    transformed.getVector3fMap() = pose * point;
+    const bool inlier = scene_tree.nearestKSearch(transformed, 1, nn_indices, nn_dists) > 0 &&
+                        nn_dists[0] <= params_.max_sqr_distance;
+    if(inlier)
+    {
+      fitness += nn_dists[0];
+      inliers++;
+    }
+    result.evaluated++;
+
+    if(!test.add(inlier))
+    {
+      result.rejected = true;
+      break;
+    }
+  }
+
+  result.inlier_ratio = static_cast<float>(inliers) / result.evaluated;
+  if(inliers > 0)
+  {
+    result.fitness_score = static_cast<float>(fitness / inliers);
+  }
+  return !result.rejected;
+}
+
+} // namespace perception
+} // namespace gilbreth
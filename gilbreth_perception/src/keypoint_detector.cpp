@@ -0,0 +1,165 @@
+#include "gilbreth_perception/keypoint_detector.h"
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <pcl/keypoints/uniform_sampling.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+void UniformKeypointDetector::detect(const Cloud::ConstPtr& cloud, const Normals& normals, const Search& search,
+                                     std::size_t budget, Cloud& keypoints) const
+{
+  Cloud sampled;
+  pcl::UniformSampling<pcl::PointXYZ> uniform_sampling;
+  uniform_sampling.setInputCloud(cloud);
+  uniform_sampling.setRadiusSearch(params_.spacing);
+  uniform_sampling.filter(sampled);
+
+  keypoints.clear();
+  if(budget == 0 || sampled.size() <= budget)
+  {
+    keypoints = sampled;
+    return;
+  }
+
+  // the samples follow the voxel order, taking them at a regular stride keeps them spread over the whole cloud
+  for(std::size_t i = 0; i < budget; i++)
+  {
+    keypoints.push_back(sampled[i * sampled.size() / budget]);
+  }
+}
+
+template <typename Derived>
+void SalientKeypointDetector<Derived>::detect(const Cloud::ConstPtr& cloud, const Normals& normals,
+                                              const Search& search, std::size_t budget, Cloud& keypoints) const
+{
+  const Derived& measure = static_cast<const Derived&>(*this);
+  keypoints.clear();
+  std::vector<std::pair<float, int> > candidates;
+  std::vector<int> neighbors;
+  std::vector<float> sqr_distances;
+  for(std::size_t i = 0; i < cloud->size(); i++)
+  {
+    const pcl::PointXYZ& point = cloud->points[i];
+    if(!pcl_isfinite(point.x) || !pcl_isfinite(point.y) || !pcl_isfinite(point.z))
+    {
+      continue;
+    }
+
+    float value;
+    if(search.radiusSearch(point, params_.salient_radius, neighbors, sqr_distances) >= params_.min_neighbors &&
+       measure.saliency(*cloud, normals, neighbors, value))
+    {
+      candidates.push_back(std::make_pair(-value, static_cast<int>(i)));
+    }
+  }
+
+  // most salient first, ties keep the lower index so the selection is deterministic
+  std::sort(candidates.begin(), candidates.end());
+  std::vector<bool> suppressed(cloud->size(), false);
+  for(const std::pair<float, int>& candidate : candidates)
+  {
+    if(budget > 0 && keypoints.size() >= budget)
+    {
+      break;
+    }
+    if(suppressed[candidate.second])
+    {
+      continue;
+    }
+
+    keypoints.push_back(cloud->points[candidate.second]);
+    search.radiusSearch(cloud->points[candidate.second], params_.spacing, neighbors, sqr_distances);
+    for(int neighbor : neighbors)
+    {
+      suppressed[neighbor] = true;
+    }
+  }
+}
+
+bool IssKeypointDetector::saliency(const Cloud& cloud, const Normals& normals, const std::vector<int>& neighbors,
+                                   float& value) const
+{
+  Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+  for(int index : neighbors)
+  {
+    mean += cloud.points[index].getVector3fMap();
+  }
+  mean /= static_cast<float>(neighbors.size());
+
+  Eigen::Matrix3f scatter = Eigen::Matrix3f::Zero();
+  for(int index : neighbors)
+  {
+    const Eigen::Vector3f d = cloud.points[index].getVector3fMap() - mean;
+    scatter += d * d.transpose();
+  }
+  scatter /= static_cast<float>(neighbors.size());
+
+  // increasing eigenvalues
+  const Eigen::Vector3f eigenvalues = Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f>(scatter,
+                                                                                      Eigen::EigenvaluesOnly).eigenvalues();
+  if(eigenvalues[2] <= 0.0f || eigenvalues[1] <= 0.0f ||
+     eigenvalues[1] / eigenvalues[2] >= params_.gamma_21 || eigenvalues[0] / eigenvalues[1] >= params_.gamma_32)
+  {
+    return false;
+  }
+
+  value = eigenvalues[0];
+  return true;
+}
+
+bool HarrisKeypointDetector::saliency(const Cloud& cloud, const Normals& normals, const std::vector<int>& neighbors,
+                                      float& value) const
+{
+  Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+  int count = 0;
+  for(int index : neighbors)
+  {
+    const pcl::Normal& normal = normals.points[index];
+    if(!pcl_isfinite(normal.normal_x))
+    {
+      continue;
+    }
+    const Eigen::Vector3f n = normal.getNormalVector3fMap();
+    covariance += n * n.transpose();
+    count++;
+  }
+
+  if(count < params_.min_neighbors)
+  {
+    return false;
+  }
+
+  // the trace of the covariance of unit normals is 1 and its determinant at most 1/27, so the response is negative
+  // for the usual k and the points are only ranked by it: -k on planes and edges, closest to 0 on corners
+  covariance /= static_cast<float>(count);
+  const float trace = covariance.trace();
+  value = covariance.determinant() - params_.harris_k * trace * trace;
+  return true;
+}
+
+template class SalientKeypointDetector<IssKeypointDetector>;
+template class SalientKeypointDetector<HarrisKeypointDetector>;
+
+std::unique_ptr<KeypointDetector> createKeypointDetector(const KeypointParameters& params)
+{
+  std::unique_ptr<KeypointDetector> detector;
+  if(params.method == "uniform")
+  {
+    detector.reset(new UniformKeypointDetector(params));
+  }
+  else if(params.method == "iss")
+  {
+    detector.reset(new IssKeypointDetector(params));
+  }
+  else if(params.method == "harris")
+  {
+    detector.reset(new HarrisKeypointDetector(params));
+  }
+  return detector;
+}
+
+} // namespace perception
+} // namespace gilbreth
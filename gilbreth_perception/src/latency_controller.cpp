@@ -0,0 +1,120 @@
+#include "gilbreth_perception/latency_controller.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+float interpolate(float nominal, float degraded, double level)
+{
+  return nominal + static_cast<float>(level) * (degraded - nominal);
+}
+
+int interpolate(int nominal, int degraded, double level)
+{
+  return nominal + static_cast<int>(std::lround(level * (degraded - nominal)));
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+LatencyController::LatencyController(const LatencyControllerParameters& params, const OperatingRange& range):
+  params_(params),
+  range_(range),
+  smoothed_latency_(0.0),
+  predicted_latency_(0.0),
+  queue_depth_(0)
+{
+  std::fill(levels_, levels_ + KNOB_COUNT, 0.0);
+}
+
+void LatencyController::assignStage(const std::string& stage, Knob knob)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stage_knobs_[stage] = knob;
+}
+
+OperatingPoint LatencyController::getOperatingPoint() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  OperatingPoint point;
+  point.leaf_size = interpolate(range_.leaf_size, range_.max_leaf_size, levels_[RESOLUTION]);
+  point.keypoint_budget = interpolate(range_.keypoint_budget, range_.min_keypoint_budget, levels_[KEYPOINTS]);
+  point.icp_iterations = interpolate(range_.icp_iterations, range_.min_icp_iterations, levels_[ITERATIONS]);
+  point.predicted_latency = predicted_latency_;
+  point.queue_depth = queue_depth_;
+  return point;
+}
+
+void LatencyController::update(const std::vector<StageTimer::Stage>& stages, double latency,
+                               std::size_t queue_depth, std::size_t workers)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  smoothed_latency_ = smoothed_latency_ > 0.0 ?
+                        (1.0 - params_.smoothing) * smoothed_latency_ + params_.smoothing * latency : latency;
+  predicted_latency_ = smoothed_latency_ * (1.0 + static_cast<double>(queue_depth) / std::max<std::size_t>(1, workers));
+  queue_depth_ = queue_depth;
+  if(!isEnabled())
+  {
+    return;
+  }
+
+  const double ratio = predicted_latency_ / params_.target_latency;
+  if(ratio > 1.0)
+  {
+    // the knobs whose stages took the most time on this cloud take most of the correction
+    double costs[KNOB_COUNT] = {0.0, 0.0, 0.0};
+    double total = 0.0;
+    for(const StageTimer::Stage& stage : stages)
+    {
+      const std::map<std::string, Knob>::const_iterator it = stage_knobs_.find(stage.name);
+      const Knob knob = it != stage_knobs_.end() ? it->second : RESOLUTION;
+      if(isAdjustable(knob))
+      {
+        costs[knob] += stage.duration;
+        total += stage.duration;
+      }
+    }
+
+    if(total <= 0.0)
+    {
+      return;
+    }
+
+    const double step = params_.gain * std::min(1.0, ratio - 1.0);
+    for(int k = 0; k < KNOB_COUNT; k++)
+    {
+      levels_[k] = std::min(1.0, levels_[k] + step * costs[k] / total);
+    }
+  }
+  else if(ratio < params_.headroom)
+  {
+    const double step = params_.gain * (1.0 - ratio / params_.headroom);
+    for(int k = 0; k < KNOB_COUNT; k++)
+    {
+      levels_[k] = std::max(0.0, levels_[k] - step);
+    }
+  }
+}
+
+bool LatencyController::isAdjustable(Knob knob) const
+{
+  switch(knob)
+  {
+    case RESOLUTION:
+      return range_.max_leaf_size > range_.leaf_size;
+    case KEYPOINTS:
+      return range_.keypoint_budget > range_.min_keypoint_budget && range_.min_keypoint_budget > 0;
+    case ITERATIONS:
+      return range_.icp_iterations > range_.min_icp_iterations && range_.min_icp_iterations > 0;
+    default:
+      return false;
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
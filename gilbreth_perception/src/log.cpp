@@ -0,0 +1,41 @@
+#include "gilbreth_perception/log.h"
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+
+std::mutex stderr_mutex;
+
+void logToStderr(gilbreth::perception::LogLevel level, const std::string& message)
+{
+  if(level < gilbreth::perception::LogLevel::WARN)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(stderr_mutex);
+  std::cerr << (level == gilbreth::perception::LogLevel::WARN ? "[WARN] " : "[ERROR] ") << message << std::endl;
+}
+
+gilbreth::perception::LogSink log_sink = logToStderr;
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+void setLogSink(const LogSink& sink)
+{
+  log_sink = sink ? sink : LogSink(logToStderr);
+}
+
+void log(LogLevel level, const std::string& message)
+{
+  log_sink(level, message);
+}
+
+} // namespace perception
+} // namespace gilbreth
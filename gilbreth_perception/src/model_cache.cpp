@@ -0,0 +1,352 @@
+#include "gilbreth_perception/model_cache.h"
+#include "gilbreth_perception/log.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char CACHE_MAGIC[8] = {'G', 'I', 'L', 'B', 'M', 'D', 'L', 'C'};
+static const std::uint32_t CACHE_VERSION = 3;   /** @brief 2: votes of keypoints without a reference frame are NaN,
+                                                     3: FPFH features of every pyramid level */
+static const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+namespace
+{
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t model_count;
+  std::uint64_t key;
+
+  // sizes of the stored types, a cache written by a build with a different pcl layout is rejected
+  std::uint32_t point_size;
+  std::uint32_t descriptor_size;
+  std::uint32_t rf_size;
+  std::uint32_t feature_size;
+};
+
+struct SectionHeader
+{
+  std::uint64_t count;
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t element_size;
+  std::uint32_t is_dense;
+};
+
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& file_path):
+    data_(nullptr),
+    size_(0)
+  {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+      return;
+    }
+
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void* addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if(addr != MAP_FAILED)
+      {
+        data_ = static_cast<const char*>(addr);
+        size_ = static_cast<std::size_t>(st.st_size);
+      }
+    }
+    ::close(fd);
+  }
+
+  ~MappedFile()
+  {
+    if(data_)
+    {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const
+  {
+    return data_;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  const char* data_;
+  std::size_t size_;
+};
+
+class Reader
+{
+public:
+  Reader(const char* data, std::size_t size):
+    data_(data),
+    size_(size),
+    offset_(0)
+  {
+  }
+
+  bool read(void* dst, std::size_t bytes)
+  {
+    if(bytes > remaining())
+    {
+      return false;
+    }
+    std::memcpy(dst, data_ + offset_, bytes);
+    offset_ += bytes;
+    return true;
+  }
+
+  std::size_t remaining() const
+  {
+    return size_ - offset_;
+  }
+
+private:
+  const char* data_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+template <typename PointT>
+bool readCloud(Reader& reader, typename pcl::PointCloud<PointT>::Ptr& cloud)
+{
+  SectionHeader section;
+  if(!reader.read(&section, sizeof(section)) || section.element_size != sizeof(PointT) ||
+     section.count != static_cast<std::uint64_t>(section.width) * section.height ||
+     section.count > reader.remaining() / sizeof(PointT))
+  {
+    return false;
+  }
+
+  cloud.reset(new pcl::PointCloud<PointT>());
+  cloud->points.resize(section.count);
+  if(!reader.read(cloud->points.data(), section.count * sizeof(PointT)))
+  {
+    return false;
+  }
+  cloud->width = section.width;
+  cloud->height = section.height;
+  cloud->is_dense = section.is_dense != 0;
+  return true;
+}
+
+template <typename PointT>
+void writeCloud(std::ofstream& out, const typename pcl::PointCloud<PointT>::Ptr& cloud)
+{
+  SectionHeader section;
+  std::memset(&section, 0, sizeof(section));
+  section.element_size = sizeof(PointT);
+  if(cloud)
+  {
+    section.count = cloud->points.size();
+    section.width = cloud->width;
+    section.height = cloud->height;
+    section.is_dense = cloud->is_dense ? 1 : 0;
+
+    // unorganized clouds built by hand may not have their dimensions set
+    if(section.count != static_cast<std::uint64_t>(section.width) * section.height)
+    {
+      section.width = static_cast<std::uint32_t>(section.count);
+      section.height = 1;
+    }
+  }
+
+  out.write(reinterpret_cast<const char*>(&section), sizeof(section));
+  if(section.count > 0)
+  {
+    out.write(reinterpret_cast<const char*>(cloud->points.data()), section.count * sizeof(PointT));
+  }
+}
+
+FileHeader makeHeader(std::uint64_t key, std::size_t model_count)
+{
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.model_count = static_cast<std::uint32_t>(model_count);
+  header.key = key;
+  header.point_size = sizeof(pcl::PointXYZ);
+  header.descriptor_size = sizeof(pcl::SHOT352);
+  header.rf_size = sizeof(pcl::ReferenceFrame);
+  header.feature_size = sizeof(pcl::FPFHSignature33);
+  return header;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t hash = seed;
+  for(std::size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+std::uint64_t hashString(const std::string& str, std::uint64_t seed)
+{
+  return hashBytes(str.data(), str.size(), seed);
+}
+
+bool hashFile(const std::string& file_path, std::uint64_t& hash)
+{
+  MappedFile file(file_path);
+  if(!file.data())
+  {
+    return false;
+  }
+  hash = hashBytes(file.data(), file.size(), hash);
+  return true;
+}
+
+ModelCache::ModelCache(const std::string& file_path):
+  file_path_(file_path)
+{
+}
+
+bool ModelCache::load(std::uint64_t key, std::vector<CachedModel>& models) const
+{
+  MappedFile file(file_path_);
+  if(!file.data())
+  {
+    return false;
+  }
+
+  Reader reader(file.data(), file.size());
+  FileHeader header;
+  FileHeader expected = makeHeader(key, 0);
+  if(!reader.read(&header, sizeof(header)) || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0)
+  {
+    GILBRETH_WARN_STREAM("Model cache " << file_path_ << " is not a valid cache file");
+    return false;
+  }
+
+  if(header.version != expected.version || header.point_size != expected.point_size ||
+     header.descriptor_size != expected.descriptor_size || header.rf_size != expected.rf_size ||
+     header.feature_size != expected.feature_size)
+  {
+    GILBRETH_WARN_STREAM("Model cache " << file_path_ << " was written with an incompatible format");
+    return false;
+  }
+
+  if(header.key != key)
+  {
+    GILBRETH_INFO_STREAM("Model cache " << file_path_ << " is stale");
+    return false;
+  }
+
+  std::vector<CachedModel> loaded(header.model_count);
+  for(CachedModel& model : loaded)
+  {
+    std::uint64_t level_count = 0;
+    std::uint64_t vote_count = 0;
+    bool complete = readCloud<pcl::PointXYZ>(reader, model.cloud) &&
+                    readCloud<pcl::PointXYZ>(reader, model.keypoints) &&
+                    readCloud<pcl::SHOT352>(reader, model.descriptors) &&
+                    readCloud<pcl::ReferenceFrame>(reader, model.rf) &&
+                    reader.read(&level_count, sizeof(level_count)) &&
+                    level_count <= reader.remaining() / sizeof(SectionHeader);
+    if(complete)
+    {
+      model.features.resize(level_count);
+      for(std::size_t level = 0; complete && level < model.features.size(); level++)
+      {
+        complete = readCloud<pcl::FPFHSignature33>(reader, model.features[level]);
+      }
+    }
+    if(!complete || !reader.read(&vote_count, sizeof(vote_count)) ||
+       vote_count > reader.remaining() / (3 * sizeof(float)))
+    {
+      GILBRETH_WARN_STREAM("Model cache " << file_path_ << " is truncated");
+      return false;
+    }
+
+    model.hough_votes.resize(vote_count);
+    for(Eigen::Vector3f& vote : model.hough_votes)
+    {
+      reader.read(vote.data(), 3 * sizeof(float));
+    }
+  }
+
+  models.swap(loaded);
+  return true;
+}
+
+bool ModelCache::save(std::uint64_t key, const std::vector<CachedModel>& models) const
+{
+  const std::string tmp_path = file_path_ + ".tmp";
+  {
+    std::ofstream out(tmp_path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out)
+    {
+      GILBRETH_WARN_STREAM("Failed to open model cache " << tmp_path << " for writing");
+      return false;
+    }
+
+    FileHeader header = makeHeader(key, models.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(const CachedModel& model : models)
+    {
+      writeCloud<pcl::PointXYZ>(out, model.cloud);
+      writeCloud<pcl::PointXYZ>(out, model.keypoints);
+      writeCloud<pcl::SHOT352>(out, model.descriptors);
+      writeCloud<pcl::ReferenceFrame>(out, model.rf);
+      std::uint64_t level_count = model.features.size();
+      out.write(reinterpret_cast<const char*>(&level_count), sizeof(level_count));
+      for(const pcl::PointCloud<pcl::FPFHSignature33>::Ptr& features : model.features)
+      {
+        writeCloud<pcl::FPFHSignature33>(out, features);
+      }
+
+      std::uint64_t vote_count = model.hough_votes.size();
+      out.write(reinterpret_cast<const char*>(&vote_count), sizeof(vote_count));
+      for(const Eigen::Vector3f& vote : model.hough_votes)
+      {
+        out.write(reinterpret_cast<const char*>(vote.data()), 3 * sizeof(float));
+      }
+    }
+
+    if(!out)
+    {
+      GILBRETH_WARN_STREAM("Failed to write model cache " << tmp_path);
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  if(std::rename(tmp_path.c_str(), file_path_.c_str()) != 0)
+  {
+    GILBRETH_WARN_STREAM("Failed to move model cache into " << file_path_);
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
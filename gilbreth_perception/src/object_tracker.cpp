@@ -0,0 +1,155 @@
+#include "gilbreth_perception/object_tracker.h"
+#include <algorithm>
+#include <limits>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+ObjectTracker::ObjectTracker(const TrackingParameters& params):
+  params_(params),
+  next_id_(0)
+{
+}
+
+bool ObjectTracker::match(const Cloud& cluster, double stamp, TrackPrediction& prediction)
+{
+  Eigen::Vector3f centroid;
+  Eigen::Vector3f extent;
+  const bool described = describe(cluster, centroid, extent);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track& track)
+  {
+    return stamp - track.stamp > params_.max_age;
+  }), tracks_.end());
+
+  if(!described)
+  {
+    stats_.unmatched++;
+    return false;
+  }
+
+  Track* matched = nullptr;
+  int candidates = 0;
+  for(Track& track : tracks_)
+  {
+    if(track.claimed_stamp == stamp)
+    {
+      continue;
+    }
+
+    const Eigen::Vector3f displacement = params_.belt_velocity * static_cast<float>(stamp - track.stamp);
+    if((track.centroid + displacement - centroid).norm() > params_.max_centroid_distance ||
+       (track.extent - extent).cwiseAbs().maxCoeff() > params_.max_extent_difference)
+    {
+      continue;
+    }
+
+    matched = &track;
+    candidates++;
+  }
+
+  if(candidates != 1)
+  {
+    candidates == 0 ? stats_.unmatched++ : stats_.ambiguous++;
+    return false;
+  }
+
+  matched->claimed_stamp = stamp;
+  prediction.track_id = matched->id;
+  prediction.name = matched->name;
+  prediction.pose = matched->pose;
+  prediction.pose.block<3, 1>(0, 3) += params_.belt_velocity * static_cast<float>(stamp - matched->stamp);
+  stats_.matched++;
+  return true;
+}
+
+int ObjectTracker::update(int track_id, const std::string& name, const Cloud& cluster, double stamp,
+                          const Eigen::Matrix4f& pose)
+{
+  Eigen::Vector3f centroid;
+  Eigen::Vector3f extent;
+  describe(cluster, centroid, extent);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Track, Eigen::aligned_allocator<Track> >::iterator it =
+      std::find_if(tracks_.begin(), tracks_.end(), [&](const Track& track) { return track.id == track_id; });
+  if(track_id < 0 || it == tracks_.end())
+  {
+    Track track;
+    track.id = next_id_++;
+    track.claimed_stamp = stamp;
+    tracks_.push_back(track);
+    it = tracks_.end() - 1;
+  }
+
+  it->name = name;
+  it->pose = pose;
+  it->centroid = centroid;
+  it->extent = extent;
+  it->stamp = stamp;
+  return it->id;
+}
+
+void ObjectTracker::drop(int track_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track& track)
+  {
+    return track.id == track_id;
+  }), tracks_.end());
+}
+
+void ObjectTracker::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.clear();
+}
+
+std::size_t ObjectTracker::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tracks_.size();
+}
+
+TrackerStats ObjectTracker::getStats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool ObjectTracker::describe(const Cloud& cluster, Eigen::Vector3f& centroid, Eigen::Vector3f& extent)
+{
+  Eigen::Vector3f min_point = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_point = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+  Eigen::Vector3f sum = Eigen::Vector3f::Zero();
+  std::size_t count = 0;
+  for(const pcl::PointXYZ& point : cluster.points)
+  {
+    if(!pcl_isfinite(point.x) || !pcl_isfinite(point.y) || !pcl_isfinite(point.z))
+    {
+      continue;
+    }
+    const Eigen::Vector3f p = point.getVector3fMap();
+    min_point = min_point.cwiseMin(p);
+    max_point = max_point.cwiseMax(p);
+    sum += p;
+    count++;
+  }
+
+  if(count == 0)
+  {
+    centroid.setZero();
+    extent.setZero();
+    return false;
+  }
+
+  centroid = sum / static_cast<float>(count);
+  extent = max_point - min_point;
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
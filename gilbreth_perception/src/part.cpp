@@ -0,0 +1,48 @@
+#include "gilbreth_perception/part.h"
+#include "gilbreth_perception/log.h"
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+bool loadPartCloud(const std::string& path, float leaf_size, pcl::PointCloud<pcl::PointXYZ>::Ptr& cloud)
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr raw(new pcl::PointCloud<pcl::PointXYZ>());
+  if(pcl::io::loadPCDFile(path, *raw) < 0)
+  {
+    GILBRETH_ERROR_STREAM("Error loading model cloud " << path);
+    return false;
+  }
+
+  if(leaf_size <= 0.0f)
+  {
+    cloud = raw;
+    return true;
+  }
+
+  cloud.reset(new pcl::PointCloud<pcl::PointXYZ>());
+  pcl::VoxelGrid<pcl::PointXYZ> sor;
+  sor.setInputCloud(raw);
+  sor.setLeafSize(leaf_size, leaf_size, leaf_size);
+  sor.filter(*cloud);
+  return true;
+}
+
+bool setPickPoint(const PartDescription& part, Detection& detection)
+{
+  if(part.pick_pose.size() != 6)
+  {
+    return false;
+  }
+
+  const Eigen::Vector3f pick_point(part.pick_pose[0], part.pick_pose[1], part.pick_pose[2]);
+  detection.pick_position = detection.pose.block<3, 3>(0, 0) * pick_point + detection.pose.block<3, 1>(0, 3);
+  detection.pick_orientation = Eigen::Vector3f(part.pick_pose[3], part.pick_pose[4], part.pick_pose[5]);
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,67 @@
+#include "gilbreth_perception/part_list.h"
+#include <ros/console.h>
+#include <XmlRpcException.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+bool loadSymmetry(XmlRpc::XmlRpcValue& part, Symmetry& symmetry)
+{
+  symmetry = Symmetry();
+  if(!part.hasMember("symmetry"))
+  {
+    return true;
+  }
+
+  XmlRpc::XmlRpcValue& entry = part["symmetry"];
+  const std::string type = static_cast<std::string>(entry["type"]);
+  const int order = type == "n_fold" ? static_cast<int>(entry["order"]) : 1;
+  if(!parseSymmetry(type, order, symmetry))
+  {
+    return false;
+  }
+
+  if(entry.hasMember("axis"))
+  {
+    XmlRpc::XmlRpcValue& axis = entry["axis"];
+    symmetry.axis = Eigen::Vector3f(static_cast<double>(axis[0]), static_cast<double>(axis[1]),
+                                    static_cast<double>(axis[2])).normalized();
+  }
+  return true;
+}
+
+bool loadPartList(XmlRpc::XmlRpcValue& part_list, const std::string& package_path,
+                  std::vector<PartDescription>& parts)
+{
+  std::vector<PartDescription> loaded(part_list.size());
+  for(int i = 0; i < part_list.size(); i++)
+  {
+    PartDescription& part = loaded[i];
+    part.name = static_cast<std::string>(part_list[i]["name"]);
+    part.path = package_path + static_cast<std::string>(part_list[i]["path"]);
+    part.entry = part_list[i].toXml();
+    if(!loadSymmetry(part_list[i], part.symmetry))
+    {
+      ROS_ERROR_STREAM("Invalid symmetry entry for model " << part.name);
+      return false;
+    }
+    for(int j = 0; j < part_list[i]["pick_pose"].size(); j++)
+    {
+      part.pick_pose.push_back(static_cast<double>(part_list[i]["pick_pose"][j]));
+    }
+    if(part.pick_pose.size() != 6)
+    {
+      ROS_ERROR_STREAM("Model " << part.name << " needs a pick_pose of 6 values [x,y,z,rx,ry,rz], got " <<
+                       part.pick_pose.size());
+      return false;
+    }
+  }
+
+  parts.swap(loaded);
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
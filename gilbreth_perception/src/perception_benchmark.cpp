@@ -0,0 +1,480 @@
+#include "gilbreth_perception/log.h"
+#include "gilbreth_perception/part.h"
+#include "gilbreth_perception/recognizer.h"
+#include "gilbreth_perception/segmentation.h"
+#include "gilbreth_perception/stage_timer.h"
+#include "gilbreth_perception/symmetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <pcl/common/centroid.h>
+#include <pcl/console/parse.h>
+#include <pcl/io/pcd_io.h>
+#include <sstream>
+
+/**
+ * Replays recorded camera frames through the segmentation and the recognition without ROS, and reports the
+ * latency of every stage, the throughput and the accuracy against ground truth. Detections are matched to the
+ * closest labelled object of their frame by the distance between the model centroids at both poses, the rotation
+ * error discounts the symmetry of the part.
+ *
+ * The models file has one part per line, "name path x y z roll pitch yaw [none | n_fold order | continuous]",
+ * with the path relative to the models file and the pick pose as in model_list.yaml. The labels file has one object
+ * per line, "scene.pcd name x y z qx qy qz qw", the model to camera pose of the object in the scene, relative to the
+ * scene directory. Lines starting with # are skipped in both.
+ */
+
+typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+
+/**
+ * The core parameters default to the values of config/parameters.yaml
+ */
+struct Parameters
+{
+  gilbreth::perception::SegmentationParameters segmentation;
+  gilbreth::perception::RecognizerParameters recognition;
+  std::string method = "grouping";
+  float match_distance = 0.05f;
+  int repeat = 1;
+  bool verbose = false;
+};
+
+struct Label
+{
+  std::string name;
+  Eigen::Matrix4f pose;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+typedef std::vector<Label, Eigen::aligned_allocator<Label> > Labels;
+
+struct Accuracy
+{
+  std::size_t labels = 0;
+  std::size_t detections = 0;
+  std::size_t matched = 0;      /** @brief detections close to a labelled object */
+  std::size_t correct = 0;      /** @brief matched with the right part */
+  double translation_error = 0.0;
+  double rotation_error = 0.0;
+};
+
+static void printUsage(const char* program)
+{
+  std::cout << "Usage: " << program << " models.txt scene_dir [options]\n"
+            << "  -labels <file>       ground truth of the scenes (scene_dir/labels.txt)\n"
+            << "  -method <name>       grouping, icp, planar or race (grouping)\n"
+            << "  -keypoints <name>    uniform, iss or harris (uniform)\n"
+            << "  -scene_budget <int>  scene keypoints, 0 is unbounded (0)\n"
+            << "  -matching <name>     flann, pca_int8, binary or vocabulary (flann)\n"
+            << "  -registration <name> sac_ia or fgr (sac_ia)\n"
+            << "  -iterations <int>    fine alignment iterations per level (100)\n"
+            << "  -levels <int>        pyramid levels (3)\n"
+            << "  -top_k <int>         models kept by the coarse filter, 0 keeps all (0)\n"
+            << "  -threads <int>       model evaluation workers, 0 uses one per core (0)\n"
+            << "  -down_sample <m>     voxel size of the scenes and models (0.01)\n"
+            << "  -match_distance <m>  between the detected and the labelled model centroids (0.05)\n"
+            << "  -repeat <int>        replays of the scene directory (1)\n"
+            << "  -v                   log the perception core\n";
+}
+
+static double elapsedSeconds(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string directoryOf(const std::string& path)
+{
+  const std::size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+static bool loadParts(const std::string& file_path, std::vector<gilbreth::perception::PartDescription>& parts)
+{
+  std::ifstream file(file_path.c_str());
+  if(!file)
+  {
+    std::cerr << "Could not read the models file " << file_path << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    gilbreth::perception::PartDescription part;
+    std::string path;
+    part.pick_pose.resize(6);
+    fields >> part.name >> path;
+    for(double& value : part.pick_pose)
+    {
+      fields >> value;
+    }
+    if(!fields)
+    {
+      std::cerr << "Malformed models line: " << line << std::endl;
+      return false;
+    }
+
+    std::string symmetry_type = "none";
+    int order = 1;
+    fields >> symmetry_type;
+    if(symmetry_type == "n_fold")
+    {
+      fields >> order;
+    }
+    if(!gilbreth::perception::parseSymmetry(symmetry_type, order, part.symmetry))
+    {
+      std::cerr << "Invalid symmetry of model " << part.name << std::endl;
+      return false;
+    }
+
+    part.path = path[0] == '/' ? path : directoryOf(file_path) + path;
+    part.entry = line;
+    parts.push_back(part);
+  }
+  return !parts.empty();
+}
+
+/**
+ * Labels per scene file, the scenes are replayed in the order of their first label
+ */
+static bool loadLabels(const std::string& file_path, std::vector<std::string>& scenes,
+                       std::map<std::string, Labels>& labels)
+{
+  std::ifstream file(file_path.c_str());
+  if(!file)
+  {
+    std::cerr << "Could not read the labels file " << file_path << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    std::string scene;
+    Label label;
+    float x, y, z, qx, qy, qz, qw;
+    fields >> scene >> label.name >> x >> y >> z >> qx >> qy >> qz >> qw;
+    if(!fields)
+    {
+      std::cerr << "Malformed labels line: " << line << std::endl;
+      return false;
+    }
+
+    label.pose = Eigen::Matrix4f::Identity();
+    label.pose.block<3, 3>(0, 0) = Eigen::Quaternionf(qw, qx, qy, qz).normalized().toRotationMatrix();
+    label.pose.block<3, 1>(0, 3) = Eigen::Vector3f(x, y, z);
+    if(labels.find(scene) == labels.end())
+    {
+      scenes.push_back(scene);
+    }
+    labels[scene].push_back(label);
+  }
+  return !scenes.empty();
+}
+
+/**
+ * Angle between two poses of a part once the spin about its symmetry axis is discounted
+ */
+static double rotationError(const Eigen::Matrix4f& a, const Eigen::Matrix4f& b,
+                            const gilbreth::perception::Symmetry& symmetry)
+{
+  const Eigen::Matrix3f rotation_a = a.block<3, 3>(0, 0);
+  const Eigen::Matrix3f rotation_b = b.block<3, 3>(0, 0);
+  if(symmetry.type == gilbreth::perception::Symmetry::CONTINUOUS)
+  {
+    const float cosine = (rotation_a * symmetry.axis).dot(rotation_b * symmetry.axis);
+    return std::acos(std::max(-1.0f, std::min(1.0f, cosine)));
+  }
+
+  const int order = symmetry.isSymmetric() ? symmetry.order : 1;
+  double error = std::numeric_limits<double>::infinity();
+  for(int k = 0; k < order; k++)
+  {
+    const Eigen::Matrix3f spin = Eigen::AngleAxisf(k * 2.0f * static_cast<float>(M_PI) / order,
+                                                   symmetry.axis).toRotationMatrix();
+    error = std::min(error, static_cast<double>(Eigen::AngleAxisf(rotation_a.transpose() * rotation_b * spin).angle()));
+  }
+  return error;
+}
+
+static Eigen::Vector3f transformPoint(const Eigen::Matrix4f& pose, const Eigen::Vector3f& point)
+{
+  return pose.block<3, 3>(0, 0) * point + pose.block<3, 1>(0, 3);
+}
+
+/**
+ * Greedily matches the detections of a scene to its labelled objects, each object is matched at most once
+ */
+static void score(const std::vector<gilbreth::perception::Detection,
+                                    Eigen::aligned_allocator<gilbreth::perception::Detection> >& detections,
+                  const Labels& labels, const std::vector<gilbreth::perception::PartDescription>& parts,
+                  const std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> >& centroids,
+                  float match_distance, bool verbose, Accuracy& accuracy)
+{
+  std::map<std::string, std::size_t> part_ids;
+  for(std::size_t i = 0; i < parts.size(); i++)
+  {
+    part_ids[parts[i].name] = i;
+  }
+
+  accuracy.labels += labels.size();
+  accuracy.detections += detections.size();
+  std::vector<bool> taken(labels.size(), false);
+  for(const gilbreth::perception::Detection& detection : detections)
+  {
+    const Eigen::Vector3f center = transformPoint(detection.pose, centroids[detection.model_id]);
+    int best = -1;
+    float best_distance = match_distance;
+    for(std::size_t l = 0; l < labels.size(); l++)
+    {
+      std::map<std::string, std::size_t>::const_iterator part = part_ids.find(labels[l].name);
+      if(taken[l] || part == part_ids.end())
+      {
+        continue;
+      }
+      const float distance = (transformPoint(labels[l].pose, centroids[part->second]) - center).norm();
+      if(distance <= best_distance)
+      {
+        best = static_cast<int>(l);
+        best_distance = distance;
+      }
+    }
+
+    if(best == -1)
+    {
+      if(verbose)
+      {
+        std::cout << "  " << detection.name << " matches no labelled object" << std::endl;
+      }
+      continue;
+    }
+
+    taken[best] = true;
+    accuracy.matched++;
+    if(labels[best].name != detection.name)
+    {
+      if(verbose)
+      {
+        std::cout << "  " << detection.name << " is labelled " << labels[best].name << std::endl;
+      }
+      continue;
+    }
+
+    accuracy.correct++;
+    accuracy.translation_error += best_distance;
+    gilbreth::perception::Symmetry symmetry = parts[detection.model_id].symmetry;
+    symmetry.center = centroids[detection.model_id];
+    accuracy.rotation_error += rotationError(labels[best].pose, detection.pose, symmetry);
+  }
+}
+
+static void recordStages(const gilbreth::perception::StageTimer& timer, const std::string& total,
+                         gilbreth::perception::LatencyStatistics& statistics, std::vector<std::string>& stage_names)
+{
+  for(const gilbreth::perception::StageTimer::Stage& stage : timer.getStages())
+  {
+    statistics.add(stage.name, stage.duration);
+    if(std::find(stage_names.begin(), stage_names.end(), stage.name) == stage_names.end())
+    {
+      stage_names.push_back(stage.name);
+    }
+  }
+  statistics.add(total, timer.elapsed());
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 3 || argv[1][0] == '-' || argv[2][0] == '-')
+  {
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  const std::string models_file = argv[1];
+  std::string scene_dir = argv[2];
+  if(scene_dir.back() != '/')
+  {
+    scene_dir += '/';
+  }
+
+  Parameters params;
+  std::string labels_file = scene_dir + "labels.txt";
+  pcl::console::parse_argument(argc, argv, "-labels", labels_file);
+  pcl::console::parse_argument(argc, argv, "-method", params.method);
+  pcl::console::parse_argument(argc, argv, "-keypoints", params.recognition.keypoint_params.method);
+  pcl::console::parse_argument(argc, argv, "-scene_budget", params.recognition.keypoint_scene_budget);
+  pcl::console::parse_argument(argc, argv, "-matching", params.recognition.descriptor_matching);
+  pcl::console::parse_argument(argc, argv, "-registration", params.recognition.registration_method);
+  pcl::console::parse_argument(argc, argv, "-iterations", params.recognition.iterations);
+  pcl::console::parse_argument(argc, argv, "-levels", params.recognition.pyramid_levels);
+  pcl::console::parse_argument(argc, argv, "-top_k", params.recognition.prefilter_top_k);
+  pcl::console::parse_argument(argc, argv, "-threads", params.recognition.threads);
+  pcl::console::parse_argument(argc, argv, "-down_sample", params.recognition.down_sample);
+  pcl::console::parse_argument(argc, argv, "-match_distance", params.match_distance);
+  pcl::console::parse_argument(argc, argv, "-repeat", params.repeat);
+  params.verbose = pcl::console::find_switch(argc, argv, "-v");
+  params.segmentation.down_sample = params.recognition.down_sample;
+
+  if(params.method != "grouping" && params.method != "icp" && params.method != "planar" && params.method != "race")
+  {
+    std::cerr << "Unknown method " << params.method << ", use grouping, icp, planar or race" << std::endl;
+    return -1;
+  }
+  params.recognition.icp = params.method == "icp";
+  params.recognition.planar = params.method == "planar";
+  params.recognition.race = params.method == "race";
+
+  // the core only reports warnings and errors unless asked
+  gilbreth::perception::setLogSink([&params](gilbreth::perception::LogLevel level, const std::string& message)
+  {
+    if(params.verbose || level >= gilbreth::perception::LogLevel::WARN)
+    {
+      std::cerr << message << std::endl;
+    }
+  });
+
+  std::vector<gilbreth::perception::PartDescription> parts;
+  std::vector<std::string> scenes;
+  std::map<std::string, Labels> labels;
+  if(!loadParts(models_file, parts) || !loadLabels(labels_file, scenes, labels))
+  {
+    return -1;
+  }
+
+  // model centroids anchor the comparison of detected and labelled poses
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > centroids;
+  for(const gilbreth::perception::PartDescription& part : parts)
+  {
+    Cloud::Ptr model;
+    if(!gilbreth::perception::loadPartCloud(part.path, params.recognition.down_sample, model))
+    {
+      return -1;
+    }
+    Eigen::Vector4f centroid;
+    pcl::compute3DCentroid(*model, centroid);
+    centroids.push_back(centroid.head<3>());
+  }
+
+  std::vector<Cloud::Ptr> scene_clouds;
+  for(const std::string& scene : scenes)
+  {
+    Cloud::Ptr cloud(new Cloud());
+    if(pcl::io::loadPCDFile(scene_dir + scene, *cloud) < 0)
+    {
+      std::cerr << "Could not load scene " << scene_dir + scene << std::endl;
+      return -1;
+    }
+    scene_clouds.push_back(cloud);
+  }
+
+  const gilbreth::perception::Segmenter segmenter(params.segmentation);
+  std::unique_ptr<gilbreth::perception::Recognizer> recognizer =
+      gilbreth::perception::Recognizer::create(params.recognition);
+  if(!recognizer)
+  {
+    return -1;
+  }
+
+  const std::chrono::steady_clock::time_point preparation_start = std::chrono::steady_clock::now();
+  if(!recognizer->loadCatalogue(parts))
+  {
+    return -1;
+  }
+  const double preparation_time = elapsedSeconds(preparation_start);
+
+  std::cout << parts.size() << " models prepared in " << std::fixed << std::setprecision(3) << preparation_time <<
+               " s, " << scenes.size() << " scenes replayed " << params.repeat << " times with the " << params.method <<
+               " method" << std::endl;
+
+  // every stage of every cluster is kept
+  gilbreth::perception::LatencyStatistics statistics(std::numeric_limits<std::size_t>::max());
+  std::vector<std::string> stage_names;
+  Accuracy accuracy;
+  std::size_t frames = 0;
+  std::size_t clusters = 0;
+  std::size_t recognized = 0;
+  const gilbreth::perception::OperatingPoint operating_point = recognizer->getNominalOperatingPoint();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int r = 0; r < params.repeat; r++)
+  {
+    for(std::size_t s = 0; s < scenes.size(); s++)
+    {
+      frames++;
+      std::vector<Cloud::Ptr> scene_clusters;
+      gilbreth::perception::StageTimer segmentation_timer;
+      segmenter.segment(scene_clouds[s], segmentation_timer, scene_clusters);
+      recordStages(segmentation_timer, "segmentation_total", statistics, stage_names);
+
+      std::vector<gilbreth::perception::Detection, Eigen::aligned_allocator<gilbreth::perception::Detection> > found;
+      for(const Cloud::Ptr& cluster : scene_clusters)
+      {
+        clusters++;
+        gilbreth::perception::StageTimer timer;
+        timer.setPoints(cluster->size());
+        const double stamp = elapsedSeconds(start);
+        if(recognizer->recognize(cluster, stamp, operating_point, timer,
+                                 [&found](const gilbreth::perception::Detection& detection)
+        {
+          found.push_back(detection);
+        }))
+        {
+          recognized++;
+        }
+        recordStages(timer, "recognition_total", statistics, stage_names);
+      }
+
+      // every replay is scored, a detection that changes between replays shows in the accuracy
+      if(params.verbose)
+      {
+        std::cout << scenes[s] << ": " << scene_clusters.size() << " clusters, " << found.size() << " detections" <<
+                     std::endl;
+      }
+      score(found, labels[scenes[s]], parts, centroids, params.match_distance, params.verbose, accuracy);
+    }
+  }
+  const double total_time = elapsedSeconds(start);
+
+  std::cout << "\nstage                 p50 (ms)   p95 (ms)   p99 (ms)   samples\n";
+  stage_names.push_back("segmentation_total");
+  stage_names.push_back("recognition_total");
+  for(const std::string& stage : stage_names)
+  {
+    const gilbreth::perception::LatencyStatistics::Percentiles percentiles = statistics.getPercentiles(stage);
+    std::cout << std::left << std::setw(20) << stage << std::right << std::setprecision(3) <<
+                 std::setw(11) << percentiles.p50 * 1000.0 << std::setw(11) << percentiles.p95 * 1000.0 <<
+                 std::setw(11) << percentiles.p99 * 1000.0 << std::setw(10) << percentiles.samples << "\n";
+  }
+
+  std::cout << "\nthroughput: " << std::setprecision(2) << frames / total_time << " scenes/s, " <<
+               clusters / total_time << " clusters/s (" << recognized << " of " << clusters << " clusters recognized)\n";
+
+  const double correct = static_cast<double>(accuracy.correct);
+  std::cout << std::setprecision(3) << "accuracy: " << accuracy.correct << " correct of " << accuracy.labels <<
+               " labelled objects and " << accuracy.detections << " detections\n" <<
+               "  recall " << (accuracy.labels ? correct / accuracy.labels : 0.0) <<
+               ", precision " << (accuracy.detections ? correct / accuracy.detections : 0.0) <<
+               ", label accuracy " << (accuracy.matched ? correct / accuracy.matched : 0.0) << "\n";
+  if(accuracy.correct > 0)
+  {
+    std::cout << "  mean translation error " << accuracy.translation_error / correct * 1000.0 << " mm, " <<
+                 "mean rotation error " << accuracy.rotation_error / correct * 180.0 / M_PI << " deg" << std::endl;
+  }
+  return 0;
+}
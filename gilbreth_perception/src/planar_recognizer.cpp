@@ -0,0 +1,198 @@
+#include "gilbreth_perception/planar_recognizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <pcl/common/centroid.h>
+
+static const std::size_t MAX_SWEEP_POINTS = 256;
+static const std::size_t MIN_CORRESPONDENCES = 3;
+static const float PARALLEL_AXIS_COS = 0.99f;
+
+namespace gilbreth
+{
+namespace perception
+{
+
+PlanarRecognizer::PlanarRecognizer(const PlanarParameters& params):
+  params_(params)
+{
+  params_.plane_normal.normalize();
+  e1_ = params_.plane_normal.unitOrthogonal();
+  e2_ = params_.plane_normal.cross(e1_);
+}
+
+std::size_t PlanarRecognizer::addModel(const Cloud::ConstPtr& model, const Symmetry& symmetry)
+{
+  Model m;
+  m.cloud = model;
+  m.tree.reset(new pcl::search::KdTree<pcl::PointXYZ>());
+  m.tree->setInputCloud(model);
+
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid(*model, centroid);
+  m.centroid = centroid.head<3>();
+  m.stride = std::max<std::size_t>(1, model->size() / MAX_SWEEP_POINTS);
+  m.symmetry = symmetry;
+
+  // a spin about the belt normal of a part symmetric about that same axis yields an equivalent pose
+  m.yaw_range = 2.0f * static_cast<float>(M_PI);
+  if(symmetry.isSymmetric() && std::abs(symmetry.axis.dot(params_.plane_normal)) > PARALLEL_AXIS_COS)
+  {
+    m.yaw_range = symmetry.period();
+  }
+
+  models_.push_back(m);
+  return models_.size() - 1;
+}
+
+bool PlanarRecognizer::recognize(std::size_t model_id, const Search& scene_tree, PlanarResult& result) const
+{
+  Cloud::ConstPtr scene = scene_tree.getInputCloud();
+  if(model_id >= models_.size() || !scene || scene->empty())
+  {
+    return false;
+  }
+
+  const Model& model = models_[model_id];
+  Eigen::Vector4f scene_centroid;
+  pcl::compute3DCentroid(*scene, scene_centroid);
+
+  // coarse yaw sweep about the normal with the centroids aligned, on a subset of the model points
+  const float full_turn = 2.0f * static_cast<float>(M_PI);
+  const int steps = std::max(1, static_cast<int>(std::round(params_.yaw_steps * model.yaw_range / full_turn)));
+  float best_distance = std::numeric_limits<float>::infinity();
+  Eigen::Affine3f best_guess = Eigen::Affine3f::Identity();
+  for(int k = 0; k < steps; k++)
+  {
+    const float yaw = model.yaw_range * k / steps;
+    Eigen::Affine3f guess = Eigen::Translation3f(scene_centroid.head<3>()) *
+                            Eigen::AngleAxisf(yaw, params_.plane_normal) *
+                            Eigen::Translation3f(-model.centroid);
+    float distance = truncatedDistance(*model.cloud, guess, scene_tree, model.stride);
+    if(distance < best_distance)
+    {
+      best_distance = distance;
+      best_guess = guess;
+    }
+  }
+
+  if(!refine(model_id, scene_tree, best_guess.matrix(), result))
+  {
+    return false;
+  }
+  result.transformation = canonicalizePose(result.transformation, model.symmetry);
+  return true;
+}
+
+bool PlanarRecognizer::refine(std::size_t model_id, const Search& scene_tree, const Eigen::Matrix4f& guess,
+                              PlanarResult& result) const
+{
+  Cloud::ConstPtr scene = scene_tree.getInputCloud();
+  if(model_id >= models_.size() || !scene || scene->empty())
+  {
+    return false;
+  }
+
+  const Model& model = models_[model_id];
+  const float max_sqr_distance = params_.max_correspondence_distance * params_.max_correspondence_distance;
+  Eigen::Affine3f pose(guess);
+  std::vector<int> neigh_indices(1);
+  std::vector<float> neigh_sqr_dists(1);
+  std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f> > source, target;
+
+  result.iterations = 0;
+  for(int it = 0; it < params_.max_iterations; it++)
+  {
+    // closest point correspondences expressed in in-plane coordinates
+    source.clear();
+    target.clear();
+    Eigen::Vector2f source_mean = Eigen::Vector2f::Zero();
+    Eigen::Vector2f target_mean = Eigen::Vector2f::Zero();
+    for(const pcl::PointXYZ& p : model.cloud->points)
+    {
+      pcl::PointXYZ q;
+      q.getVector3fMap() = pose * p.getVector3fMap();
+      if(scene_tree.nearestKSearch(q, 1, neigh_indices, neigh_sqr_dists) == 0 || neigh_sqr_dists[0] > max_sqr_distance)
+      {
+        continue;
+      }
+
+      const pcl::PointXYZ& t = scene->points[neigh_indices[0]];
+      source.push_back(Eigen::Vector2f(e1_.dot(q.getVector3fMap()), e2_.dot(q.getVector3fMap())));
+      target.push_back(Eigen::Vector2f(e1_.dot(t.getVector3fMap()), e2_.dot(t.getVector3fMap())));
+      source_mean += source.back();
+      target_mean += target.back();
+    }
+
+    if(source.size() < MIN_CORRESPONDENCES)
+    {
+      return false;
+    }
+    source_mean /= source.size();
+    target_mean /= source.size();
+
+    // closed form 2D rigid alignment of the correspondences
+    float sum_cos = 0.0f;
+    float sum_sin = 0.0f;
+    for(std::size_t i = 0; i < source.size(); i++)
+    {
+      const Eigen::Vector2f s = source[i] - source_mean;
+      const Eigen::Vector2f t = target[i] - target_mean;
+      sum_cos += s.x() * t.x() + s.y() * t.y();
+      sum_sin += s.x() * t.y() - s.y() * t.x();
+    }
+    const float delta_yaw = std::atan2(sum_sin, sum_cos);
+    const Eigen::Vector2f delta_t = target_mean - Eigen::Rotation2Df(delta_yaw) * source_mean;
+
+    Eigen::Affine3f delta = Eigen::Translation3f(delta_t.x() * e1_ + delta_t.y() * e2_) *
+                            Eigen::AngleAxisf(delta_yaw, params_.plane_normal);
+    pose = delta * pose;
+    result.iterations = it + 1;
+
+    if(std::abs(delta_yaw) < params_.transformation_epsilon && delta_t.norm() < params_.transformation_epsilon)
+    {
+      break;
+    }
+  }
+
+  result.transformation = pose.matrix();
+  result.score = score(model, scene_tree, pose);
+  return true;
+}
+
+float PlanarRecognizer::truncatedDistance(const Cloud& source, const Eigen::Affine3f& pose, const Search& target_tree,
+                                          std::size_t stride) const
+{
+  const float max_sqr_distance = params_.max_correspondence_distance * params_.max_correspondence_distance;
+  std::vector<int> neigh_indices(1);
+  std::vector<float> neigh_sqr_dists(1);
+  float sum = 0.0f;
+  std::size_t count = 0;
+  for(std::size_t i = 0; i < source.size(); i += stride)
+  {
+    pcl::PointXYZ q;
+    q.getVector3fMap() = pose * source[i].getVector3fMap();
+    if(target_tree.nearestKSearch(q, 1, neigh_indices, neigh_sqr_dists) > 0)
+    {
+      sum += std::min(neigh_sqr_dists[0], max_sqr_distance);
+    }
+    else
+    {
+      sum += max_sqr_distance;
+    }
+    count++;
+  }
+  return count > 0 ? sum / count : std::numeric_limits<float>::infinity();
+}
+
+float PlanarRecognizer::score(const Model& model, const Search& scene_tree, const Eigen::Affine3f& pose) const
+{
+  // both directions, otherwise a small part fits anywhere inside a larger cluster
+  const Cloud& scene = *scene_tree.getInputCloud();
+  const float model_to_scene = truncatedDistance(*model.cloud, pose, scene_tree, 1);
+  const float scene_to_model = truncatedDistance(scene, pose.inverse(Eigen::Isometry), *model.tree, 1);
+  return 0.5f * (model_to_scene + scene_to_model);
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,83 @@
+#include "gilbreth_perception/point_cloud2_view.h"
+#include <ros/console.h>
+
+namespace
+{
+
+/**
+ * Offset of a float32 coordinate field, false when it is missing, of another type or beyond the point step
+ */
+bool findCoordinate(const sensor_msgs::PointCloud2& msg, const std::string& name, std::uint32_t& offset)
+{
+  for(const sensor_msgs::PointField& field : msg.fields)
+  {
+    if(field.name != name)
+    {
+      continue;
+    }
+    if(field.datatype != sensor_msgs::PointField::FLOAT32 || field.offset + sizeof(float) > msg.point_step)
+    {
+      ROS_ERROR_STREAM("Point cloud field " << name << " is not a float32 within the point step of " <<
+                       msg.point_step << " bytes");
+      return false;
+    }
+    offset = field.offset;
+    return true;
+  }
+
+  ROS_ERROR_STREAM("Point cloud has no " << name << " field");
+  return false;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+bool makeXyzView(const sensor_msgs::PointCloud2& msg, XyzView& view)
+{
+  std::uint32_t x_offset, y_offset, z_offset;
+  if(!findCoordinate(msg, "x", x_offset) || !findCoordinate(msg, "y", y_offset) ||
+     !findCoordinate(msg, "z", z_offset))
+  {
+    return false;
+  }
+
+  // the coordinates are read as native floats
+  const std::uint16_t probe = 1;
+  const bool host_is_bigendian = *reinterpret_cast<const std::uint8_t*>(&probe) == 0;
+  if(msg.is_bigendian != host_is_bigendian)
+  {
+    ROS_ERROR("Point cloud byte order differs from the host");
+    return false;
+  }
+
+  if(static_cast<std::size_t>(msg.row_step) < static_cast<std::size_t>(msg.width) * msg.point_step ||
+     msg.data.size() < static_cast<std::size_t>(msg.row_step) * msg.height)
+  {
+    ROS_ERROR("Point cloud of %u x %u points of %u bytes does not fit rows of %u bytes in %lu bytes", msg.width,
+              msg.height, msg.point_step, msg.row_step, msg.data.size());
+    return false;
+  }
+
+  view = XyzView(msg.data.data(), msg.width, msg.height, msg.point_step, msg.row_step, x_offset, y_offset, z_offset,
+                 msg.is_dense);
+  return true;
+}
+
+bool copyToCloud(const sensor_msgs::PointCloud2& msg, pcl::PointCloud<pcl::PointXYZ>& cloud)
+{
+  XyzView view;
+  if(!makeXyzView(msg, view))
+  {
+    return false;
+  }
+  view.copyTo(cloud);
+  cloud.header.frame_id = msg.header.frame_id;
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
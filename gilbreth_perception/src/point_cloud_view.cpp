@@ -0,0 +1,77 @@
+#include "gilbreth_perception/point_cloud_view.h"
+#include <cmath>
+#include <cstddef>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+XyzView::XyzView(const std::uint8_t* data, std::size_t width, std::size_t height, std::size_t point_step,
+                 std::size_t row_step, std::uint32_t x_offset, std::uint32_t y_offset, std::uint32_t z_offset,
+                 bool is_dense):
+  data_(data),
+  width_(width),
+  height_(height),
+  point_step_(point_step),
+  row_step_(row_step),
+  x_offset_(x_offset),
+  y_offset_(y_offset),
+  z_offset_(z_offset),
+  is_dense_(is_dense)
+{
+}
+
+XyzView XyzView::fromCloud(const Cloud& cloud)
+{
+  // the points are stored back to back, the rows of an organized cloud included
+  return XyzView(reinterpret_cast<const std::uint8_t*>(cloud.points.data()), cloud.size(), 1,
+                 sizeof(pcl::PointXYZ), cloud.size() * sizeof(pcl::PointXYZ), offsetof(pcl::PointXYZ, x),
+                 offsetof(pcl::PointXYZ, y), offsetof(pcl::PointXYZ, z), cloud.is_dense);
+}
+
+void XyzView::copyTo(Cloud& cloud) const
+{
+  cloud.clear();
+  cloud.reserve(size());
+  for(std::size_t r = 0; r < height_; r++)
+  {
+    const std::uint8_t* points = row(r);
+    for(std::size_t c = 0; c < width_; c++)
+    {
+      const Eigen::Vector3f xyz = point(points, c);
+      if(is_dense_ || xyz.allFinite())
+      {
+        cloud.push_back(pcl::PointXYZ(xyz.x(), xyz.y(), xyz.z()));
+      }
+    }
+  }
+  cloud.width = cloud.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+
+void XyzView::cropTo(const Eigen::Vector3f& min, const Eigen::Vector3f& max, Cloud& cloud) const
+{
+  cloud.clear();
+  for(std::size_t r = 0; r < height_; r++)
+  {
+    const std::uint8_t* points = row(r);
+    for(std::size_t c = 0; c < width_; c++)
+    {
+      // NaN coordinates fail every comparison and are dropped with the points outside
+      const Eigen::Vector3f xyz = point(points, c);
+      if(xyz.x() >= min.x() && xyz.x() <= max.x() && xyz.y() >= min.y() && xyz.y() <= max.y() &&
+         xyz.z() >= min.z() && xyz.z() <= max.z())
+      {
+        cloud.push_back(pcl::PointXYZ(xyz.x(), xyz.y(), xyz.z()));
+      }
+    }
+  }
+  cloud.width = cloud.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -1,79 +1,146 @@
 #include "gilbreth_msgs/ObjectDetection.h"
-#include <cstdio>
-#include <ctime>
-#include <fstream>
+#include "gilbreth_msgs/UpdateModel.h"
+#include "gilbreth_perception/latency_controller.h"
+#include "gilbreth_perception/model_cache.h"
+#include "gilbreth_perception/part_list.h"
+#include "gilbreth_perception/point_cloud2_view.h"
+#include "gilbreth_perception/recognizer.h"
+#include "gilbreth_perception/ros_log.h"
+#include "gilbreth_perception/stage_timer.h"
+#include "gilbreth_perception/timing_publisher.h"
+#include "gilbreth_perception/work_queue.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <geometry_msgs/PointStamped.h>
-#include <iostream>
-#include <pcl/ModelCoefficients.h>
-#include <pcl/common/transforms.h>
+#include <memory>
 #include <pcl/console/parse.h>
-#include <pcl/correspondence.h>
-#include <pcl/features/board.h>
-#include <pcl/features/fpfh.h>
-#include <pcl/features/normal_3d.h>
-#include <pcl/features/normal_3d_omp.h>
-#include <pcl/features/shot_omp.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/filters/voxel_grid.h>
-#include <pcl/io/pcd_io.h>
-#include <pcl/kdtree/impl/kdtree_flann.hpp>
-#include <pcl/kdtree/kdtree_flann.h>
-#include <pcl/keypoints/uniform_sampling.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/recognition/cg/hough_3d.h>
-#include <pcl/registration/ia_ransac.h>
-#include <pcl/registration/icp.h>
-#include <pcl/sample_consensus/method_types.h>
-#include <pcl/sample_consensus/model_types.h>
-#include <pcl/segmentation/extract_clusters.h>
-#include <pcl/segmentation/sac_segmentation.h>
-#include <pcl/visualization/pcl_visualizer.h>
-#include <pcl_conversions/pcl_conversions.h>
+#include <ros/callback_queue.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <tf/transform_listener.h>
+#include <thread>
 #include <XmlRpcException.h>
-#include <boost/format.hpp>
+
+static const std::size_t UPDATE_QUEUE_CAPACITY = 16;
 
 typedef pcl::PointXYZ PointType;
-typedef pcl::Normal NormalType;
-using ModelRecognizer = pcl::Hough3DGrouping<PointType, PointType, pcl::ReferenceFrame, pcl::ReferenceFrame>;
-using ModelRecognizerPtr = std::shared_ptr<ModelRecognizer>;
 
+/**
+ * ROS adapter of the recognizer: queues the clusters published by the segmentation, moves the pick points of the
+ * detections to the world frame and keeps the operating point and the model catalogue up to date.
+ */
 class RecognitionClass {
+private:
+  typedef gilbreth::perception::WorkQueue<sensor_msgs::PointCloud2ConstPtr> InputQueue;
+
+  struct CatalogueUpdate {
+    bool remove;
+    std::string name;
+    XmlRpc::XmlRpcValue entry;   /** new part_list entry when adding or replacing */
+  };
+
+  typedef gilbreth::perception::WorkQueue<CatalogueUpdate> UpdateQueue;
+
 public:
   explicit RecognitionClass(ros::NodeHandle &nh):
     nh_(nh)
   {
-    // initializing parameters
-    descr_dis_thrd = 0.25;
-    descr_rad_cg = 0.02;
-    descr_rad_icp = 0.02;
-    down_sample = 0.01;
-    min_sample_distance = 0.025;
-    max_correspondence_distance = 0.01 * 0.01;
-    nr_iterations = 20;
-    visualizer = false;
-    icp = true;
+    // initializing parameters, the algorithm defaults are those of RecognizerParameters
     cg_size = 0.05;
     cg_thresh = 8.0;
-    print_detailed_info = false;
     key_point_sampling = 0.006;
-    k_nearest_neighbors= 10;
-    iterations=10;
+    input_queue_capacity = 32;
+    input_queue_policy = "block";
+    input_workers = 1;
+    telemetry_window = 200;
+    max_leaf_size = 0.0;
+    min_keypoint_budget = 0;
+    min_iterations = 0;
+  }
+
+  ~RecognitionClass()
+  {
+    if (service_spinner_)
+    {
+      service_spinner_->stop();
+    }
+    stopInputWorkers();
+    stopCatalogueUpdates();
   }
 
   bool run()
   {
 
-    if(!loadParameter() || !loadModel())
+    if(!loadParameter())
+    {
+      return false;
+    }
+
+    recognizer_ = gilbreth::perception::Recognizer::create(params_);
+    if (!recognizer_)
+    {
+      return false;
+    }
+
+    ros::NodeHandle ph("~");
+    ph.getParam("part_list", part_list_);
+    std::vector<gilbreth::perception::PartDescription> parts;
+    if (!loadPartList(part_list_, parts) || !recognizer_->loadCatalogue(parts))
     {
       return false;
     }
 
-    cloud_subs_= nh_.subscribe<sensor_msgs::PointCloud2>("segmentation_result", 1, &RecognitionClass::cloudCallBack, this);
+    // models added at runtime are prepared on their own thread while recognition keeps using the current catalogue
+    catalogue_updates_.reset(new UpdateQueue(UPDATE_QUEUE_CAPACITY, gilbreth::perception::OverflowPolicy::DROP_NEWEST));
+    catalogue_updater_ = std::thread(&RecognitionClass::processCatalogueUpdates, this);
+
+    // the service has its own queue and spinner, so that it still answers while the cloud callback is blocked on a
+    // full input queue
+    ros::NodeHandle service_nh("~");
+    service_nh.setCallbackQueue(&service_queue_);
+    update_model_service_ = service_nh.advertiseService("update_model", &RecognitionClass::updateModel, this);
+    service_spinner_.reset(new ros::AsyncSpinner(1, &service_queue_));
+    service_spinner_->start();
+
+    // stage durations of every cluster, with their percentiles over the last telemetry/window clusters
+    timing_publisher_.reset(new gilbreth::perception::TimingPublisher(nh_, "recognition_timing", "recognition_node",
+                                                                      std::max(1, telemetry_window)));
+
+    // between clusters the controller trades resolution for latency when the stages or the queue run late
+    const gilbreth::perception::OperatingPoint nominal = recognizer_->getNominalOperatingPoint();
+    gilbreth::perception::OperatingRange range;
+    range.leaf_size = nominal.leaf_size;
+    range.max_leaf_size = max_leaf_size;
+    range.keypoint_budget = nominal.keypoint_budget;
+    range.min_keypoint_budget = min_keypoint_budget;
+    range.icp_iterations = nominal.icp_iterations;
+    range.min_icp_iterations = min_iterations;
+    latency_controller_.reset(new gilbreth::perception::LatencyController(latency_params, range));
+    for (const char* stage : {"keypoints", "descriptors", "reference_frames", "matching", "grouping"})
+    {
+      latency_controller_->assignStage(stage, gilbreth::perception::LatencyController::KEYPOINTS);
+    }
+    latency_controller_->assignStage("fine_alignment", gilbreth::perception::LatencyController::ITERATIONS);
+    operating_point_publisher_.reset(new gilbreth::perception::OperatingPointPublisher(
+                                       nh_, "recognition_operating_point", "recognition_node"));
+
+    // segmentation publishes every cluster of a frame back to back, they are queued here and recognized by the
+    // input workers so that none is lost while the previous one is being processed
+    gilbreth::perception::OverflowPolicy policy;
+    gilbreth::perception::parseOverflowPolicy(input_queue_policy, policy);
+    input_queue_.reset(new InputQueue(input_queue_capacity, policy));
+    for (int w = 0; w < input_workers; w++)
+    {
+      input_workers_.emplace_back(&RecognitionClass::processInputQueue, this);
+    }
+    ROS_INFO("Recognition queues up to %lu clusters (%s) for %d input workers", input_queue_->capacity(),
+             input_queue_policy.c_str(), input_workers);
+
+    cloud_subs_= nh_.subscribe<sensor_msgs::PointCloud2>("segmentation_result", input_queue_capacity,
+                                                         &RecognitionClass::cloudCallBack, this);
     pub_tf = nh_.advertise<gilbreth_msgs::ObjectDetection>("recognition_result_world", 10);
 
     return true;
@@ -82,6 +149,7 @@ public:
   bool loadParameter() {
 
     // General parameters
+    gilbreth::perception::RecognizerParameters& params = params_;
     try
     {
       XmlRpc::XmlRpcValue parameter_map;
@@ -89,497 +157,505 @@ public:
       ros::NodeHandle ph("~");
       ph.getParam("recognition", parameter_map);
       ph.getParam("recognition/switches", switch_map);
-      descr_rad_cg = static_cast<double>(parameter_map["descr_rad_cg"]);
-      descr_rad_icp = static_cast<double>(parameter_map["descr_rad_icp"]);
-      down_sample = static_cast<double>(parameter_map["down_sample"]);
-      min_sample_distance = static_cast<double>(parameter_map["min_sample_distance"]);
-      max_correspondence_distance = static_cast<double>(parameter_map["max_correspondence_distance"]);
-      nr_iterations = static_cast<int>(parameter_map["nr_iterations"]);
+      params.descr_rad_cg = static_cast<double>(parameter_map["descr_rad_cg"]);
+      params.descr_rad_icp = static_cast<double>(parameter_map["descr_rad_icp"]);
+      params.down_sample = static_cast<double>(parameter_map["down_sample"]);
+      params.min_sample_distance = static_cast<double>(parameter_map["min_sample_distance"]);
+      params.max_correspondence_distance = static_cast<double>(parameter_map["max_correspondence_distance"]);
+      params.nr_iterations = static_cast<int>(parameter_map["nr_iterations"]);
       cg_size = static_cast<double>(parameter_map["cg_size"]);
       cg_thresh = static_cast<double>(parameter_map["cg_thresh"]);
-      icp = static_cast<bool>(switch_map["ICP"]);
-      print_detailed_info = static_cast<bool>(switch_map["print_detailed_info"]);
-      descr_dis_thrd = static_cast<double>(parameter_map["descr_dis_thrd"]);
+      params.hough_params.bin_size = cg_size;
+      params.hough_params.threshold = cg_thresh;
+      params.icp = static_cast<bool>(switch_map["ICP"]);
+      params.planar = static_cast<bool>(switch_map["planar"]);
+      params.race = static_cast<bool>(switch_map["race"]);
+      params.print_detailed_info = static_cast<bool>(switch_map["print_detailed_info"]);
+      params.descr_dis_thrd = static_cast<double>(parameter_map["descr_dis_thrd"]);
       key_point_sampling = static_cast<double>(parameter_map["key_point_sampling"]);
-      k_nearest_neighbors = static_cast<int>(parameter_map["k_nearest_neighbors"]);
-      iterations=static_cast<int>(parameter_map["iteration"]);
+      params.k_nearest_neighbors = static_cast<int>(parameter_map["k_nearest_neighbors"]);
+      params.iterations = static_cast<int>(parameter_map["iteration"]);
+      params.model_cache_file = static_cast<std::string>(parameter_map["model_cache"]);
+      params.threads = static_cast<int>(parameter_map["threads"]);
+      // the cached models are only valid for the recognition parameters they were prepared with
+      params.cache_seed = gilbreth::perception::hashString(parameter_map.toXml());
+
+      XmlRpc::XmlRpcValue keypoints_map;
+      ph.getParam("recognition/keypoints", keypoints_map);
+      params.keypoint_params.method = static_cast<std::string>(keypoints_map["method"]);
+      params.keypoint_params.spacing = key_point_sampling;
+      params.keypoint_params.salient_radius = static_cast<double>(keypoints_map["salient_radius"]);
+      params.keypoint_scene_budget = static_cast<int>(keypoints_map["scene_budget"]);
+      params.keypoint_model_budget = static_cast<int>(keypoints_map["model_budget"]);
+
+      XmlRpc::XmlRpcValue race_map;
+      ph.getParam("recognition/race", race_map);
+      params.race_min_inlier_ratio = static_cast<double>(race_map["min_inlier_ratio"]);
+      params.race_inlier_distance = static_cast<double>(race_map["inlier_distance"]);
+
+      XmlRpc::XmlRpcValue input_queue_map;
+      ph.getParam("recognition/input_queue", input_queue_map);
+      input_queue_capacity = static_cast<int>(input_queue_map["capacity"]);
+      input_queue_policy = static_cast<std::string>(input_queue_map["policy"]);
+      input_workers = static_cast<int>(input_queue_map["workers"]);
+
+      XmlRpc::XmlRpcValue verification_map;
+      ph.getParam("recognition/verification", verification_map);
+      params.verification_params.decision_threshold = static_cast<double>(verification_map["decision_threshold"]);
+      params.verification_params.bad_inlier_ratio = static_cast<double>(verification_map["bad_inlier_ratio"]);
+      params.verification_inlier_distance = static_cast<double>(verification_map["inlier_distance"]);
+
+      XmlRpc::XmlRpcValue telemetry_map;
+      ph.getParam("recognition/telemetry", telemetry_map);
+      telemetry_window = static_cast<int>(telemetry_map["window"]);
+
+      XmlRpc::XmlRpcValue latency_map;
+      ph.getParam("recognition/latency_control", latency_map);
+      latency_params.target_latency = static_cast<double>(latency_map["target_latency"]);
+      latency_params.gain = static_cast<double>(latency_map["gain"]);
+      latency_params.headroom = static_cast<double>(latency_map["headroom"]);
+      max_leaf_size = static_cast<double>(latency_map["max_leaf_size"]);
+      min_keypoint_budget = static_cast<int>(latency_map["min_keypoint_budget"]);
+      min_iterations = static_cast<int>(latency_map["min_iterations"]);
+
+      XmlRpc::XmlRpcValue tracking_map;
+      ph.getParam("recognition/tracking", tracking_map);
+      params.tracking = static_cast<bool>(tracking_map["enabled"]);
+      params.tracking_params.belt_velocity = Eigen::Vector3f(static_cast<double>(tracking_map["belt_velocity"][0]),
+                                                             static_cast<double>(tracking_map["belt_velocity"][1]),
+                                                             static_cast<double>(tracking_map["belt_velocity"][2]));
+      params.tracking_params.max_centroid_distance = static_cast<double>(tracking_map["max_centroid_distance"]);
+      params.tracking_params.max_extent_difference = static_cast<double>(tracking_map["max_extent_difference"]);
+      params.tracking_params.max_age = static_cast<double>(tracking_map["max_age"]);
+      params.tracking_min_inlier_ratio = static_cast<double>(tracking_map["min_inlier_ratio"]);
+      params.tracking_inlier_distance = static_cast<double>(tracking_map["inlier_distance"]);
+
+      XmlRpc::XmlRpcValue planar_map;
+      ph.getParam("recognition/planar", planar_map);
+      gilbreth::perception::PlanarParameters& planar_params = params.planar_params;
+      planar_params.plane_normal = Eigen::Vector3f(static_cast<double>(planar_map["plane_normal"][0]),
+                                                   static_cast<double>(planar_map["plane_normal"][1]),
+                                                   static_cast<double>(planar_map["plane_normal"][2]));
+      planar_params.yaw_steps = static_cast<int>(planar_map["yaw_steps"]);
+      planar_params.max_iterations = static_cast<int>(planar_map["iterations"]);
+      planar_params.max_correspondence_distance = static_cast<double>(planar_map["max_correspondence_distance"]);
+      planar_params.transformation_epsilon = static_cast<double>(planar_map["transformation_epsilon"]);
+
+      XmlRpc::XmlRpcValue symmetry_map;
+      ph.getParam("recognition/symmetry", symmetry_map);
+      params.symmetry_merge_angle = static_cast<double>(symmetry_map["merge_angle"]);
+      params.symmetry_continuous_divisor = static_cast<int>(symmetry_map["continuous_divisor"]);
+      params.symmetry_stop_inlier_ratio = static_cast<double>(symmetry_map["stop_inlier_ratio"]);
+
+      XmlRpc::XmlRpcValue prefilter_map;
+      ph.getParam("recognition/prefilter", prefilter_map);
+      params.prefilter_top_k = static_cast<int>(prefilter_map["top_k"]);
+
+      XmlRpc::XmlRpcValue spatial_index_map;
+      ph.getParam("recognition/spatial_index", spatial_index_map);
+      params.uniform_grid = static_cast<bool>(spatial_index_map["uniform_grid"]);
+
+      XmlRpc::XmlRpcValue registration_map;
+      ph.getParam("recognition/global_registration", registration_map);
+      params.registration_method = static_cast<std::string>(registration_map["method"]);
+      gilbreth::perception::GlobalRegistrationParameters& global_registration_params =
+          params.global_registration_params;
+      global_registration_params.tuple_scale = static_cast<double>(registration_map["tuple_scale"]);
+      global_registration_params.max_correspondences = static_cast<int>(registration_map["max_correspondences"]);
+      global_registration_params.iterations = static_cast<int>(registration_map["iterations"]);
+      global_registration_params.division_factor = static_cast<double>(registration_map["division_factor"]);
+      global_registration_params.max_correspondence_distance =
+          static_cast<double>(registration_map["max_correspondence_distance"]);
+
+      XmlRpc::XmlRpcValue matching_map;
+      ph.getParam("recognition/descriptor_matching", matching_map);
+      params.descriptor_matching = static_cast<std::string>(matching_map["method"]);
+      params.descriptor_pca_dimensions = static_cast<int>(matching_map["pca_dimensions"]);
+      params.max_hamming_distance = static_cast<int>(matching_map["max_hamming_distance"]);
+
+      XmlRpc::XmlRpcValue vocabulary_map;
+      ph.getParam("recognition/vocabulary", vocabulary_map);
+      params.vocabulary_params.branching = static_cast<int>(vocabulary_map["branching"]);
+      params.vocabulary_params.depth = static_cast<int>(vocabulary_map["depth"]);
+      params.vocabulary_shortlist = static_cast<int>(vocabulary_map["shortlist"]);
+
+      XmlRpc::XmlRpcValue pyramid_map;
+      ph.getParam("recognition/pyramid", pyramid_map);
+      params.pyramid_levels = static_cast<int>(pyramid_map["levels"]);
+
+      // iterations, levels, leaf size and neighbors are completed by the recognizer from the values above
+      XmlRpc::XmlRpcValue fine_alignment_map;
+      ph.getParam("recognition/fine_alignment", fine_alignment_map);
+      gilbreth::perception::FineAlignmentParameters& fine_alignment_params = params.fine_alignment_params;
+      fine_alignment_params.max_correspondence_distance =
+          static_cast<double>(fine_alignment_map["max_correspondence_distance"]);
+      fine_alignment_params.trim_ratio = static_cast<double>(fine_alignment_map["trim_ratio"]);
+      fine_alignment_params.translation_epsilon = static_cast<double>(fine_alignment_map["translation_epsilon"]);
+      fine_alignment_params.rotation_epsilon = static_cast<double>(fine_alignment_map["rotation_epsilon"]);
+      fine_alignment_params.relative_residual_epsilon =
+          static_cast<double>(fine_alignment_map["relative_residual_epsilon"]);
     }
     catch(XmlRpc::XmlRpcException& e)
     {
       ROS_ERROR("Recognition failed to load algorithm parameters: %s",e.getMessage().c_str());
       return false;
     }
-    return true;
-  }
 
-  bool loadModel()
-  {
-    try
+    // the algorithm parameters are validated by Recognizer::create, only those of the node are checked here
+    if (latency_params.target_latency < 0.0 || latency_params.gain <= 0.0 || latency_params.headroom <= 0.0 ||
+        latency_params.headroom > 1.0)
     {
-      // Load model settings
-      XmlRpc::XmlRpcValue model_map;
-      std::string package_path;
-      ros::NodeHandle ph("~");
-      ph.getParam("part_list", model_map);
-      ph.getParam("package_path", package_path);
-
-      ROS_INFO("Loading Point Cloud Models");
-      std::vector<pcl::PointCloud<PointType>::Ptr> model_raw_list;
-      for (int i = 0; i < model_map.size(); i++) {
-        pcl::PointCloud<PointType>::Ptr model_raw(new pcl::PointCloud<PointType>());
-        std::string model_path = model_map[i]["path"];
-        if (pcl::io::loadPCDFile(package_path + model_path, *model_raw) < 0)
-        {
-          ROS_ERROR("Recognition encountered Error loading model cloud.");
-          return false;
-        }
-        model_raw_list.push_back(model_raw);
-        model_names_.push_back(model_map[i]["name"]);
-        std::vector<double> pick_pose_sub;
-        double pick_pose_sub_element;
-        for (int j = 0; j < model_map[i]["pick_pose"].size(); j++) {
-          pick_pose_sub_element = model_map[i]["pick_pose"][j];
-          pick_pose_sub.push_back(pick_pose_sub_element);
-        }
-        pick_pose.push_back(pick_pose_sub);
-      }
-
-      // Downsample models
-      ROS_INFO("Preparing Point Cloud Models");
-      pcl::VoxelGrid<pcl::PointXYZ> sor;
-      for (int i = 0; i < model_raw_list.size(); i++)
-      {
-        pcl::PointCloud<PointType>::Ptr model(new pcl::PointCloud<PointType>());
-        if (down_sample > 0)
-        {
-          sor.setInputCloud(model_raw_list[i]);
-          sor.setLeafSize(down_sample, down_sample, down_sample);
-          sor.filter(*model);
-        }
-        else
-        {
-          model = model_raw_list[i];
-        }
-        model_list.push_back(model);
-      }
-
-      // if use ICP
-      ROS_INFO("Loading Recognition Method Parameters");
-      if (icp) {
-        loadICPConfig();
-      }
-      // if use correspondence grouping
-      else {
-        loadCGConfig();
-      }
+      ROS_ERROR("Recognition latency control needs a target latency of at least 0, a positive gain and a headroom "
+                "in (0, 1]");
+      return false;
     }
-    catch(XmlRpc::XmlRpcException& e)
+
+    gilbreth::perception::OverflowPolicy policy;
+    if (!gilbreth::perception::parseOverflowPolicy(input_queue_policy, policy))
     {
-      ROS_ERROR("Recognition failed to load model parameters: %s",e.getMessage().c_str());
+      ROS_ERROR("Recognition input queue policy '%s' is unknown, use drop_oldest, drop_newest or block",
+                input_queue_policy.c_str());
       return false;
     }
 
+    if (input_queue_capacity < 1 || input_workers < 1)
+    {
+      ROS_ERROR("Recognition input queue needs a capacity and a number of workers of at least 1");
+      return false;
+    }
     return true;
   }
 
-  void loadICPConfig() {
-    pcl::search::KdTree<PointType>::Ptr tree(new pcl::search::KdTree<PointType>());
-    pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
-    std::vector<pcl::PointCloud<NormalType>::Ptr> model_normals_list;
-
-    for (int i = 0; i < model_list.size(); i++) {
-      pcl::PointCloud<NormalType>::Ptr model_normals(new pcl::PointCloud<NormalType>());
-      norm_est.setRadiusSearch(descr_rad_icp);
-      norm_est.setSearchMethod(tree);
-      norm_est.setInputCloud(model_list[i]);
-      norm_est.compute(*model_normals);
-      model_normals_list.push_back(model_normals);
+  /**
+   * Parts of a part_list, with the model paths relative to the package_path parameter
+   */
+  bool loadPartList(XmlRpc::XmlRpcValue& part_list, std::vector<gilbreth::perception::PartDescription>& parts)
+  {
+    std::string package_path;
+    ros::NodeHandle ph("~");
+    ph.getParam("package_path", package_path);
+    try
+    {
+      return gilbreth::perception::loadPartList(part_list, package_path, parts);
     }
-    pcl::FPFHEstimation<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> fpfh_est;
-    for (int i = 0; i < model_list.size(); i++) {
-      pcl::PointCloud<pcl::FPFHSignature33>::Ptr model_features(new pcl::PointCloud<pcl::FPFHSignature33>);
-      fpfh_est.setSearchMethod(tree);
-      fpfh_est.setRadiusSearch(descr_rad_icp);
-      fpfh_est.setInputCloud(model_list[i]);
-      fpfh_est.setInputNormals(model_normals_list[i]);
-      fpfh_est.compute(*model_features);
-      model_features_list.push_back(model_features);
+    catch(XmlRpc::XmlRpcException& e)
+    {
+      ROS_ERROR("Recognition failed to load model parameters: %s",e.getMessage().c_str());
+      return false;
     }
   }
 
-  void loadCGConfig() {
-    //Compute Normals
-    pcl::search::KdTree<PointType>::Ptr tree(new pcl::search::KdTree<PointType>());
-    pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
-    std::vector<pcl::PointCloud<NormalType>::Ptr> model_normals_list;
-
-    for (int i = 0; i < model_list.size(); i++) {
-      pcl::PointCloud<NormalType>::Ptr model_normals(new pcl::PointCloud<NormalType>());
-      norm_est.setKSearch(k_nearest_neighbors);
-      norm_est.setSearchMethod(tree);
-      norm_est.setInputCloud(model_list[i]);
-      norm_est.compute(*model_normals);
-      model_normals_list.push_back(model_normals);
-    }
-    //Extract Keypoints
-    pcl::UniformSampling<PointType> uniform_sampling;
-    for (int i = 0; i < model_list.size(); i++) {
-      pcl::PointCloud<PointType>::Ptr model_keypoints(new pcl::PointCloud<PointType>());
-      uniform_sampling.setInputCloud(model_list[i]);
-      uniform_sampling.setRadiusSearch(key_point_sampling);
-      uniform_sampling.filter(*model_keypoints);
-      model_keypoints_list.push_back(model_keypoints);
-    }
-
-    //Compute Descriptor for Keypoints
-    pcl::SHOTEstimationOMP<PointType, NormalType, pcl::SHOT352> descr_est;
-    descr_est.setRadiusSearch(descr_rad_cg);
-    pcl::BOARDLocalReferenceFrameEstimation<PointType, NormalType, pcl::ReferenceFrame> rf_est;
-
-    for (int i = 0; i < model_list.size(); i++) {
-      pcl::PointCloud<pcl::SHOT352>::Ptr model_descriptors(new pcl::PointCloud<pcl::SHOT352>());
-      descr_est.setInputCloud(model_keypoints_list[i]);
-      descr_est.setInputNormals(model_normals_list[i]);
-      descr_est.setSearchSurface(model_list[i]);
-      descr_est.compute(*model_descriptors);
-      model_descriptor_list.push_back(model_descriptors);
-
-      pcl::PointCloud<pcl::ReferenceFrame>::Ptr model_rf(new pcl::PointCloud<pcl::ReferenceFrame>());
-      rf_est.setFindHoles(true);
-      rf_est.setRadiusSearch(descr_rad_cg);
-      rf_est.setInputCloud(model_keypoints_list[i]);
-      rf_est.setInputNormals(model_normals_list[i]);
-      rf_est.setSearchSurface(model_list[i]);
-      rf_est.compute(*model_rf);
-      model_rf_list.push_back(model_rf);
+  /**
+   * update_model service, validates the request and queues it for the catalogue updater. The call returns before
+   * the model is prepared, the outcome of the update is logged.
+   */
+  bool updateModel(gilbreth_msgs::UpdateModel::Request& req, gilbreth_msgs::UpdateModel::Response& res)
+  {
+    res.success = false;
+    CatalogueUpdate update;
+    update.remove = req.operation == gilbreth_msgs::UpdateModel::Request::REMOVE;
+    update.name = req.name;
+    if (req.name.empty() ||
+        (req.operation != gilbreth_msgs::UpdateModel::Request::ADD && !update.remove))
+    {
+      res.message = "expected the ADD or REMOVE operation and a part name";
+      return true;
     }
 
-    // Creating and training Hough3D Grouping objects
-
-    for(std::size_t i = 0; i < model_list.size() ; i++)
+    if (!update.remove)
     {
-      ModelRecognizerPtr model_recg(new ModelRecognizer());
-      model_recg->setHoughBinSize(cg_size);
-      model_recg->setHoughThreshold(cg_thresh);
-      model_recg->setUseInterpolation(true);
-      model_recg->setUseDistanceWeight(false);
-      model_recg->setInputCloud(model_keypoints_list[i]);
-      model_recg->setInputRf(model_rf_list[i]);
-
-      if(model_recg->train())
+      if (req.path.empty() || req.pick_pose.size() != 6 ||
+          (!req.symmetry_axis.empty() && req.symmetry_axis.size() != 3))
+      {
+        res.message = "expected a model path, a pick pose of 6 values and an empty or 3 value symmetry axis";
+        return true;
+      }
+
+      update.entry["name"] = req.name;
+      update.entry["path"] = req.path;
+      update.entry["pick_pose"].setSize(req.pick_pose.size());
+      for (int j = 0; j < static_cast<int>(req.pick_pose.size()); j++)
       {
-        ROS_INFO_STREAM(boost::str(boost::format("Hough3D algorithm successfully trained for model %1%") % model_names_[i]));
+        update.entry["pick_pose"][j] = req.pick_pose[j];
       }
-      else
+      if (!req.symmetry_type.empty())
       {
-        ROS_ERROR_STREAM(boost::str(boost::format("Hough3D algorithm failed training for model %1%") % model_names_[i]));
+        update.entry["symmetry"]["type"] = req.symmetry_type;
+        update.entry["symmetry"]["order"] = req.symmetry_order;
+        if (!req.symmetry_axis.empty())
+        {
+          update.entry["symmetry"]["axis"].setSize(3);
+          for (int j = 0; j < 3; j++)
+          {
+            update.entry["symmetry"]["axis"][j] = req.symmetry_axis[j];
+          }
+        }
       }
 
-      model_recognizers_.push_back(model_recg);
+      gilbreth::perception::Symmetry symmetry;
+      if (!gilbreth::perception::loadSymmetry(update.entry, symmetry))
+      {
+        res.message = "invalid symmetry, expected none, n_fold with a positive order or continuous";
+        return true;
+      }
+    }
 
+    if (!catalogue_updates_->push(update))
+    {
+      res.message = "too many model updates pending";
+      return true;
     }
-  }
 
-  void cloudCallBack(const sensor_msgs::PointCloud2ConstPtr &cloud_msg) {
+    res.success = true;
+    res.message = "update queued";
+    return true;
+  }
 
-    std::clock_t start, t_start;
-    double duration;
-    start = std::clock();
-    pcl::PointCloud<PointType>::Ptr scene(new pcl::PointCloud<PointType>());
-    pcl::PointCloud<NormalType>::Ptr scene_normals(new pcl::PointCloud<NormalType>());
-    pcl::PointCloud<pcl::FPFHSignature33>::Ptr scene_features(new pcl::PointCloud<pcl::FPFHSignature33>);
-
-    // Load scene
-    pcl::fromROSMsg(*cloud_msg, *scene);
-
-    //  Compute Scene normals
-    pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
-    pcl::search::KdTree<PointType>::Ptr tree(new pcl::search::KdTree<PointType>());
-    norm_est.setSearchMethod(tree);
-    norm_est.setKSearch(k_nearest_neighbors);
-    norm_est.setInputCloud(scene);
-    norm_est.compute(*scene_normals);
-
-    std::vector<Result, Eigen::aligned_allocator<Result> > results_temp;
-    Result result;
-    int min_index = -1;
-
-    // Recognition
-    if (icp) {
-      ROS_INFO_STREAM("Using ICP");
-      pcl::FPFHEstimation<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> fpfh_est;
-      fpfh_est.setSearchMethod(tree);
-      fpfh_est.setRadiusSearch(descr_rad_icp);
-      fpfh_est.setInputCloud(scene);
-      fpfh_est.setInputNormals(scene_normals);
-      fpfh_est.compute(*scene_features);
-      // ICP
-      std::vector<pcl::PointIndices> recognized_indices;
-      pcl::PointCloud<PointType>::Ptr target(new pcl::PointCloud<PointType>());
-      pcl::PointCloud<PointType>::Ptr recognized_cloud(new pcl::PointCloud<PointType>());
-      pcl::PointCloud<pcl::FPFHSignature33>::Ptr target_features(new pcl::PointCloud<pcl::FPFHSignature33>);
-      pcl::SampleConsensusInitialAlignment<pcl::PointXYZ, pcl::PointXYZ, pcl::FPFHSignature33> sac_ia_;
-
-      // Intialize the parameters in the Sample Consensus Intial Alignment (SAC-IA)
-      // algorithm
-      sac_ia_.setMinSampleDistance(min_sample_distance);
-      sac_ia_.setMaxCorrespondenceDistance(max_correspondence_distance);
-      sac_ia_.setMaximumIterations(nr_iterations);
-      sac_ia_.setInputTarget(scene);
-      sac_ia_.setTargetFeatures(scene_features);
-      results_temp.resize(model_list.size());
-      float best_score = std::numeric_limits<float>::infinity();
-      for (int j = 0; j < model_list.size(); j++)
+  /**
+   * Catalogue updater loop. Each update has the recognizer prepare a complete new catalogue, reusing the data of
+   * the unchanged parts, and swap it in. Recognition is never paused, a cluster started before the swap keeps its
+   * snapshot of the previous catalogue until it is done.
+   */
+  void processCatalogueUpdates()
+  {
+    CatalogueUpdate update;
+    while (catalogue_updates_->pop(update))
+    {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      XmlRpc::XmlRpcValue part_list;
+      std::vector<gilbreth::perception::PartDescription> parts;
+      if (!applyUpdate(update, part_list) || !loadPartList(part_list, parts))
       {
-        sac_ia_.setInputSource(model_list[j]);
-        sac_ia_.setSourceFeatures(model_features_list[j]);
-        pcl::PointCloud<pcl::PointXYZ> registration_output;
-        sac_ia_.align(registration_output);
-        results_temp[j].item_name = model_names_[j];
-        results_temp[j].item_id = j;
-        results_temp[j].fitness_score = (float)sac_ia_.getFitnessScore(max_correspondence_distance);
-        results_temp[j].final_transformation = sac_ia_.getFinalTransformation();
-
-        ROS_INFO_STREAM_COND(print_detailed_info,"model (" << j << ") " << model_names_[j] <<
-                             " fitnessScore " << results_temp[j].fitness_score);
-        if (results_temp[j].fitness_score < best_score)
-        {
-          min_index = j;
-          best_score = results_temp[j].fitness_score;
-        }
+        continue;
       }
-      result = results_temp[min_index];
-    }
 
-    else {
-      //ROS_INFO_STREAM("Using Correspondence Grouping");
-      // Extract Scene Keypoint
-      pcl::UniformSampling<PointType> uniform_sampling;
-      pcl::PointCloud<PointType>::Ptr scene_keypoints(new pcl::PointCloud<PointType>());
-      uniform_sampling.setInputCloud(scene);
-      uniform_sampling.setRadiusSearch(key_point_sampling);
-      uniform_sampling.filter(*scene_keypoints);
-
-      //Compute Descriptor
-      pcl::SHOTEstimationOMP<PointType, NormalType, pcl::SHOT352> descr_est;
-      descr_est.setRadiusSearch(descr_rad_cg);
-      pcl::PointCloud<pcl::SHOT352>::Ptr scene_descriptors(new pcl::PointCloud<pcl::SHOT352>());
-      descr_est.setInputCloud(scene_keypoints);
-      descr_est.setInputNormals(scene_normals);
-      descr_est.setSearchSurface(scene);
-      descr_est.compute(*scene_descriptors);
-
-      //Compute rf
-      pcl::PointCloud<pcl::ReferenceFrame>::Ptr scene_rf(new pcl::PointCloud<pcl::ReferenceFrame>());
-      pcl::BOARDLocalReferenceFrameEstimation<PointType, NormalType, pcl::ReferenceFrame> rf_est;
-      rf_est.setFindHoles(true);
-      rf_est.setRadiusSearch(descr_rad_cg);
-      rf_est.setInputCloud(scene_keypoints);
-      rf_est.setInputNormals(scene_normals);
-      rf_est.setSearchSurface(scene);
-      rf_est.compute(*scene_rf);
-
-      //  Find Model-Scene Correspondences with KdTree
-      for (int j = 0; j < model_list.size(); j++)
+      try
       {
-        pcl::KdTreeFLANN<pcl::SHOT352> match_search;
-        pcl::CorrespondencesPtr model_scene_corrs(new pcl::Correspondences());
-        match_search.setInputCloud(model_descriptor_list[j]);
-
-        // For each scene keypoint descriptor, find nearest neighbor into the model keypoints
-        // descriptor cloud and add it to the correspondences vector.
-        for (size_t i = 0; i < scene_descriptors->size(); ++i) {
-          std::vector<int> neigh_indices(1);
-          std::vector<float> neigh_sqr_dists(1);
-          if (!pcl_isfinite(scene_descriptors->at(i).descriptor[0])) //skipping NaNs
-          {
-            continue;
-          }
-
-          int found_neighs = match_search.nearestKSearch(scene_descriptors->at(i), 1, neigh_indices, neigh_sqr_dists);
-          for(size_t i = 0 ; i < found_neighs ; i++)
-          {
-            if(neigh_sqr_dists[i] > descr_dis_thrd)
-            {
-              continue;
-            }
-            pcl::Correspondence corr(neigh_indices[i], static_cast<int>(i), neigh_sqr_dists[i]);
-            model_scene_corrs->push_back(corr);
-          }
-        }
-
-        if(model_scene_corrs->empty())
+        if (!recognizer_->updateCatalogue(parts))
         {
-          ROS_WARN_STREAM_COND(print_detailed_info,
-                               boost::str(boost::format("Model (%1%) %2% contains no scene correspondences") % j % model_names_[j] ));
+          ROS_ERROR("Recognition could not prepare the update of model %s, keeping the current models",
+                    update.name.c_str());
           continue;
         }
+      }
+      catch (std::exception& e)
+      {
+        ROS_ERROR("Recognition failed to update model %s: %s", update.name.c_str(), e.what());
+        continue;
+      }
 
-        ROS_INFO_STREAM_COND(print_detailed_info && !model_scene_corrs->empty(),
-                             "Model (" <<j<<") "<< model_names_[j] <<" has " << model_scene_corrs->size()<<" correspondences");
+      part_list_ = part_list;
+      ROS_INFO("Recognition %s model %s, %lu models in use after %.2f seconds", update.remove ? "removed" : "updated",
+               update.name.c_str(), recognizer_->getModelCount(),
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+  }
 
-        // running pre-trained hough3d recognition
-        std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations;
-        std::vector<pcl::Correspondences> clustered_corrs;
+  /**
+   * part_list in use with the update applied, false when there is nothing to apply
+   */
+  bool applyUpdate(const CatalogueUpdate& update, XmlRpc::XmlRpcValue& part_list)
+  {
+    bool found = false;
+    part_list.setSize(0);
+    for (int i = 0; i < part_list_.size(); i++)
+    {
+      if (static_cast<std::string>(part_list_[i]["name"]) != update.name)
+      {
+        part_list[part_list.size()] = part_list_[i];
+        continue;
+      }
 
-        ModelRecognizerPtr model_recognizer = model_recognizers_[j];
-        model_recognizer->setSceneCloud(scene_keypoints);
-        model_recognizer->setSceneRf(scene_rf);
-        model_recognizer->setModelSceneCorrespondences(model_scene_corrs);
-        model_recognizer->recognize(rototranslations, clustered_corrs);
+      found = true;
+      if (!update.remove)
+      {
+        part_list[part_list.size()] = update.entry;
+      }
+    }
 
-        if (clustered_corrs.size() > 0)
-        {
-          // computing total correspondences
-          int total_corr = std::accumulate(clustered_corrs.begin(),clustered_corrs.end(), 0 ,[](int c,const pcl::Correspondences& v)
-           {
-             return c + v.size();
-           });
+    if (!found && update.remove)
+    {
+      ROS_ERROR("Recognition has no model %s to remove", update.name.c_str());
+      return false;
+    }
+    if (!found)
+    {
+      part_list[part_list.size()] = update.entry;
+    }
+    if (part_list.size() == 0)
+    {
+      ROS_ERROR("Recognition keeps at least one model, %s is not removed", update.name.c_str());
+      return false;
+    }
+    return true;
+  }
 
-          if (total_corr > min_index)
-          {
-            min_index = total_corr;
-            result.item_name = model_names_[j];
-            result.item_id = j;
-            result.final_transformation = rototranslations[0];
-          }
+  void stopCatalogueUpdates()
+  {
+    if (!catalogue_updates_)
+    {
+      return;
+    }
 
-          ROS_INFO_STREAM_COND(print_detailed_info,
-                               "Model (" << j <<") "<< model_names_[j] <<" contains " << total_corr <<" recognized correspondences");
+    catalogue_updates_->close();
+    catalogue_updater_.join();
+  }
 
-        }
+  void cloudCallBack(const sensor_msgs::PointCloud2ConstPtr &cloud_msg)
+  {
+    // this callback is the only producer, so a change of the drop count comes from this push
+    const std::uint64_t dropped = input_queue_->getStats().dropped();
+    input_queue_->push(cloud_msg);
+    const gilbreth::perception::WorkQueueStats stats = input_queue_->getStats();
+    if (stats.dropped() > dropped)
+    {
+      ROS_WARN_THROTTLE(5.0, "Recognition input queue is full, %lu of %lu clusters dropped so far",
+                        stats.dropped(), stats.pushed + stats.dropped_newest);
+    }
+  }
 
+  /**
+   * Input worker loop, runs until the queue is closed. The model evaluation of concurrent clusters is serialized
+   * by the thread pool, extra workers overlap the per cluster scene preparation with it.
+   */
+  void processInputQueue()
+  {
+    sensor_msgs::PointCloud2ConstPtr cloud_msg;
+    while (input_queue_->pop(cloud_msg))
+    {
+      try
+      {
+        processCloud(cloud_msg);
+      }
+      catch (std::exception& e)
+      {
+        ROS_ERROR("Recognition failed on a cluster: %s", e.what());
       }
     }
+  }
 
-    duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    ROS_INFO_STREAM("runtime is " << duration << " seconds.");
-
-    if (min_index == -1) {
-      ROS_ERROR_STREAM("-----------------------------");
-      ROS_ERROR_STREAM("Recognition Failed, elapsed time: "<<duration<<" seconds");
-      ROS_ERROR_STREAM("-----------------------------");
+  void stopInputWorkers()
+  {
+    if (!input_queue_)
+    {
+      return;
     }
-    else
+
+    input_queue_->close();
+    for (std::thread& worker : input_workers_)
     {
+      worker.join();
+    }
+    input_workers_.clear();
+
+    const gilbreth::perception::WorkQueueStats stats = input_queue_->getStats();
+    ROS_INFO("Recognition input queue: %lu clusters processed, %lu dropped oldest, %lu dropped newest, "
+             "%lu blocked pushes, %lu queued at most", stats.popped, stats.dropped_oldest, stats.dropped_newest,
+             stats.blocked, stats.high_water_mark);
+  }
 
-      ROS_INFO_STREAM("-----------------------------");
-      ROS_INFO_STREAM("Recognition found object: " << result.item_name<<" in "<<duration<<" seconds");
-      ROS_INFO_STREAM("-----------------------------");
-
-      pcl::PointCloud<PointType>::Ptr rotated_model(new pcl::PointCloud<PointType>());
-      pcl::transformPointCloud(*model_list[result.item_id], *rotated_model, result.final_transformation);
-
-      // Transform pick up point from model to scene
-      pcl::PointCloud<PointType>::Ptr pick_point_cloud(new pcl::PointCloud<PointType>());
-      pcl::PointCloud<PointType>::Ptr rotated_pick_point_cloud(new pcl::PointCloud<PointType>());
-      pcl::PointXYZ pick_point;
-      pick_point.x = pick_pose[result.item_id][0];
-      pick_point.y = pick_pose[result.item_id][1];
-      pick_point.z = pick_pose[result.item_id][2];
-      pick_point_cloud->push_back(pick_point);
-      pcl::transformPointCloud(*pick_point_cloud, *rotated_pick_point_cloud, result.final_transformation);
-
-      // Use ICP to fine align model to scene
-      t_start = std::clock();
-      pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> icp;
-      icp.setMaximumIterations (iterations);
-      icp.setInputSource(rotated_model);
-      icp.setInputTarget(scene);
-      pcl::PointCloud<pcl::PointXYZ> final;
-      icp.align(final);
-
-      duration = (std::clock() - t_start) / (double)CLOCKS_PER_SEC;
-      ROS_INFO_STREAM_COND(print_detailed_info && icp.hasConverged(),"ICP refinement converged , with score: " <<icp.getFitnessScore()<<" in "<<
-                           duration<<" seconds");
-
-      ROS_ERROR_STREAM_COND(!icp.hasConverged(),"ICP refinement failed, using un-converged pose");
-
-      Eigen::Matrix4f icp_transformation = icp.getFinalTransformation();
-      pcl::transformPointCloud(*rotated_model, *rotated_model, icp_transformation);
-      pcl::transformPointCloud(*rotated_pick_point_cloud, *rotated_pick_point_cloud, icp_transformation);
-
-      // Generate output message
-      gilbreth_msgs::ObjectDetection data;
-      gilbreth_msgs::ObjectDetection data_tf;
-      geometry_msgs::PointStamped sensor_point;
-      geometry_msgs::PointStamped world_point;
-
-      tf::Quaternion q;
-      q.setEuler(pick_pose[result.item_id][4], pick_pose[result.item_id][3], pick_pose[result.item_id][5]);
-      data.name = result.item_name;
-      data.pose.position.x = rotated_pick_point_cloud->points[0].x;
-      data.pose.position.y = rotated_pick_point_cloud->points[0].y;
-      data.pose.position.z = rotated_pick_point_cloud->points[0].z;
-
-      data.pose.orientation.x = q.getX();
-      data.pose.orientation.y = q.getY();
-      data.pose.orientation.z = q.getZ();
-      data.pose.orientation.w = q.getW();
-
-      // Transform point to world coordination
-      sensor_point.point.x = data.pose.position.x;
-      sensor_point.point.y = data.pose.position.y;
-      sensor_point.point.z = data.pose.position.z;
-      sensor_point.header.frame_id = cloud_msg->header.frame_id;
-      listener.transformPoint("world", sensor_point, world_point);
-
-      data_tf.name = data.name;
-      data_tf.pose.position.x = world_point.point.x;
-      data_tf.pose.position.y = world_point.point.y;
-      data_tf.pose.position.z = world_point.point.z;
-      data_tf.pose.orientation.x = q.getX();
-      data_tf.pose.orientation.y = q.getY();
-      data_tf.pose.orientation.z = q.getZ();
-      data_tf.pose.orientation.w = q.getW();
-      data_tf.detection_time = cloud_msg->header.stamp;
-      data_tf.header.stamp = ros::Time::now();
-      data_tf.header.frame_id = "world";
-      pub_tf.publish(data_tf);
+  void processCloud(const sensor_msgs::PointCloud2ConstPtr &cloud_msg) {
+
+    gilbreth::perception::StageTimer timer;
+    pcl::PointCloud<PointType>::Ptr scene(new pcl::PointCloud<PointType>());
+    const gilbreth::perception::OperatingPoint operating_point = latency_controller_->getOperatingPoint();
+
+    // Load scene, the recognition stages need a PCL cloud so the coordinates are copied once
+    {
+      gilbreth::perception::StageTimer::Scope stage(timer, "conversion");
+      if (!gilbreth::perception::copyToCloud(*cloud_msg, *scene))
+      {
+        return;
+      }
     }
+    timer.setPoints(scene->size());
 
+    recognizer_->recognize(scene, cloud_msg->header.stamp.toSec(), operating_point, timer,
+                           [&](const gilbreth::perception::Detection& detection)
+    {
+      publishDetection(cloud_msg, detection, timer);
+    });
+    timing_publisher_->publish(cloud_msg->header, timer);
+    updateOperatingPoint(cloud_msg->header, timer);
   }
 
 private:
-  struct Result {
-    std::string item_name;
-    int item_id;
-    float fitness_score;
-    Eigen::Matrix4f final_transformation;
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-  };
+  /**
+   * Feeds the stage durations of a cluster and the clusters still queued to the latency controller, the next
+   * clusters use the operating point it chooses
+   */
+  void updateOperatingPoint(const std_msgs::Header& header, const gilbreth::perception::StageTimer& timer)
+  {
+    latency_controller_->update(timer.getStages(), timer.elapsed(), input_queue_->size(), input_workers_.size());
+    operating_point_publisher_->publish(header, *latency_controller_);
+  }
+
+  /**
+   * Publishes the pick point of a detection in the world frame
+   */
+  void publishDetection(const sensor_msgs::PointCloud2ConstPtr &cloud_msg,
+                        const gilbreth::perception::Detection& detection, gilbreth::perception::StageTimer& timer)
+  {
+    // Transform point to world coordination
+    gilbreth::perception::StageTimer::Scope tf_stage(timer, "tf");
+    geometry_msgs::PointStamped sensor_point;
+    geometry_msgs::PointStamped world_point;
+    tf::Quaternion q;
+    q.setEuler(detection.pick_orientation[1], detection.pick_orientation[0], detection.pick_orientation[2]);
+    sensor_point.point.x = detection.pick_position.x();
+    sensor_point.point.y = detection.pick_position.y();
+    sensor_point.point.z = detection.pick_position.z();
+    sensor_point.header.frame_id = cloud_msg->header.frame_id;
+    listener.transformPoint("world", sensor_point, world_point);
+    tf_stage.stop();
+
+    gilbreth::perception::StageTimer::Scope publish_stage(timer, "publish");
+    gilbreth_msgs::ObjectDetection data_tf;
+    data_tf.name = detection.name;
+    data_tf.pose.position.x = world_point.point.x;
+    data_tf.pose.position.y = world_point.point.y;
+    data_tf.pose.position.z = world_point.point.z;
+    data_tf.pose.orientation.x = q.getX();
+    data_tf.pose.orientation.y = q.getY();
+    data_tf.pose.orientation.z = q.getZ();
+    data_tf.pose.orientation.w = q.getW();
+    data_tf.detection_time = cloud_msg->header.stamp;
+    data_tf.header.stamp = ros::Time::now();
+    data_tf.header.frame_id = "world";
+    pub_tf.publish(data_tf);
+  }
 
   ros::NodeHandle nh_;
   ros::Publisher pub_tf;
   ros::Subscriber cloud_subs_;
 
-  // recognition data structures
-  std::vector<std::vector<double> > pick_pose;
-  std::vector<std::string> model_names_;
-  std::vector<pcl::PointCloud<PointType>::Ptr> model_list;
-  std::vector<pcl::PointCloud<pcl::FPFHSignature33>::Ptr> model_features_list;
-  std::vector<pcl::PointCloud<pcl::SHOT352>::Ptr> model_descriptor_list;
-  std::vector<pcl::PointCloud<pcl::ReferenceFrame>::Ptr> model_rf_list;
-  std::vector<pcl::PointCloud<PointType>::Ptr> model_keypoints_list;
-  std::vector<ModelRecognizerPtr> model_recognizers_;
+  std::unique_ptr<gilbreth::perception::Recognizer> recognizer_;
+  XmlRpc::XmlRpcValue part_list_;   /** of the catalogue in use, only touched by run() and the catalogue updater */
+  std::unique_ptr<UpdateQueue> catalogue_updates_;
+  std::thread catalogue_updater_;
+  ros::CallbackQueue service_queue_;   /** of the update_model service only */
+  ros::ServiceServer update_model_service_;
+  std::unique_ptr<ros::AsyncSpinner> service_spinner_;
   tf::TransformListener listener;
+  std::unique_ptr<InputQueue> input_queue_;
+  std::vector<std::thread> input_workers_;
+  std::unique_ptr<gilbreth::perception::TimingPublisher> timing_publisher_;
+  std::unique_ptr<gilbreth::perception::LatencyController> latency_controller_;
+  std::unique_ptr<gilbreth::perception::OperatingPointPublisher> operating_point_publisher_;
 
   // Algorithm params
-  float descr_dis_thrd;
-  float descr_rad_cg;
-  float descr_rad_icp;
-  float down_sample;
-  float min_sample_distance;
-  float max_correspondence_distance;
-  int nr_iterations;
-  bool visualizer;
-  bool icp;
+  gilbreth::perception::RecognizerParameters params_;
   float cg_size;
   float cg_thresh;
-  bool print_detailed_info;
   float key_point_sampling;
-  int k_nearest_neighbors;
-  int iterations;
+  int input_queue_capacity;
+  std::string input_queue_policy;
+  int input_workers;
+  int telemetry_window;
+  gilbreth::perception::LatencyControllerParameters latency_params;
+  float max_leaf_size;
+  int min_keypoint_budget;
+  int min_iterations;
 };
 
 int main(int argc, char **argv) {
@@ -590,14 +666,13 @@ int main(int argc, char **argv) {
   // Initialize ROS
   ros::init(argc, argv, "recognition_node");
   ros::NodeHandle nh;
+  gilbreth::perception::forwardLogToRos();
   RecognitionClass recognition(nh);
   if(!recognition.run())
   {
     return -1;
   }
 
-  // Create a ROS subscriber for the input point cloud
-  //ros::Subscriber sub_1 = nh.subscribe<sensor_msgs::PointCloud2>("segmentation_result", 100, &RecognitionClass::cloudCallBack, &recognition);
   ROS_INFO("Recognition Node Ready ...");
   ros::spin();
 }
@@ -0,0 +1,215 @@
+#include "gilbreth_perception/recognition_pipeline.h"
+#include <pcl/features/board.h>
+#include <pcl/features/fpfh.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/search/kdtree.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+template <typename PointT>
+void ShotDescriptor::compute(const typename pcl::PointCloud<PointT>::ConstPtr& keypoints,
+                             const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+                             const typename pcl::PointCloud<PointT>::ConstPtr& surface,
+                             const typename pcl::search::Search<PointT>::Ptr& search, float radius,
+                             pcl::PointCloud<Descriptor>& descriptors)
+{
+  pcl::SHOTEstimationOMP<PointT, pcl::Normal, Descriptor> descr_est;
+  descr_est.setRadiusSearch(radius);
+  if(search)
+  {
+    descr_est.setSearchMethod(search);
+  }
+  descr_est.setInputCloud(keypoints);
+  descr_est.setInputNormals(normals);
+  descr_est.setSearchSurface(surface);
+  descr_est.compute(descriptors);
+}
+
+template <typename PointT>
+void FpfhRegistration::compute(const typename pcl::PointCloud<PointT>::ConstPtr& cloud,
+                               const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+                               const typename pcl::search::Search<PointT>::Ptr& search, float radius,
+                               pcl::PointCloud<Feature>& features)
+{
+  pcl::FPFHEstimation<PointT, pcl::Normal, Feature> fpfh_est;
+  fpfh_est.setSearchMethod(search);
+  fpfh_est.setRadiusSearch(radius);
+  fpfh_est.setInputCloud(cloud);
+  fpfh_est.setInputNormals(normals);
+  fpfh_est.compute(features);
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::
+SpecializedRecognitionPipeline(const PipelineParameters& params):
+  Base(params),
+  keypoint_detector_(params.keypoints)
+{
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+void SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::describeModel(
+    const typename Cloud::ConstPtr& model, std::size_t keypoint_budget, Described& described) const
+{
+  typename pcl::search::KdTree<PointT>::Ptr tree(new pcl::search::KdTree<PointT>());
+  pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud<pcl::Normal>());
+  pcl::NormalEstimationOMP<PointT, pcl::Normal> norm_est;
+  norm_est.setKSearch(this->params_.normal_k_neighbors);
+  norm_est.setSearchMethod(tree);
+  norm_est.setInputCloud(model);
+  norm_est.compute(*normals);
+
+  described.keypoints.reset(new Cloud());
+  tree->setInputCloud(model);
+  keypoint_detector_.detect(model, *normals, *tree, keypoint_budget, *described.keypoints);
+
+  // the models are described once, pcl builds its own search over them
+  describe(model, normals, typename pcl::search::Search<PointT>::Ptr(), described);
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+bool SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::describeScene(
+    const typename Cloud::ConstPtr& scene, std::size_t keypoint_budget, Index& index, StageTimer& timer,
+    const CancellationToken& cancellation, Described& described) const
+{
+  pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud<pcl::Normal>());
+  {
+    StageTimer::Scope stage(timer, "normals");
+    index.setInputCloud(scene, this->params_.uniform_grid ? this->params_.descriptor_radius : 0.0f);
+    pcl::NormalEstimationOMP<PointT, pcl::Normal> norm_est;
+    norm_est.setSearchMethod(index.getKdTree());
+    norm_est.setKSearch(this->params_.normal_k_neighbors);
+    norm_est.setInputCloud(scene);
+    norm_est.compute(*normals);
+  }
+
+  described.keypoints.reset(new Cloud());
+  {
+    StageTimer::Scope stage(timer, "keypoints");
+    keypoint_detector_.detect(scene, *normals, *index.getRadiusSearch(), keypoint_budget, *described.keypoints);
+  }
+
+  described.descriptors.reset(new pcl::PointCloud<typename DescriptorPolicy::Descriptor>());
+  {
+    StageTimer::Scope stage(timer, "descriptors");
+    DescriptorPolicy::template compute<PointT>(described.keypoints, normals, scene, index.getRadiusSearch(),
+                                               this->params_.descriptor_radius, *described.descriptors);
+  }
+  if(cancellation.isCancelled())
+  {
+    return false;
+  }
+
+  described.rf.reset(new pcl::PointCloud<pcl::ReferenceFrame>());
+  StageTimer::Scope stage(timer, "reference_frames");
+  pcl::BOARDLocalReferenceFrameEstimation<PointT, pcl::Normal, pcl::ReferenceFrame> rf_est;
+  rf_est.setFindHoles(true);
+  rf_est.setRadiusSearch(this->params_.descriptor_radius);
+  rf_est.setSearchMethod(index.getRadiusSearch());
+  rf_est.setInputCloud(described.keypoints);
+  rf_est.setInputNormals(normals);
+  rf_est.setSearchSurface(scene);
+  rf_est.compute(*described.rf);
+  return true;
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+void SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::
+computeModelFeatures(const typename Cloud::ConstPtr& model, int level, Features& features) const
+{
+  const float radius = this->params_.feature_radius * static_cast<float>(1 << level);
+  typename pcl::search::KdTree<PointT>::Ptr tree(new pcl::search::KdTree<PointT>());
+  pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud<pcl::Normal>());
+  pcl::NormalEstimationOMP<PointT, pcl::Normal> norm_est;
+  norm_est.setRadiusSearch(radius);
+  norm_est.setSearchMethod(tree);
+  norm_est.setInputCloud(model);
+  norm_est.compute(*normals);
+
+  RegistrationPolicy::template compute<PointT>(model, normals, tree, radius, features);
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+bool SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::
+computeSceneFeatures(const typename Cloud::ConstPtr& scene, int level, Index& index, StageTimer& timer,
+                     const CancellationToken& cancellation, Features& features) const
+{
+  // the stage names differ from the grouping ones as both run concurrently when racing
+  const float radius = this->params_.feature_radius * static_cast<float>(1 << level);
+  pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud<pcl::Normal>());
+  {
+    StageTimer::Scope stage(timer, "registration_normals");
+    index.setInputCloud(scene, this->params_.uniform_grid ? radius : 0.0f);
+    pcl::NormalEstimationOMP<PointT, pcl::Normal> norm_est;
+    norm_est.setSearchMethod(index.getKdTree());
+    norm_est.setKSearch(this->params_.normal_k_neighbors);
+    norm_est.setInputCloud(scene);
+    norm_est.compute(*normals);
+  }
+  if(cancellation.isCancelled())
+  {
+    return false;
+  }
+
+  StageTimer::Scope stage(timer, "features");
+  RegistrationPolicy::template compute<PointT>(scene, normals, index.getRadiusSearch(), radius, features);
+  return true;
+}
+
+template <typename PointT, typename DescriptorPolicy, typename KeypointPolicy, typename RegistrationPolicy>
+void SpecializedRecognitionPipeline<PointT, DescriptorPolicy, KeypointPolicy, RegistrationPolicy>::describe(
+    const typename Cloud::ConstPtr& surface, const pcl::PointCloud<pcl::Normal>::ConstPtr& normals,
+    const typename pcl::search::Search<PointT>::Ptr& search, Described& described) const
+{
+  described.descriptors.reset(new pcl::PointCloud<typename DescriptorPolicy::Descriptor>());
+  DescriptorPolicy::template compute<PointT>(described.keypoints, normals, surface, search,
+                                             this->params_.descriptor_radius, *described.descriptors);
+
+  described.rf.reset(new pcl::PointCloud<pcl::ReferenceFrame>());
+  pcl::BOARDLocalReferenceFrameEstimation<PointT, pcl::Normal, pcl::ReferenceFrame> rf_est;
+  rf_est.setFindHoles(true);
+  rf_est.setRadiusSearch(this->params_.descriptor_radius);
+  if(search)
+  {
+    rf_est.setSearchMethod(search);
+  }
+  rf_est.setInputCloud(described.keypoints);
+  rf_est.setInputNormals(normals);
+  rf_est.setSearchSurface(surface);
+  rf_est.compute(*described.rf);
+}
+
+template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, UniformKeypointDetector,
+                                              FpfhRegistration>;
+template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, IssKeypointDetector,
+                                              FpfhRegistration>;
+template class SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, HarrisKeypointDetector,
+                                              FpfhRegistration>;
+
+std::unique_ptr<XyzRecognitionPipeline> createRecognitionPipeline(const PipelineParameters& params)
+{
+  std::unique_ptr<XyzRecognitionPipeline> pipeline;
+  if(params.keypoints.method == "uniform")
+  {
+    pipeline.reset(new SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, UniformKeypointDetector,
+                                                      FpfhRegistration>(params));
+  }
+  else if(params.keypoints.method == "iss")
+  {
+    pipeline.reset(new SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, IssKeypointDetector,
+                                                      FpfhRegistration>(params));
+  }
+  else if(params.keypoints.method == "harris")
+  {
+    pipeline.reset(new SpecializedRecognitionPipeline<pcl::PointXYZ, ShotDescriptor, HarrisKeypointDetector,
+                                                      FpfhRegistration>(params));
+  }
+  return pipeline;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,1351 @@
+#include "gilbreth_perception/recognizer.h"
+#include "gilbreth_perception/binary_descriptor_index.h"
+#include "gilbreth_perception/coarse_filter.h"
+#include "gilbreth_perception/compressed_descriptor_index.h"
+#include "gilbreth_perception/descriptor_index.h"
+#include "gilbreth_perception/log.h"
+#include "gilbreth_perception/model_cache.h"
+#include "gilbreth_perception/spatial_index.h"
+#include "gilbreth_perception/symmetry.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <pcl/common/centroid.h>
+#include <pcl/correspondence.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/registration/ia_ransac.h>
+#include <thread>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+typedef std::shared_ptr<const HoughModel> HoughModelPtr;
+typedef pcl::SampleConsensusInitialAlignment<pcl::PointXYZ, pcl::PointXYZ, pcl::FPFHSignature33> SacIa;
+
+/**
+ * Registration side of a cluster on one pyramid level
+ */
+struct RegistrationScene
+{
+  SceneIndex<pcl::PointXYZ> index;
+  pcl::PointCloud<pcl::FPFHSignature33>::Ptr features;
+  GlobalRegistration::Scene registration;
+};
+
+/**
+ * Every model dependent structure
+ */
+struct Recognizer::Catalogue
+{
+  std::vector<PartDescription> parts;
+  std::vector<std::uint64_t> part_hashes;   /** of the entry and the model cloud file of each part, 0 if unreadable */
+  std::vector<Symmetry> model_symmetries;   /** centered on the model centroids */
+  std::vector<Cloud::Ptr> model_list;
+  std::vector<CloudPyramid> model_pyramids;   /** registration levels of each model, finest first */
+  std::vector<std::vector<pcl::PointCloud<pcl::FPFHSignature33>::Ptr> > model_features_list;   /** [model][level] */
+  std::vector<pcl::PointCloud<pcl::SHOT352>::Ptr> model_descriptor_list;
+  std::vector<pcl::PointCloud<pcl::ReferenceFrame>::Ptr> model_rf_list;
+  std::vector<Cloud::Ptr> model_keypoints_list;
+  std::vector<HoughModelPtr> hough_models;   /** trained votes, immutable and shared with later catalogues */
+  std::string descriptor_matching;   /** falls back to flann when the descriptors can not be compressed */
+  DescriptorIndex descriptor_index;
+  CompressedDescriptorIndex compressed_descriptor_index;
+  BinaryDescriptorIndex binary_descriptor_index;
+  std::unique_ptr<VocabularyTree> vocabulary;
+  CoarseFilter coarse_filter;
+  std::unique_ptr<PlanarRecognizer> planar_recognizer;
+  std::vector<std::unique_ptr<GlobalRegistration> > global_registrations;   /** [level] */
+  std::vector<std::unique_ptr<HypothesisVerifier> > verifiers;   /** [level], of the registration hypotheses */
+  std::unique_ptr<FineAlignment> fine_alignment;
+
+  /**
+   * Index of the model prepared from an identical part entry and model cloud, or -1
+   */
+  int findModel(const std::string& entry, std::uint64_t hash) const
+  {
+    if(hash == 0)
+    {
+      return -1;
+    }
+    for(std::size_t i = 0; i < parts.size(); i++)
+    {
+      if(parts[i].entry == entry && part_hashes[i] == hash)
+      {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Drops the per model data
+   */
+  void clearModels()
+  {
+    model_list.clear();
+    model_pyramids.clear();
+    model_features_list.clear();
+    model_keypoints_list.clear();
+    model_descriptor_list.clear();
+    model_rf_list.clear();
+    hough_models.clear();
+  }
+};
+
+std::unique_ptr<Recognizer> Recognizer::create(const RecognizerParameters& params)
+{
+  std::unique_ptr<Recognizer> recognizer;
+  if(params.registration_method != "sac_ia" && params.registration_method != "fgr")
+  {
+    GILBRETH_ERROR_STREAM("Recognition global registration method '" << params.registration_method <<
+                          "' is unknown, use sac_ia or fgr");
+    return recognizer;
+  }
+
+  if(params.descriptor_matching != "flann" && params.descriptor_matching != "pca_int8" &&
+     params.descriptor_matching != "binary" && params.descriptor_matching != "vocabulary")
+  {
+    GILBRETH_ERROR_STREAM("Recognition descriptor matching '" << params.descriptor_matching <<
+                          "' is unknown, use flann, pca_int8, binary or vocabulary");
+    return recognizer;
+  }
+
+  if(params.descriptor_matching == "vocabulary" &&
+     (params.vocabulary_params.branching < 2 || params.vocabulary_params.depth < 1))
+  {
+    GILBRETH_ERROR_STREAM("Recognition vocabulary needs a branching of at least 2 and a depth of at least 1");
+    return recognizer;
+  }
+
+  if(params.keypoint_scene_budget < 0 || params.keypoint_model_budget < 0)
+  {
+    GILBRETH_ERROR_STREAM("Recognition keypoint budgets can not be negative, use 0 for no budget");
+    return recognizer;
+  }
+
+  if(params.tracking && (params.tracking_params.max_centroid_distance <= 0.0f ||
+                         params.tracking_params.max_extent_difference < 0.0f ||
+                         params.tracking_params.max_age <= 0.0))
+  {
+    GILBRETH_ERROR_STREAM("Recognition tracking needs a positive centroid distance and age, and an extent "
+                          "difference of at least 0");
+    return recognizer;
+  }
+
+  // the feature stages are compiled per configuration, the keypoint method picks one of them
+  PipelineParameters pipeline_params;
+  pipeline_params.normal_k_neighbors = params.k_nearest_neighbors;
+  pipeline_params.descriptor_radius = params.descr_rad_cg;
+  pipeline_params.feature_radius = params.descr_rad_icp;
+  pipeline_params.uniform_grid = params.uniform_grid;
+  pipeline_params.keypoints = params.keypoint_params;
+  std::unique_ptr<const XyzRecognitionPipeline> pipeline(createRecognitionPipeline(pipeline_params));
+  if(!pipeline)
+  {
+    GILBRETH_ERROR_STREAM("Recognition keypoint method '" << params.keypoint_params.method <<
+                          "' is unknown, use uniform, iss or harris");
+    return recognizer;
+  }
+
+  if(params.tracking && params.planar)
+  {
+    GILBRETH_WARN_STREAM("Recognition only tracks the ICP and correspondence grouping methods, recognizing every "
+                         "cluster");
+  }
+
+  if(params.race && params.planar)
+  {
+    GILBRETH_WARN_STREAM("Recognition only races the ICP and correspondence grouping methods, using the planar "
+                         "search");
+  }
+
+  RecognizerParameters completed = params;
+  completed.fine_alignment_params.max_iterations = params.iterations;
+  completed.fine_alignment_params.pyramid_levels = params.pyramid_levels;
+  completed.fine_alignment_params.leaf_size = params.down_sample;
+  completed.fine_alignment_params.normal_k_neighbors = params.k_nearest_neighbors;
+  completed.verification_params.max_sqr_distance = params.verification_inlier_distance *
+                                                   params.verification_inlier_distance;
+  recognizer.reset(new Recognizer(completed, std::move(pipeline)));
+  return recognizer;
+}
+
+Recognizer::Recognizer(const RecognizerParameters& params, std::unique_ptr<const XyzRecognitionPipeline> pipeline):
+  params_(params),
+  recognition_pipeline_(std::move(pipeline))
+{
+  // racing splits the threads between the two strategies
+  if(params_.race && !params_.planar)
+  {
+    // each racing strategy gets its own workers, otherwise one would wait for the other's parallelFor
+    const std::size_t total_threads = params_.threads > 0 ? params_.threads :
+                                                            std::max(1u, std::thread::hardware_concurrency());
+    thread_pool_.reset(new ThreadPool(std::max<std::size_t>(1, total_threads / 2)));
+    race_pool_.reset(new ThreadPool(std::max<std::size_t>(1, total_threads - thread_pool_->size())));
+    GILBRETH_INFO_STREAM("Recognition races grouping on " << thread_pool_->size() << " threads against registration "
+                         "on " << race_pool_->size() << " threads");
+  }
+  else
+  {
+    thread_pool_.reset(new ThreadPool(params_.threads));
+    GILBRETH_INFO_STREAM("Recognition evaluates models on " << thread_pool_->size() << " threads");
+  }
+
+  // objects seen on an earlier frame are carried along the belt instead of being recognized again
+  if(params_.tracking && !params_.planar)
+  {
+    tracker_.reset(new ObjectTracker(params_.tracking_params));
+    GILBRETH_INFO_STREAM("Recognition tracks objects moving at (" << params_.tracking_params.belt_velocity.x() << ", "
+                         << params_.tracking_params.belt_velocity.y() << ", "
+                         << params_.tracking_params.belt_velocity.z() << ") m/s");
+  }
+}
+
+Recognizer::~Recognizer()
+{
+  if(tracker_)
+  {
+    const TrackerStats stats = tracker_->getStats();
+    GILBRETH_INFO_STREAM("Recognition tracker: " << stats.matched << " clusters matched a track, " <<
+                         stats.ambiguous << " matched several, " << stats.unmatched << " none");
+  }
+}
+
+bool Recognizer::loadCatalogue(const std::vector<PartDescription>& parts)
+{
+  std::shared_ptr<Catalogue> catalogue(new Catalogue());
+  if(!loadModels(parts, nullptr, *catalogue))
+  {
+    return false;
+  }
+  buildCatalogueIndexes(*catalogue);
+  std::atomic_store(&catalogue_, std::shared_ptr<const Catalogue>(catalogue));
+  return true;
+}
+
+bool Recognizer::updateCatalogue(const std::vector<PartDescription>& parts)
+{
+  const std::shared_ptr<const Catalogue> current = std::atomic_load(&catalogue_);
+  std::shared_ptr<Catalogue> catalogue(new Catalogue());
+  if(!loadModels(parts, current.get(), *catalogue))
+  {
+    return false;
+  }
+  buildCatalogueIndexes(*catalogue);
+  std::atomic_store(&catalogue_, std::shared_ptr<const Catalogue>(catalogue));
+  return true;
+}
+
+std::size_t Recognizer::getModelCount() const
+{
+  const std::shared_ptr<const Catalogue> catalogue = std::atomic_load(&catalogue_);
+  return catalogue ? catalogue->model_list.size() : 0;
+}
+
+OperatingPoint Recognizer::getNominalOperatingPoint() const
+{
+  OperatingPoint operating_point;
+  operating_point.leaf_size = params_.down_sample;
+  operating_point.keypoint_budget = params_.keypoint_scene_budget;
+  operating_point.icp_iterations = params_.iterations;
+  operating_point.predicted_latency = 0.0;
+  operating_point.queue_depth = 0;
+  return operating_point;
+}
+
+bool Recognizer::recognize(const Cloud::ConstPtr& cluster, double stamp, const OperatingPoint& operating_point,
+                           StageTimer& timer, const DetectionCallback& on_detection)
+{
+  const std::shared_ptr<const Catalogue> catalogue_snapshot = std::atomic_load(&catalogue_);
+  if(!catalogue_snapshot)
+  {
+    GILBRETH_ERROR_STREAM("Recognition has no models");
+    return false;
+  }
+  // a catalogue swapped in meanwhile is used from the next cluster on
+  const Catalogue& catalogue = *catalogue_snapshot;
+
+  // clusters arrive at the down_sample resolution, the latency controller may coarsen them under load
+  Cloud::ConstPtr scene = cluster;
+  if(operating_point.leaf_size > params_.down_sample)
+  {
+    StageTimer::Scope stage(timer, "downsample");
+    Cloud::Ptr coarse(new Cloud());
+    pcl::VoxelGrid<pcl::PointXYZ> sor;
+    sor.setInputCloud(cluster);
+    sor.setLeafSize(operating_point.leaf_size, operating_point.leaf_size, operating_point.leaf_size);
+    sor.filter(*coarse);
+    scene = coarse;
+  }
+
+  // Resolution pyramid of the cluster for the fine alignment, the ICP mode generates its hypotheses on the
+  // coarsest level it shares with each model. Levels finer than a coarsened cluster only repeat it, see finestLevel
+  CloudPyramid scene_pyramid(1, scene);
+  if(!params_.planar)
+  {
+    StageTimer::Scope stage(timer, "pyramid");
+    scene_pyramid = buildPyramid(scene, params_.down_sample, params_.pyramid_levels);
+  }
+
+  // A cluster matching the prediction of a tracked object skips recognition, its pose is only touched up
+  if(tracker_)
+  {
+    Detection result;
+    if(predictFromTrack(catalogue, stamp, scene_pyramid, timer, result))
+    {
+      finishDetection(catalogue, stamp, scene_pyramid, result, operating_point, timer, on_detection);
+      return true;
+    }
+  }
+
+  // Cascade, only the models whose overall shape is close to the cluster go through the expensive stage
+  std::vector<int> candidates;
+  {
+    StageTimer::Scope stage(timer, "prefilter");
+    candidates = catalogue.coarse_filter.select(*scene);
+  }
+  GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Coarse filter kept " << candidates.size() << " of " <<
+                            catalogue.model_list.size() << " models");
+
+  // Recognition
+  if(params_.race && !params_.planar)
+  {
+    return raceStrategies(catalogue, stamp, scene_pyramid, candidates, operating_point, timer, on_detection);
+  }
+
+  Detection result;
+  bool found;
+  const CancellationToken never_cancelled;
+  if(params_.planar)
+  {
+    found = recognizePlanar(catalogue, scene, candidates, timer, result);
+  }
+  else if(params_.icp)
+  {
+    GILBRETH_INFO_STREAM("Using ICP");
+    found = recognizeByRegistration(catalogue, scene_pyramid, candidates, *thread_pool_, never_cancelled, timer,
+                                    result);
+  }
+  else
+  {
+    found = recognizeByGrouping(catalogue, scene_pyramid, candidates, operating_point, never_cancelled, timer,
+                                result);
+  }
+
+  const double duration = timer.elapsed();
+  GILBRETH_INFO_STREAM("runtime is " << duration << " seconds.");
+
+  if(!found)
+  {
+    GILBRETH_ERROR_STREAM("-----------------------------");
+    GILBRETH_ERROR_STREAM("Recognition Failed, elapsed time: " << duration << " seconds");
+    GILBRETH_ERROR_STREAM("-----------------------------");
+    return false;
+  }
+
+  finishDetection(catalogue, stamp, scene_pyramid, result, operating_point, timer, on_detection);
+  return true;
+}
+
+/**
+ * FPFH hypotheses are generated in the ICP mode and when racing
+ */
+bool Recognizer::useRegistration() const
+{
+  return !params_.planar && (params_.icp || params_.race);
+}
+
+/**
+ * Hough3D correspondence grouping runs in the default mode and when racing
+ */
+bool Recognizer::useGrouping() const
+{
+  return !params_.planar && (!params_.icp || params_.race);
+}
+
+/**
+ * Prepares every part. Parts whose entry and model cloud file are unchanged from the previous catalogue reuse its
+ * preprocessed data, without a previous catalogue the model cache of the last run is tried first.
+ */
+bool Recognizer::loadModels(const std::vector<PartDescription>& parts, const Catalogue* previous,
+                            Catalogue& catalogue)
+{
+  catalogue.parts = parts;
+  for(const PartDescription& part : parts)
+  {
+    catalogue.model_symmetries.push_back(part.symmetry);
+
+    // an edited cloud file under an unchanged entry is prepared again
+    std::uint64_t hash = hashString(part.entry);
+    if(!hashFile(part.path, hash))
+    {
+      hash = 0;
+    }
+    catalogue.part_hashes.push_back(hash);
+  }
+
+  // Try the preprocessed models from a previous run first
+  std::uint64_t cache_key = 0;
+  if(!previous && !params_.model_cache_file.empty() && computeCacheKey(parts, cache_key) &&
+     loadModelCache(cache_key, catalogue))
+  {
+    return true;
+  }
+
+  GILBRETH_INFO_STREAM("Preparing Point Cloud Models");
+  for(std::size_t i = 0; i < parts.size(); i++)
+  {
+    const int previous_id = previous ? previous->findModel(parts[i].entry, catalogue.part_hashes[i]) : -1;
+    if(previous_id >= 0)
+    {
+      reuseModel(*previous, previous_id, catalogue);
+      continue;
+    }
+
+    Cloud::Ptr model;
+    if(!loadPartCloud(parts[i].path, params_.down_sample, model))
+    {
+      return false;
+    }
+    prepareModel(model, catalogue);
+  }
+
+  if(cache_key != 0)
+  {
+    saveModelCache(cache_key, catalogue);
+  }
+  return true;
+}
+
+bool Recognizer::computeCacheKey(const std::vector<PartDescription>& parts, std::uint64_t& key) const
+{
+  key = params_.cache_seed;
+  for(const PartDescription& part : parts)
+  {
+    key = hashString(part.entry, key);
+  }
+  for(const PartDescription& part : parts)
+  {
+    if(!hashFile(part.path, key))
+    {
+      GILBRETH_WARN_STREAM("Recognition could not read model cloud " << part.path << ", skipping model cache");
+      key = 0;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Recognizer::loadModelCache(std::uint64_t key, Catalogue& catalogue) const
+{
+  std::vector<CachedModel> cached_models;
+  ModelCache cache(params_.model_cache_file);
+  if(!cache.load(key, cached_models) || cached_models.size() != catalogue.parts.size())
+  {
+    return false;
+  }
+
+  for(std::size_t i = 0; i < cached_models.size(); i++)
+  {
+    const CachedModel& cached = cached_models[i];
+    catalogue.model_list.push_back(cached.cloud);
+    catalogue.model_pyramids.push_back(modelPyramid(cached.cloud));
+    if(useRegistration())
+    {
+      if(cached.features.size() != catalogue.model_pyramids.back().size())
+      {
+        GILBRETH_WARN_STREAM("Model cache holds features of another pyramid for model " << catalogue.parts[i].name);
+        catalogue.clearModels();
+        return false;
+      }
+      catalogue.model_features_list.push_back(cached.features);
+    }
+    if(!useGrouping())
+    {
+      continue;
+    }
+
+    catalogue.model_keypoints_list.push_back(cached.keypoints);
+    catalogue.model_descriptor_list.push_back(cached.descriptors);
+    catalogue.model_rf_list.push_back(cached.rf);
+
+    HoughModelPtr hough_model(new HoughModel(cached.keypoints, cached.rf, cached.hough_votes));
+    if(!hough_model->isValid())
+    {
+      GILBRETH_ERROR_STREAM("Model cache holds invalid Hough3D training for model " << catalogue.parts[i].name);
+      catalogue.clearModels();
+      return false;
+    }
+    catalogue.hough_models.push_back(hough_model);
+  }
+
+  GILBRETH_INFO_STREAM("Recognition loaded " << cached_models.size() << " preprocessed models from " <<
+                       params_.model_cache_file);
+  return true;
+}
+
+void Recognizer::saveModelCache(std::uint64_t key, const Catalogue& catalogue) const
+{
+  std::vector<CachedModel> cached_models(catalogue.model_list.size());
+  for(std::size_t i = 0; i < catalogue.model_list.size(); i++)
+  {
+    CachedModel& cached = cached_models[i];
+    cached.cloud = catalogue.model_list[i];
+    if(useRegistration())
+    {
+      cached.features = catalogue.model_features_list[i];
+    }
+    if(!useGrouping())
+    {
+      continue;
+    }
+    cached.keypoints = catalogue.model_keypoints_list[i];
+    cached.descriptors = catalogue.model_descriptor_list[i];
+    cached.rf = catalogue.model_rf_list[i];
+    cached.hough_votes = catalogue.hough_models[i]->getVotes();
+  }
+
+  ModelCache cache(params_.model_cache_file);
+  if(cache.save(key, cached_models))
+  {
+    GILBRETH_INFO_STREAM("Recognition saved preprocessed models to " << params_.model_cache_file);
+  }
+}
+
+/**
+ * Hypotheses of the ICP mode are generated on the coarsest level shared by the model and cluster pyramids, the fine
+ * alignment then promotes them back to the model resolution
+ */
+CloudPyramid Recognizer::modelPyramid(const Cloud::Ptr& model) const
+{
+  return buildPyramid(model, params_.down_sample, params_.pyramid_levels);
+}
+
+/**
+ * Computes the data of the selected recognition methods for a downsampled model and appends it to the catalogue
+ */
+void Recognizer::prepareModel(const Cloud::Ptr& model, Catalogue& catalogue) const
+{
+  const std::size_t model_id = catalogue.model_list.size();
+  catalogue.model_list.push_back(model);
+  catalogue.model_pyramids.push_back(modelPyramid(model));
+
+  // planar search works on the downsampled models directly, racing needs the data of both other methods
+  if(useRegistration())
+  {
+    loadICPConfig(model_id, catalogue);
+  }
+  // if use correspondence grouping
+  if(useGrouping())
+  {
+    loadCGConfig(model_id, catalogue);
+  }
+}
+
+/**
+ * Appends the data prepared for a model of the previous catalogue, including its trained Hough votes which can
+ * serve both catalogues at once.
+ */
+void Recognizer::reuseModel(const Catalogue& previous, std::size_t previous_id, Catalogue& catalogue) const
+{
+  catalogue.model_list.push_back(previous.model_list[previous_id]);
+  catalogue.model_pyramids.push_back(previous.model_pyramids[previous_id]);
+  if(useRegistration())
+  {
+    catalogue.model_features_list.push_back(previous.model_features_list[previous_id]);
+  }
+  if(useGrouping())
+  {
+    catalogue.model_keypoints_list.push_back(previous.model_keypoints_list[previous_id]);
+    catalogue.model_descriptor_list.push_back(previous.model_descriptor_list[previous_id]);
+    catalogue.model_rf_list.push_back(previous.model_rf_list[previous_id]);
+    catalogue.hough_models.push_back(previous.hough_models[previous_id]);
+  }
+}
+
+void Recognizer::loadICPConfig(std::size_t model_id, Catalogue& catalogue) const
+{
+  // every level a cluster may share with the model
+  const CloudPyramid& pyramid = catalogue.model_pyramids[model_id];
+  std::vector<pcl::PointCloud<pcl::FPFHSignature33>::Ptr> model_features(pyramid.size());
+  for(std::size_t level = 0; level < pyramid.size(); level++)
+  {
+    model_features[level].reset(new pcl::PointCloud<pcl::FPFHSignature33>);
+    recognition_pipeline_->computeModelFeatures(pyramid[level], static_cast<int>(level), *model_features[level]);
+  }
+  catalogue.model_features_list.push_back(model_features);
+}
+
+void Recognizer::loadCGConfig(std::size_t model_id, Catalogue& catalogue) const
+{
+  // Keypoints, descriptors and reference frames
+  XyzRecognitionPipeline::Described model;
+  recognition_pipeline_->describeModel(catalogue.model_list[model_id], params_.keypoint_model_budget, model);
+  catalogue.model_keypoints_list.push_back(model.keypoints);
+  catalogue.model_descriptor_list.push_back(model.descriptors);
+  catalogue.model_rf_list.push_back(model.rf);
+
+  // Training the Hough votes
+  HoughModelPtr hough_model(new HoughModel(model.keypoints, model.rf));
+  if(!model.keypoints->empty())
+  {
+    GILBRETH_INFO_STREAM("Hough3D algorithm successfully trained for model " << catalogue.parts[model_id].name);
+  }
+  else
+  {
+    GILBRETH_ERROR_STREAM("Hough3D algorithm failed training for model " << catalogue.parts[model_id].name);
+  }
+
+  catalogue.hough_models.push_back(hough_model);
+}
+
+/**
+ * Structures shared by all the models of a catalogue, rebuilt from the per model data whenever the catalogue changes
+ */
+void Recognizer::buildCatalogueIndexes(Catalogue& catalogue) const
+{
+  // shape signatures for the coarse filter, symmetry axes pass through the model centroids
+  catalogue.coarse_filter = CoarseFilter(params_.prefilter_top_k, params_.down_sample);
+  for(std::size_t i = 0; i < catalogue.model_list.size(); i++)
+  {
+    catalogue.coarse_filter.addModel(*catalogue.model_list[i]);
+    Eigen::Vector4f centroid;
+    pcl::compute3DCentroid(*catalogue.model_list[i], centroid);
+    catalogue.model_symmetries[i].center = centroid.head<3>();
+  }
+
+  if(params_.planar)
+  {
+    catalogue.planar_recognizer.reset(new PlanarRecognizer(params_.planar_params));
+    for(std::size_t i = 0; i < catalogue.model_list.size(); i++)
+    {
+      catalogue.planar_recognizer->addModel(catalogue.model_list[i], catalogue.model_symmetries[i]);
+    }
+  }
+  else
+  {
+    catalogue.fine_alignment.reset(new FineAlignment(params_.fine_alignment_params));
+    for(std::size_t i = 0; i < catalogue.model_list.size(); i++)
+    {
+      catalogue.fine_alignment->addModel(catalogue.model_list[i]);
+    }
+  }
+
+  // one verifier and registration per pyramid level, with the distances scaled to its leaf size. The ids are the
+  // model ids, a model short of a level holds its coarsest one there, which registrationLevel() never selects
+  std::size_t levels = 0;
+  for(const CloudPyramid& pyramid : catalogue.model_pyramids)
+  {
+    levels = std::max(levels, pyramid.size());
+  }
+  catalogue.verifiers.clear();
+  catalogue.global_registrations.clear();
+  for(std::size_t level = 0; useRegistration() && level < levels; level++)
+  {
+    const float scale = static_cast<float>(1 << level);
+    VerificationParameters verification_params = params_.verification_params;
+    verification_params.max_sqr_distance *= scale * scale;
+    catalogue.verifiers.emplace_back(new HypothesisVerifier(verification_params));
+
+    GlobalRegistrationParameters registration_params = params_.global_registration_params;
+    registration_params.max_correspondence_distance *= scale;
+    if(params_.registration_method == "fgr")
+    {
+      catalogue.global_registrations.emplace_back(new GlobalRegistration(registration_params));
+    }
+
+    for(std::size_t i = 0; i < catalogue.model_list.size(); i++)
+    {
+      const std::size_t model_level = std::min(level, catalogue.model_pyramids[i].size() - 1);
+      catalogue.verifiers[level]->addModel(*catalogue.model_pyramids[i][model_level]);
+      if(!catalogue.global_registrations.empty())
+      {
+        catalogue.global_registrations[level]->addModel(catalogue.model_pyramids[i][model_level],
+                                                        catalogue.model_features_list[i][model_level]);
+      }
+    }
+  }
+
+  if(useGrouping())
+  {
+    buildDescriptorIndex(catalogue);
+  }
+}
+
+/**
+ * Single descriptor search index shared by all models, over the full, compressed or binary descriptors, or the
+ * vocabulary tree that also shortlists the models
+ */
+void Recognizer::buildDescriptorIndex(Catalogue& catalogue) const
+{
+  catalogue.descriptor_matching = params_.descriptor_matching;
+  if(catalogue.descriptor_matching == "pca_int8" &&
+     !catalogue.compressed_descriptor_index.build(catalogue.model_descriptor_list, params_.descriptor_pca_dimensions))
+  {
+    GILBRETH_WARN_STREAM("Recognition has too few model descriptors to compress them, using full descriptors");
+    catalogue.descriptor_matching = "flann";
+  }
+
+  if(catalogue.descriptor_matching == "vocabulary")
+  {
+    catalogue.vocabulary.reset(new VocabularyTree(params_.vocabulary_params));
+    if(!catalogue.vocabulary->build(catalogue.model_descriptor_list))
+    {
+      GILBRETH_WARN_STREAM("Recognition has no model descriptors to learn a vocabulary from, using full "
+                           "descriptors");
+      catalogue.vocabulary.reset();
+      catalogue.descriptor_matching = "flann";
+    }
+  }
+
+  if(catalogue.descriptor_matching == "pca_int8")
+  {
+    GILBRETH_INFO_STREAM("Recognition compressed " << catalogue.compressed_descriptor_index.size() <<
+                         " model descriptors to " << catalogue.compressed_descriptor_index.getDimensions() <<
+                         " dimensions (" << catalogue.compressed_descriptor_index.getCodeBytes() << " bytes, " <<
+                         catalogue.compressed_descriptor_index.getKernelName() << " kernel)");
+  }
+  else if(catalogue.descriptor_matching == "binary")
+  {
+    catalogue.binary_descriptor_index.build(catalogue.model_descriptor_list);
+    GILBRETH_INFO_STREAM("Recognition binarized " << catalogue.binary_descriptor_index.size() <<
+                         " model descriptors (" << catalogue.binary_descriptor_index.getCodeBytes() << " bytes, " <<
+                         catalogue.binary_descriptor_index.getKernelName() << " kernel)");
+  }
+  else if(catalogue.descriptor_matching == "vocabulary")
+  {
+    GILBRETH_INFO_STREAM("Recognition quantized the model descriptors into " <<
+                         catalogue.vocabulary->getWordCount() << " visual words, shortlisting " <<
+                         params_.vocabulary_shortlist << " models");
+  }
+  else
+  {
+    catalogue.descriptor_index.build(catalogue.model_descriptor_list);
+  }
+}
+
+/**
+ * Pose of the tracked object the cluster matches, moved along the belt. Holds when enough of the coarsest cluster
+ * level lies close to the model at that pose, otherwise the track is dropped and the cluster recognized.
+ */
+bool Recognizer::predictFromTrack(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                                  StageTimer& timer, Detection& result)
+{
+  StageTimer::Scope stage(timer, "tracking");
+  TrackPrediction prediction;
+  if(!tracker_->match(*scene_pyramid.front(), stamp, prediction))
+  {
+    return false;
+  }
+
+  // the model may have left the catalogue since the track started
+  std::vector<PartDescription>::const_iterator it = std::find_if(catalogue.parts.begin(), catalogue.parts.end(),
+                                                                 [&](const PartDescription& part)
+  {
+    return part.name == prediction.name;
+  });
+  if(it == catalogue.parts.end())
+  {
+    tracker_->drop(prediction.track_id);
+    return false;
+  }
+
+  const int model_id = static_cast<int>(it - catalogue.parts.begin());
+  const float ratio = catalogue.fine_alignment->inlierRatio(model_id, *scene_pyramid.back(), prediction.pose,
+                                                            params_.tracking_inlier_distance,
+                                                            params_.tracking_min_inlier_ratio);
+  GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Track " << prediction.track_id << " predicts " <<
+                            prediction.name << " explaining " << ratio << " of the scene");
+  if(ratio < params_.tracking_min_inlier_ratio)
+  {
+    tracker_->drop(prediction.track_id);
+    return false;
+  }
+
+  result.name = prediction.name;
+  result.model_id = model_id;
+  result.fitness_score = 0.0f;
+  result.inlier_ratio = ratio;
+  result.pose = prediction.pose;
+  result.track_id = prediction.track_id;
+  return true;
+}
+
+/**
+ * A random SAC-IA sample is consistent with any of the equivalent poses of a symmetric part, so proportionally
+ * fewer iterations reach the same chance of drawing a good one. This is the size of a registration round, see
+ * recognizeByRegistration
+ */
+int Recognizer::sacIaIterations(const Catalogue& catalogue, std::size_t model_id) const
+{
+  const Symmetry& symmetry = catalogue.model_symmetries[model_id];
+  int divisor = 1;
+  if(symmetry.type == Symmetry::CONTINUOUS)
+  {
+    divisor = params_.symmetry_continuous_divisor;
+  }
+  else if(symmetry.isSymmetric())
+  {
+    divisor = symmetry.order;
+  }
+  return std::max(1, params_.nr_iterations / std::max(1, divisor));
+}
+
+/**
+ * Index of the lowest fitness score or -1, reduced in model order so that ties always resolve to the same model
+ */
+int Recognizer::selectBestFitness(const Catalogue& catalogue, const Detections& results,
+                                  const std::vector<int>& candidates) const
+{
+  int best_index = -1;
+  float best_score = std::numeric_limits<float>::infinity();
+  for(int j : candidates)
+  {
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "model (" << j << ") " << catalogue.parts[j].name <<
+                              " fitnessScore " << results[j].fitness_score);
+    if(results[j].fitness_score < best_score)
+    {
+      best_index = j;
+      best_score = results[j].fitness_score;
+    }
+  }
+  return best_index;
+}
+
+/**
+ * Index of the highest inlier ratio or -1, the fitness score breaks ties and then the model order. Rejected
+ * hypotheses never win.
+ */
+int Recognizer::selectBestVerified(const Catalogue& catalogue, const Detections& results,
+                                   const std::vector<int>& candidates) const
+{
+  int best_index = -1;
+  for(int j : candidates)
+  {
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "model (" << j << ") " << catalogue.parts[j].name <<
+                              " inlierRatio " << results[j].inlier_ratio << " fitnessScore " <<
+                              results[j].fitness_score);
+    if(results[j].inlier_ratio < 0.0f)
+    {
+      continue;
+    }
+    if(best_index == -1 || results[j].inlier_ratio > results[best_index].inlier_ratio ||
+       (results[j].inlier_ratio == results[best_index].inlier_ratio &&
+        results[j].fitness_score < results[best_index].fitness_score))
+    {
+      best_index = j;
+    }
+  }
+  return best_index;
+}
+
+/**
+ * Runs the registration and the grouping strategies concurrently, each on its own workers. The first hypothesis
+ * whose scene inlier ratio reaches race_min_inlier_ratio is handed out right away and the other strategy is
+ * cancelled, it stops at its next check between stages or models. When no hypothesis passes, the better of the
+ * unverified ones is handed out, so that either strategy remains the fallback of the other.
+ */
+bool Recognizer::raceStrategies(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                                const std::vector<int>& candidates, const OperatingPoint& operating_point,
+                                StageTimer& timer, const DetectionCallback& on_detection)
+{
+  CancellationToken cancellation;
+  std::mutex race_mutex;
+  bool published = false;
+  Detection fallback;
+  float fallback_ratio = -1.0f;
+
+  auto finish = [&](bool found, const Detection& result, const char* strategy)
+  {
+    if(!found)
+    {
+      GILBRETH_INFO_STREAM_COND(params_.print_detailed_info && !cancellation.isCancelled(),
+                                "Race: " << strategy << " found no hypothesis");
+      return;
+    }
+
+    float ratio;
+    {
+      StageTimer::Scope stage(timer, "verification");
+      ratio = catalogue.fine_alignment->inlierRatio(result.model_id, *scene_pyramid.back(), result.pose,
+                                                    params_.race_inlier_distance, params_.race_min_inlier_ratio);
+    }
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Race: " << strategy << " proposes " << result.name <<
+                              " explaining " << ratio << " of the scene");
+    {
+      std::lock_guard<std::mutex> lock(race_mutex);
+      if(published)
+      {
+        return;
+      }
+      if(ratio < params_.race_min_inlier_ratio)
+      {
+        if(ratio > fallback_ratio)
+        {
+          fallback = result;
+          fallback_ratio = ratio;
+        }
+        return;
+      }
+      published = true;
+    }
+
+    cancellation.cancel();
+    GILBRETH_INFO_STREAM("Race won by " << strategy);
+    finishDetection(catalogue, stamp, scene_pyramid, result, operating_point, timer, on_detection);
+  };
+
+  std::exception_ptr registration_error;
+  std::thread registration_thread([&]()
+  {
+    try
+    {
+      Detection result;
+      const bool found = recognizeByRegistration(catalogue, scene_pyramid, candidates, *race_pool_, cancellation,
+                                                 timer, result);
+      finish(found, result, "registration");
+    }
+    catch(...)
+    {
+      registration_error = std::current_exception();
+      cancellation.cancel();
+    }
+  });
+
+  try
+  {
+    Detection result;
+    const bool found = recognizeByGrouping(catalogue, scene_pyramid, candidates, operating_point, cancellation,
+                                           timer, result);
+    finish(found, result, "grouping");
+  }
+  catch(...)
+  {
+    cancellation.cancel();
+    registration_thread.join();
+    throw;
+  }
+  registration_thread.join();
+  if(registration_error)
+  {
+    std::rethrow_exception(registration_error);
+  }
+
+  if(published)
+  {
+    return true;
+  }
+
+  const double duration = timer.elapsed();
+  if(fallback_ratio < 0.0f)
+  {
+    GILBRETH_ERROR_STREAM("-----------------------------");
+    GILBRETH_ERROR_STREAM("Recognition Failed, elapsed time: " << duration << " seconds");
+    GILBRETH_ERROR_STREAM("-----------------------------");
+    return false;
+  }
+
+  GILBRETH_WARN_STREAM("Race: no hypothesis passed verification, using the best one explaining " << fallback_ratio <<
+                       " of the scene");
+  finishDetection(catalogue, stamp, scene_pyramid, fallback, operating_point, timer, on_detection);
+  return true;
+}
+
+bool Recognizer::recognizePlanar(const Catalogue& catalogue, const Cloud::ConstPtr& scene,
+                                 const std::vector<int>& candidates, StageTimer& timer, Detection& result)
+{
+  StageTimer::Scope stage(timer, "planar");
+  SceneIndex<pcl::PointXYZ> scene_index;
+  scene_index.setInputCloud(scene, 0.0f);
+
+  Detections results_temp(catalogue.model_list.size());
+  thread_pool_->parallelFor(candidates.size(), [&](std::size_t worker_id, std::size_t c)
+  {
+    const std::size_t j = candidates[c];
+    PlanarResult planar_result;
+    results_temp[j].name = catalogue.parts[j].name;
+    results_temp[j].model_id = j;
+    results_temp[j].fitness_score = std::numeric_limits<float>::infinity();
+    if(catalogue.planar_recognizer->recognize(j, *scene_index.getKdTree(), planar_result))
+    {
+      results_temp[j].fitness_score = planar_result.score;
+      results_temp[j].pose = planar_result.transformation;
+    }
+  });
+
+  const int min_index = selectBestFitness(catalogue, results_temp, candidates);
+  if(min_index == -1)
+  {
+    return false;
+  }
+  result = results_temp[min_index];
+  return true;
+}
+
+/**
+ * FPFH features and SAC-IA or global registration on the coarsest pyramid level shared by each model and the
+ * cluster, so that both sides are described at the same leaf size. The models register in parallel, then every
+ * hypothesis is verified in candidate order against the best inlier ratio of the models before it and the highest
+ * inlier ratio wins. Returns false when no model registered or when cancelled.
+ */
+bool Recognizer::recognizeByRegistration(const Catalogue& catalogue, const CloudPyramid& scene_pyramid,
+                                         const std::vector<int>& candidates, ThreadPool& pool,
+                                         const CancellationToken& cancellation, StageTimer& timer,
+                                         Detection& result)
+{
+  // Scene search structures are built once per level and shared by every stage below, the feature radius
+  // searches are served by a uniform grid sized to that radius
+  const std::size_t levels = std::min(scene_pyramid.size(), catalogue.verifiers.size());
+  std::vector<std::size_t> model_levels(catalogue.model_list.size(), 0);
+  std::vector<std::unique_ptr<RegistrationScene> > scenes(levels);
+  for(int j : candidates)
+  {
+    model_levels[j] = std::min(levels, catalogue.model_pyramids[j].size()) - 1;
+    std::unique_ptr<RegistrationScene>& scene = scenes[model_levels[j]];
+    if(scene)
+    {
+      continue;
+    }
+
+    scene.reset(new RegistrationScene());
+    scene->features.reset(new pcl::PointCloud<pcl::FPFHSignature33>);
+    if(!recognition_pipeline_->computeSceneFeatures(scene_pyramid[model_levels[j]], model_levels[j], scene->index,
+                                                    timer, cancellation, *scene->features) ||
+       cancellation.isCancelled())
+    {
+      return false;
+    }
+    if(catalogue.global_registrations.size() > model_levels[j])
+    {
+      GlobalRegistration::setScene(scene_pyramid[model_levels[j]], scene->features, scene->registration);
+    }
+  }
+
+  StageTimer::Scope registration_stage(timer, "registration");
+
+  Detections results_temp(catalogue.model_list.size());
+  for(int j : candidates)
+  {
+    results_temp[j].name = catalogue.parts[j].name;
+    results_temp[j].model_id = j;
+    results_temp[j].fitness_score = std::numeric_limits<float>::infinity();
+    results_temp[j].inlier_ratio = -1.0f;
+  }
+
+  // hypotheses of the registration, verified once every worker is done
+  std::vector<char> registered(catalogue.model_list.size(), 0);
+
+  if(!catalogue.global_registrations.empty())
+  {
+    // deterministic feature registration, the scene feature trees are built once for all the models
+    pool.parallelFor(candidates.size(), [&](std::size_t worker_id, std::size_t c)
+    {
+      const std::size_t j = candidates[c];
+      if(cancellation.isCancelled())
+      {
+        return;
+      }
+      const RegistrationScene& scene = *scenes[model_levels[j]];
+      GlobalRegistrationResult registration_result;
+      if(catalogue.global_registrations[model_levels[j]]->align(j, scene.registration, *scene.index.getKdTree(), 0.0,
+                                                                registration_result))
+      {
+        results_temp[j].pose = registration_result.transformation;
+        registered[j] = 1;
+      }
+    });
+  }
+  else
+  {
+    // ICP
+    // Intialize the parameters in the Sample Consensus Intial Alignment (SAC-IA)
+    // algorithm, every worker owns an instance per level and all of them share the scene search tree of the level
+    std::vector<std::unique_ptr<SacIa> > worker_sac_ia(pool.size() * levels);
+    pool.parallelFor(candidates.size(), [&](std::size_t worker_id, std::size_t c)
+    {
+      const std::size_t j = candidates[c];
+      if(cancellation.isCancelled())
+      {
+        return;
+      }
+      const std::size_t level = model_levels[j];
+      std::unique_ptr<SacIa>& sac_ia_ = worker_sac_ia[worker_id * levels + level];
+      if(!sac_ia_)
+      {
+        // the distances follow the leaf size of the level
+        const float scale = static_cast<float>(1 << level);
+        sac_ia_.reset(new SacIa());
+        sac_ia_->setMinSampleDistance(params_.min_sample_distance * scale);
+        sac_ia_->setMaxCorrespondenceDistance(params_.max_correspondence_distance * scale);
+        sac_ia_->setMaximumIterations(params_.nr_iterations);
+        sac_ia_->setSearchMethodTarget(scenes[level]->index.getKdTree(), true);
+        sac_ia_->setInputTarget(scene_pyramid[level]);
+        sac_ia_->setTargetFeatures(scenes[level]->features);
+      }
+
+      // a symmetric part spends the full budget in rounds of its reduced iteration count and stops after the first
+      // round whose pose verifies, each round starts from the best pose so far
+      const int round_iterations = sacIaIterations(catalogue, j);
+      const int rounds = params_.symmetry_stop_inlier_ratio > 0.0f ?
+                         (params_.nr_iterations + round_iterations - 1) / round_iterations : 1;
+      sac_ia_->setMaximumIterations(round_iterations);
+      sac_ia_->setInputSource(catalogue.model_pyramids[j][level]);
+      sac_ia_->setSourceFeatures(catalogue.model_features_list[j][level]);
+      pcl::PointCloud<pcl::PointXYZ> registration_output;
+      Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+      for(int round = 0; round < rounds && !cancellation.isCancelled(); round++)
+      {
+        sac_ia_->align(registration_output, pose);
+        pose = sac_ia_->getFinalTransformation();
+        VerificationResult verification;
+        if(round + 1 < rounds &&
+           catalogue.verifiers[level]->verify(j, *scenes[level]->index.getKdTree(), pose,
+                                              params_.symmetry_stop_inlier_ratio, verification) &&
+           verification.inlier_ratio >= params_.symmetry_stop_inlier_ratio)
+        {
+          GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "model (" << j << ") " << catalogue.parts[j].name <<
+                                    " verified after " << round + 1 << " of " << rounds << " registration rounds");
+          break;
+        }
+      }
+      results_temp[j].pose = pose;
+      registered[j] = 1;
+    });
+  }
+  registration_stage.stop();
+
+  // the verification of a hypothesis stops early once it can not reach the best ratio of the models before it,
+  // only the hypotheses that can still win are scored on every model point. Running in candidate order keeps the
+  // early decisions, and so the winner, independent of the order in which the workers finished
+  StageTimer::Scope verification_stage(timer, "verification");
+  float best_ratio = 0.0f;
+  for(int j : candidates)
+  {
+    if(cancellation.isCancelled())
+    {
+      return false;
+    }
+    if(!registered[j])
+    {
+      continue;
+    }
+
+    VerificationResult verification;
+    if(!catalogue.verifiers[model_levels[j]]->verify(j, *scenes[model_levels[j]]->index.getKdTree(),
+                                                     results_temp[j].pose, best_ratio, verification))
+    {
+      GILBRETH_INFO_STREAM_COND(params_.print_detailed_info && verification.rejected, "model (" << j << ") " <<
+                                catalogue.parts[j].name << " rejected after " << verification.evaluated <<
+                                " points");
+      continue;
+    }
+
+    results_temp[j].fitness_score = verification.fitness_score;
+    results_temp[j].inlier_ratio = verification.inlier_ratio;
+    best_ratio = std::max(best_ratio, verification.inlier_ratio);
+  }
+
+  const int min_index = selectBestVerified(catalogue, results_temp, candidates);
+  if(min_index == -1 || cancellation.isCancelled())
+  {
+    return false;
+  }
+  result = results_temp[min_index];
+  return true;
+}
+
+/**
+ * SHOT correspondences clustered by the trained Hough3D recognizers on the full resolution cluster, the model
+ * with the most grouped correspondences wins. Returns false when no model was found or when cancelled.
+ */
+bool Recognizer::recognizeByGrouping(const Catalogue& catalogue, const CloudPyramid& scene_pyramid,
+                                     const std::vector<int>& candidates, const OperatingPoint& operating_point,
+                                     const CancellationToken& cancellation, StageTimer& timer, Detection& result)
+{
+  // Scene search structures are built once and shared by every stage below, the descriptor radius searches
+  // are served by a uniform grid sized to that radius
+  SceneIndex<pcl::PointXYZ> scene_index;
+  XyzRecognitionPipeline::Described described_scene;
+  if(!recognition_pipeline_->describeScene(scene_pyramid.front(), operating_point.keypoint_budget, scene_index,
+                                           timer, cancellation, described_scene))
+  {
+    return false;
+  }
+  const Cloud::Ptr& scene_keypoints = described_scene.keypoints;
+  const pcl::PointCloud<pcl::SHOT352>::Ptr& scene_descriptors = described_scene.descriptors;
+  const pcl::PointCloud<pcl::ReferenceFrame>::Ptr& scene_rf = described_scene.rf;
+  timer.setKeypoints(scene_keypoints->size());
+
+  //  Find Model-Scene Correspondences, each scene descriptor is queried once against all the candidate models, the
+  // hits of the models rejected by the pre-filter are dropped before grouping
+  StageTimer::Scope matching_stage(timer, "matching");
+  std::vector<pcl::CorrespondencesPtr> model_scene_corrs_list;
+  std::vector<int> shortlist = candidates;
+  if(catalogue.descriptor_matching == "vocabulary")
+  {
+    // only the models voted for by the visual words of the scene are matched and grouped
+    shortlist = catalogue.vocabulary->shortlist(*scene_descriptors, params_.vocabulary_shortlist, candidates);
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Vocabulary shortlisted " << shortlist.size() << " of " <<
+                              candidates.size() << " models");
+    catalogue.vocabulary->match(*scene_descriptors, params_.descr_dis_thrd, shortlist, model_scene_corrs_list);
+  }
+  else if(catalogue.descriptor_matching == "pca_int8")
+  {
+    catalogue.compressed_descriptor_index.match(*scene_descriptors, params_.descr_dis_thrd, shortlist,
+                                                model_scene_corrs_list);
+  }
+  else if(catalogue.descriptor_matching == "binary")
+  {
+    catalogue.binary_descriptor_index.match(*scene_descriptors, params_.max_hamming_distance, shortlist,
+                                            model_scene_corrs_list);
+  }
+  else
+  {
+    catalogue.descriptor_index.match(*scene_descriptors, params_.descr_dis_thrd, shortlist, model_scene_corrs_list);
+  }
+  matching_stage.stop();
+  if(cancellation.isCancelled())
+  {
+    return false;
+  }
+
+  // Hough voting of all the shortlisted models at once, the trained votes are shared and each worker votes into
+  // its own accumulators
+  StageTimer::Scope grouping_stage(timer, "grouping");
+  std::vector<const HoughModel*> hough_models;
+  std::vector<pcl::CorrespondencesConstPtr> hough_corrs;
+  for(int j : shortlist)
+  {
+    hough_models.push_back(catalogue.hough_models[j].get());
+    hough_corrs.push_back(model_scene_corrs_list[j]);
+  }
+  std::vector<HoughInstances> instances;
+  const HoughGrouping grouping(params_.hough_params);
+  grouping.recognize(hough_models, scene_keypoints, *scene_rf, hough_corrs, *thread_pool_, cancellation, instances);
+  if(cancellation.isCancelled())
+  {
+    return false;
+  }
+
+  Detections results_temp(catalogue.model_list.size());
+  std::vector<int> total_corrs(catalogue.model_list.size(), -1);
+  for(std::size_t c = 0; c < shortlist.size(); c++)
+  {
+    const std::size_t j = shortlist[c];
+    const PoseList& rototranslations = instances[c].transformations;
+    const std::vector<pcl::Correspondences>& clustered_corrs = instances[c].clustered_corrs;
+
+    if(clustered_corrs.empty())
+    {
+      continue;
+    }
+
+    // instances at the same pose, up to a spin of a symmetric part, are the same hypothesis and merge their votes.
+    // Every model is scored by its strongest hypothesis, so symmetric and other parts compare alike
+    std::vector<int> groups = groupEquivalentPoses(rototranslations, catalogue.model_symmetries[j],
+                                                   params_.hough_params.bin_size, params_.symmetry_merge_angle);
+    std::vector<int> group_corrs(groups.size(), 0);
+    for(std::size_t k = 0; k < groups.size(); k++)
+    {
+      group_corrs[groups[k]] += clustered_corrs[k].size();
+    }
+    const std::size_t best_group = std::max_element(group_corrs.begin(), group_corrs.end()) - group_corrs.begin();
+    total_corrs[j] = group_corrs[best_group];
+    results_temp[j].name = catalogue.parts[j].name;
+    results_temp[j].model_id = j;
+    results_temp[j].pose = canonicalizePose(rototranslations[best_group], catalogue.model_symmetries[j]);
+  }
+  grouping_stage.stop();
+
+  // Reduce in model order so that ties always resolve to the same model
+  int max_corrs = -1;
+  for(int j : shortlist)
+  {
+    if(model_scene_corrs_list[j]->empty())
+    {
+      GILBRETH_WARN_STREAM_COND(params_.print_detailed_info, "Model (" << j << ") " << catalogue.parts[j].name <<
+                                " contains no scene correspondences");
+      continue;
+    }
+
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Model (" << j << ") " << catalogue.parts[j].name <<
+                              " has " << model_scene_corrs_list[j]->size() << " correspondences");
+
+    if(total_corrs[j] < 0)
+    {
+      continue;
+    }
+
+    if(total_corrs[j] > max_corrs)
+    {
+      max_corrs = total_corrs[j];
+      result = results_temp[j];
+    }
+
+    GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Model (" << j << ") " << catalogue.parts[j].name <<
+                              " contains " << total_corrs[j] << " recognized correspondences");
+  }
+  return max_corrs != -1;
+}
+
+/**
+ * Canonicalizes and refines the pose of a recognized model, moves its pick point along and hands it out
+ */
+void Recognizer::finishDetection(const Catalogue& catalogue, double stamp, const CloudPyramid& scene_pyramid,
+                                 Detection result, const OperatingPoint& operating_point, StageTimer& timer,
+                                 const DetectionCallback& on_detection)
+{
+  timer.setResult(result.name);
+  GILBRETH_INFO_STREAM("-----------------------------");
+  GILBRETH_INFO_STREAM("Recognition found object: " << result.name << " in " << timer.elapsed() << " seconds");
+  GILBRETH_INFO_STREAM("-----------------------------");
+
+  result.pose = canonicalizePose(result.pose, catalogue.model_symmetries[result.model_id]);
+
+  // Point-to-plane fine alignment of the model to the scene, the planar search has already refined its pose
+  if(!params_.planar)
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FineAlignmentResult refinement;
+    // a coarsened cluster stops on the first level whose model leaf reaches its own
+    const int finest_level = finestLevel(params_.down_sample, operating_point.leaf_size, params_.pyramid_levels);
+    const bool refined = catalogue.fine_alignment->refine(result.model_id, scene_pyramid, result.pose, refinement,
+                                                          operating_point.icp_iterations, finest_level);
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    timer.add("fine_alignment", duration);
+    if(refined)
+    {
+      GILBRETH_INFO_STREAM_COND(params_.print_detailed_info && refinement.converged, "Fine alignment converged after "
+                                << refinement.iterations << " iterations, with score: " << refinement.fitness_score <<
+                                " in " << duration << " seconds");
+
+      GILBRETH_ERROR_STREAM_COND(!refinement.converged, "Fine alignment did not converge, using un-converged pose");
+
+      result.pose = refinement.transformation;
+    }
+    else
+    {
+      GILBRETH_ERROR_STREAM("Fine alignment found too few correspondences, using the recognition pose");
+    }
+  }
+
+  if(tracker_)
+  {
+    tracker_->update(result.track_id, result.name, *scene_pyramid.front(), stamp, result.pose);
+  }
+
+  // Transform pick up point from model to scene
+  if(!setPickPoint(catalogue.parts[result.model_id], result))
+  {
+    GILBRETH_ERROR_STREAM("Recognition has no valid pick pose for object: " << result.name << ", not published");
+    return;
+  }
+  on_detection(result);
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,33 @@
+#include "gilbreth_perception/ros_log.h"
+#include "gilbreth_perception/log.h"
+#include <ros/console.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+void forwardLogToRos()
+{
+  setLogSink([](LogLevel level, const std::string& message)
+  {
+    switch(level)
+    {
+    case LogLevel::DEBUG:
+      ROS_DEBUG("%s", message.c_str());
+      break;
+    case LogLevel::INFO:
+      ROS_INFO("%s", message.c_str());
+      break;
+    case LogLevel::WARN:
+      ROS_WARN("%s", message.c_str());
+      break;
+    case LogLevel::ERROR:
+      ROS_ERROR("%s", message.c_str());
+      break;
+    }
+  });
+}
+
+} // namespace perception
+} // namespace gilbreth
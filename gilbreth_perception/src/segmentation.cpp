@@ -0,0 +1,91 @@
+#include "gilbreth_perception/segmentation.h"
+#include "gilbreth_perception/log.h"
+#include <pcl/filters/extract_indices.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/segmentation/extract_clusters.h>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+Segmenter::Segmenter(const SegmentationParameters& params):
+  params_(params)
+{
+}
+
+bool Segmenter::segment(const Cloud::ConstPtr& scene, StageTimer& timer, std::vector<Cloud::Ptr>& clusters) const
+{
+  return segment(XyzView::fromCloud(*scene), scene->header, timer, clusters);
+}
+
+bool Segmenter::segment(const XyzView& scene, const pcl::PCLHeader& header, StageTimer& timer,
+                        std::vector<Cloud::Ptr>& clusters) const
+{
+  clusters.clear();
+
+  // Filter the input scene, the region of interest is cropped in one pass straight from the frame buffer
+  Cloud::Ptr scene_filtered(new Cloud());
+  {
+    StageTimer::Scope stage(timer, "passthrough");
+    scene.cropTo(params_.roi_min, params_.roi_max, *scene_filtered);
+  }
+
+  if(scene_filtered->empty())
+  {
+    GILBRETH_WARN_STREAM("Segmentation found no points after applying passthrough filters");
+    return false;
+  }
+  GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Segmentation will process cloud with " <<
+                            scene_filtered->size() << " points");
+
+  // Downsample scene
+  Cloud::Ptr downsampled(new Cloud());
+  {
+    StageTimer::Scope stage(timer, "downsample");
+    pcl::VoxelGrid<pcl::PointXYZ> sor;
+    sor.setInputCloud(scene_filtered);
+    sor.setLeafSize(params_.down_sample, params_.down_sample, params_.down_sample);
+    sor.filter(*downsampled);
+  }
+  GILBRETH_INFO_STREAM_COND(params_.print_detailed_info, "Segmentation downsampled scene to " << downsampled->size() <<
+                            " points with leafsize " << params_.down_sample);
+
+  // Cluster Extraction
+  StageTimer::Scope clustering_stage(timer, "clustering");
+  pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>());
+  tree->setInputCloud(downsampled);
+  std::vector<pcl::PointIndices> cluster_indices;
+  pcl::EuclideanClusterExtraction<pcl::PointXYZ> ec;
+  ec.setClusterTolerance(params_.cluster_tolerance);
+  ec.setMinClusterSize(params_.min_cluster_size);
+  ec.setMaxClusterSize(params_.max_cluster_size);
+  ec.setSearchMethod(tree);
+  ec.setInputCloud(downsampled);
+  ec.extract(cluster_indices);
+
+  if(cluster_indices.empty())
+  {
+    GILBRETH_ERROR_STREAM("Segmentation found no clusters after applying Clustering Extraction");
+    return false;
+  }
+
+  pcl::PointIndices::Ptr indices(new pcl::PointIndices);
+  pcl::ExtractIndices<pcl::PointXYZ> extract;
+  extract.setInputCloud(downsampled);
+  extract.setNegative(false);
+  for(const pcl::PointIndices& cluster_index : cluster_indices)
+  {
+    Cloud::Ptr cluster(new Cloud());
+    *indices = cluster_index;
+    extract.setIndices(indices);
+    extract.filter(*cluster);
+    cluster->header = header;
+    clusters.push_back(cluster);
+  }
+  return true;
+}
+
+} // namespace perception
+} // namespace gilbreth
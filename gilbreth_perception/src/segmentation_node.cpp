@@ -1,28 +1,21 @@
-#include <pcl/console/parse.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/filters/voxel_grid.h>
-#include <pcl/kdtree/kdtree_flann.h>
+#include "gilbreth_perception/point_cloud2_view.h"
+#include "gilbreth_perception/ros_log.h"
+#include "gilbreth_perception/segmentation.h"
+#include "gilbreth_perception/stage_timer.h"
+#include <memory>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/segmentation/extract_clusters.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <XmlRpcException.h>
 
-// Algorithm params
-double down_sample(0.01);
-double x_l, x_u, y_l, y_u, z_l, z_u;
-bool print_detailed_info(false);
-uint32_t g_min_cluster_size = 80;
-uint32_t g_max_cluster_size = 25000;
-double g_cluster_tolerance = 0.1;
-
+std::unique_ptr<gilbreth::perception::Segmenter> segmenter;
 ros::Publisher pub;
 
 bool loadParameter()
 {
+  gilbreth::perception::SegmentationParameters params;
   try
   {
 
@@ -33,116 +26,63 @@ bool loadParameter()
     ros::NodeHandle ph("~");
 
     ph.getParam("segmentation", parameter_map);
-    down_sample = static_cast<double>(parameter_map["down_sample"]);
-    g_min_cluster_size = static_cast<int>(parameter_map["min_cluster_size"]);
-    g_max_cluster_size = static_cast<int>(parameter_map["max_cluster_size"]);
-    g_cluster_tolerance = static_cast<double>(parameter_map["cluster_tolerance"]);
+    params.down_sample = static_cast<double>(parameter_map["down_sample"]);
+    params.min_cluster_size = static_cast<int>(parameter_map["min_cluster_size"]);
+    params.max_cluster_size = static_cast<int>(parameter_map["max_cluster_size"]);
+    params.cluster_tolerance = static_cast<double>(parameter_map["cluster_tolerance"]);
 
     ph.getParam("segmentation/camera_roi", camera_roi);
-    x_l = camera_roi["x"][0];
-    x_u = camera_roi["x"][1];
-    y_l = camera_roi["y"][0];
-    y_u = camera_roi["y"][1];
-    z_l = camera_roi["z"][0];
-    z_u = camera_roi["z"][1];
+    params.roi_min = Eigen::Vector3f(static_cast<double>(camera_roi["x"][0]), static_cast<double>(camera_roi["y"][0]),
+                                     static_cast<double>(camera_roi["z"][0]));
+    params.roi_max = Eigen::Vector3f(static_cast<double>(camera_roi["x"][1]), static_cast<double>(camera_roi["y"][1]),
+                                     static_cast<double>(camera_roi["z"][1]));
 
     ph.getParam("segmentation/switches", switch_map);
-    print_detailed_info = static_cast<bool>(switch_map["print_detailed_info"]);
+    params.print_detailed_info = static_cast<bool>(switch_map["print_detailed_info"]);
   }
   catch(XmlRpc::XmlRpcException& e)
   {
     ROS_ERROR("Failed to load segmentation parameters: %s",e.getMessage().c_str());
     return false;
   }
+
+  segmenter.reset(new gilbreth::perception::Segmenter(params));
   return true;
 }
 
 void cloudCb(const sensor_msgs::PointCloud2ConstPtr &cloud_msg)
 {
-  ros::Time start_time = ros::Time::now();
-
-  pcl::PointCloud<pcl::PointXYZ>::Ptr scene_raw(new pcl::PointCloud<pcl::PointXYZ>());
-  pcl::PointCloud<pcl::PointXYZ>::Ptr scene_filtered(new pcl::PointCloud<pcl::PointXYZ>());
-  pcl::PointCloud<pcl::PointXYZ>::Ptr scene(new pcl::PointCloud<pcl::PointXYZ>());
-  pcl::PassThrough<pcl::PointXYZ> pass;
-
-  pcl::fromROSMsg(*cloud_msg, *scene_raw);
-  // Filter the input scene
-  pass.setInputCloud(scene_raw);
-  pass.setFilterFieldName("z");
-  pass.setFilterLimits(z_l, z_u);
-  pass.filter(*scene_filtered);
-
-  pass.setInputCloud(scene_filtered);
-  pass.setFilterFieldName("x");
-  pass.setFilterLimits(x_l, x_u);
-  pass.filter(*scene_filtered);
-
-  pass.setInputCloud(scene_filtered);
-  pass.setFilterFieldName("y");
-  pass.setFilterLimits(y_l, y_u);
-  pass.filter(*scene_filtered);
-
-  if (scene_filtered->points.size() <= 0)
+  // the frame is read in place, only the points in the region of interest are copied
+  gilbreth::perception::StageTimer timer;
+  gilbreth::perception::XyzView scene_raw;
   {
-    ROS_WARN("Segmentation found no points after applying passthrough filters");
-    return;
+    gilbreth::perception::StageTimer::Scope stage(timer, "conversion");
+    if (!gilbreth::perception::makeXyzView(*cloud_msg, scene_raw))
+    {
+      return;
+    }
   }
 
-  ROS_INFO_COND(print_detailed_info,"Segmentation will process cloud with %lu points",scene_filtered->size());
-
-  // Downsample scene
-  pcl::VoxelGrid<pcl::PointXYZ> sor;
-  sor.setInputCloud(scene_filtered);
-  sor.setLeafSize(down_sample, down_sample, down_sample);
-  sor.filter(*scene);
-
-  ROS_INFO_COND(print_detailed_info,"Segmentation downsampled scene to %lu points with leafsize %f",scene->size(),down_sample);
-
-  // Cluster Extraction
-  pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>());
-  tree->setInputCloud(scene);
-  std::vector<pcl::PointIndices> cluster_indices;
-  pcl::EuclideanClusterExtraction<pcl::PointXYZ> ec;
-  ec.setClusterTolerance(g_cluster_tolerance);
-  ec.setMinClusterSize(g_min_cluster_size);
-  ec.setMaxClusterSize(g_max_cluster_size);
-  ec.setSearchMethod(tree);
-  ec.setInputCloud(scene);
-  ec.extract(cluster_indices);
-
-  if(cluster_indices.empty())
+  pcl::PCLHeader header;
+  pcl_conversions::toPCL(cloud_msg->header, header);
+  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> clusters;
+  if (!segmenter->segment(scene_raw, header, timer, clusters))
   {
-    ROS_ERROR("Segmentation found no clusters after applying Clustering Extraction");
     return;
   }
 
-  // Extracting and publishing cluster
-  pcl::PointIndices::Ptr indices(new pcl::PointIndices);
-  pcl::ExtractIndices<pcl::PointXYZ> extract;
-
-  for (int i = 0; i < cluster_indices.size(); i++)
+  // Publishing the clusters
+  for (const pcl::PointCloud<pcl::PointXYZ>::Ptr& cluster_cloud : clusters)
   {
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cluster_cloud(new pcl::PointCloud<pcl::PointXYZ>());
     sensor_msgs::PointCloud2 output;
-
-    *indices = cluster_indices[i];
-    extract.setInputCloud(scene);
-    extract.setIndices(indices);
-    extract.setNegative(false);
-    extract.filter(*cluster_cloud);
-
     pcl::toROSMsg(*cluster_cloud, output);
-    output.header.stamp = cloud_msg->header.stamp;
+    // the PCL header only keeps microseconds, the frame and the exact stamp come from the message
+    output.header = cloud_msg->header;
     pub.publish(output);
-
-    if (print_detailed_info)
-    {
-      double elapsed_time = (ros::Time::now() - start_time).toSec();
-      ROS_INFO("Segmentation Found %lu clusters in %f seconds",cluster_indices.size(),elapsed_time);
-    }
   }
 
+  ROS_INFO_COND(segmenter->getParameters().print_detailed_info, "Segmentation Found %lu clusters in %f seconds",
+                clusters.size(), timer.elapsed());
 }
 
 int main(int argc, char **argv) {
@@ -150,6 +90,7 @@ int main(int argc, char **argv) {
   // Initialize ROS
   ros::init(argc, argv, "segmentation_node");
   ros::NodeHandle nh;
+  gilbreth::perception::forwardLogToRos();
 
   if(!loadParameter())
   {
@@ -159,7 +100,7 @@ int main(int argc, char **argv) {
   // Create a ROS subscriber for the input point cloud
   ros::Subscriber sub_1 = nh.subscribe<sensor_msgs::PointCloud2>("scene_point_cloud", 1, cloudCb);
   // ROS publisher
-  pub = nh.advertise<sensor_msgs::PointCloud2>("segmentation_result", 10);
+  pub = nh.advertise<sensor_msgs::PointCloud2>("segmentation_result", 100);
   ROS_INFO("Segmentation Node subscribed to %s",pub.getTopic().c_str());
   ROS_INFO("Segmentation Node Ready ...");
   // Spin
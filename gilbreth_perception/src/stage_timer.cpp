@@ -0,0 +1,130 @@
+#include "gilbreth_perception/stage_timer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+StageTimer::StageTimer():
+  start_(Clock::now()),
+  points_(0),
+  keypoints_(0)
+{
+}
+
+void StageTimer::add(const std::string& name, double seconds)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(Stage& stage : stages_)
+  {
+    if(stage.name == name)
+    {
+      stage.duration += seconds;
+      return;
+    }
+  }
+
+  Stage stage;
+  stage.name = name;
+  stage.duration = seconds;
+  stages_.push_back(stage);
+}
+
+double StageTimer::elapsed() const
+{
+  return std::chrono::duration<double>(Clock::now() - start_).count();
+}
+
+std::vector<StageTimer::Stage> StageTimer::getStages() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stages_;
+}
+
+void StageTimer::setPoints(std::size_t points)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  points_ = points;
+}
+
+void StageTimer::setKeypoints(std::size_t keypoints)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  keypoints_ = keypoints;
+}
+
+void StageTimer::setResult(const std::string& result)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  result_ = result;
+}
+
+std::size_t StageTimer::getPoints() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return points_;
+}
+
+std::size_t StageTimer::getKeypoints() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return keypoints_;
+}
+
+std::string StageTimer::getResult() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return result_;
+}
+
+LatencyStatistics::LatencyStatistics(std::size_t window):
+  window_(window > 0 ? window : 1)
+{
+}
+
+void LatencyStatistics::add(const std::string& stage, double seconds)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Window& window = stages_[stage];
+  if(window.samples.size() < window_)
+  {
+    window.samples.push_back(seconds);
+    return;
+  }
+
+  window.samples[window.next] = seconds;
+  window.next = (window.next + 1) % window_;
+}
+
+LatencyStatistics::Percentiles LatencyStatistics::getPercentiles(const std::string& stage) const
+{
+  std::vector<double> sorted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Window>::const_iterator it = stages_.find(stage);
+    if(it == stages_.end())
+    {
+      return Percentiles();
+    }
+    sorted = it->second.samples;
+  }
+
+  std::sort(sorted.begin(), sorted.end());
+  auto rank = [&sorted](double p)
+  {
+    const std::size_t r = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(std::max<std::size_t>(r, 1), sorted.size()) - 1];
+  };
+
+  Percentiles percentiles;
+  percentiles.p50 = rank(0.50);
+  percentiles.p95 = rank(0.95);
+  percentiles.p99 = rank(0.99);
+  percentiles.samples = sorted.size();
+  return percentiles;
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,127 @@
+#include "gilbreth_perception/symmetry.h"
+#include <cmath>
+
+namespace
+{
+
+/**
+ * Splits a rotation into swing * twist where the twist spins about the given axis (in the frame the rotation is
+ * applied to), returns the twist angle.
+ */
+float twistAngle(const Eigen::Quaternionf& q, const Eigen::Vector3f& axis)
+{
+  return 2.0f * std::atan2(q.vec().dot(axis), q.w());
+}
+
+/**
+ * Reduces an angle to [-period/2, period/2], a period of 0 stands for continuous symmetry and always yields 0.
+ */
+float reduceAngle(float angle, float period)
+{
+  if(period <= 0.0f)
+  {
+    return 0.0f;
+  }
+  return angle - period * std::round(angle / period);
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+float Symmetry::period() const
+{
+  if(type == N_FOLD && order > 0)
+  {
+    return 2.0f * static_cast<float>(M_PI) / order;
+  }
+  return type == CONTINUOUS ? 0.0f : 2.0f * static_cast<float>(M_PI);
+}
+
+bool parseSymmetry(const std::string& type, int order, Symmetry& symmetry)
+{
+  if(type == "continuous")
+  {
+    symmetry.type = Symmetry::CONTINUOUS;
+  }
+  else if(type == "n_fold")
+  {
+    symmetry.type = Symmetry::N_FOLD;
+    symmetry.order = order;
+  }
+  else if(type == "none")
+  {
+    symmetry.type = Symmetry::NONE;
+  }
+  else
+  {
+    return false;
+  }
+  return symmetry.type != Symmetry::N_FOLD || symmetry.order > 0;
+}
+
+Eigen::Matrix4f canonicalizePose(const Eigen::Matrix4f& model_to_scene, const Symmetry& symmetry)
+{
+  if(!symmetry.isSymmetric())
+  {
+    return model_to_scene;
+  }
+
+  // spinning the model about its axis first, x -> S (x - c) + c, leaves the part unchanged
+  const Eigen::Matrix3f rotation = model_to_scene.block<3, 3>(0, 0);
+  const float twist = twistAngle(Eigen::Quaternionf(rotation), symmetry.axis);
+  const float spin = reduceAngle(twist, symmetry.period()) - twist;
+  const Eigen::Matrix3f canonical_rotation = rotation * Eigen::AngleAxisf(spin, symmetry.axis).toRotationMatrix();
+
+  Eigen::Matrix4f canonical = model_to_scene;
+  canonical.block<3, 3>(0, 0) = canonical_rotation;
+  canonical.block<3, 1>(0, 3) += (rotation - canonical_rotation) * symmetry.center;
+  return canonical;
+}
+
+bool equivalentPoses(const Eigen::Matrix4f& a, const Eigen::Matrix4f& b, const Symmetry& symmetry,
+                     float max_translation, float max_angle)
+{
+  const Eigen::Vector3f center_a = a.block<3, 3>(0, 0) * symmetry.center + a.block<3, 1>(0, 3);
+  const Eigen::Vector3f center_b = b.block<3, 3>(0, 0) * symmetry.center + b.block<3, 1>(0, 3);
+  if((center_a - center_b).norm() > max_translation)
+  {
+    return false;
+  }
+
+  // relative rotation in the model frame with the equivalent spin removed
+  const Eigen::Matrix3f relative = a.block<3, 3>(0, 0).transpose() * b.block<3, 3>(0, 0);
+  Eigen::Quaternionf q(relative);
+  if(symmetry.isSymmetric())
+  {
+    const float twist = twistAngle(q, symmetry.axis);
+    const float spin = reduceAngle(twist, symmetry.period()) - twist;
+    q = q * Eigen::Quaternionf(Eigen::AngleAxisf(spin, symmetry.axis));
+  }
+  return Eigen::AngleAxisf(q.normalized()).angle() <= max_angle;
+}
+
+std::vector<int> groupEquivalentPoses(const PoseList& poses, const Symmetry& symmetry, float max_translation,
+                                      float max_angle)
+{
+  std::vector<int> groups(poses.size());
+  for(std::size_t i = 0; i < poses.size(); i++)
+  {
+    groups[i] = static_cast<int>(i);
+    for(std::size_t j = 0; j < i; j++)
+    {
+      if(groups[j] == static_cast<int>(j) && equivalentPoses(poses[j], poses[i], symmetry, max_translation, max_angle))
+      {
+        groups[i] = static_cast<int>(j);
+        break;
+      }
+    }
+  }
+  return groups;
+}
+
+} // namespace perception
+} // namespace gilbreth
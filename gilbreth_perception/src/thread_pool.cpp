@@ -0,0 +1,112 @@
+#include "gilbreth_perception/thread_pool.h"
+#include <algorithm>
+
+namespace gilbreth
+{
+namespace perception
+{
+
+ThreadPool::ThreadPool(std::size_t num_threads):
+  task_(nullptr),
+  count_(0),
+  next_item_(0),
+  pending_(0),
+  generation_(0),
+  stop_(false)
+{
+  if(num_threads == 0)
+  {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for(std::size_t i = 0; i < num_threads; i++)
+  {
+    workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for(std::thread& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const Task& task)
+{
+  if(count == 0)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  count_ = count;
+  next_item_ = 0;
+  pending_ = count;
+  error_ = nullptr;
+  generation_++;
+  work_cv_.notify_all();
+
+  done_cv_.wait(lock, [this]() { return pending_ == 0; });
+  task_ = nullptr;
+
+  if(error_)
+  {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::workerLoop(std::size_t worker_id)
+{
+  std::uint64_t seen_generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true)
+  {
+    work_cv_.wait(lock, [&]() { return stop_ || (generation_ != seen_generation && next_item_ < count_); });
+    if(stop_)
+    {
+      return;
+    }
+
+    // grab items one at a time, per model work is uneven so static partitioning would leave workers idle
+    while(next_item_ < count_)
+    {
+      const std::size_t item = next_item_++;
+      const Task* task = task_;
+      lock.unlock();
+      try
+      {
+        (*task)(worker_id, item);
+      }
+      catch(...)
+      {
+        lock.lock();
+        if(!error_)
+        {
+          error_ = std::current_exception();
+        }
+        lock.unlock();
+      }
+      lock.lock();
+
+      if(--pending_ == 0)
+      {
+        done_cv_.notify_all();
+      }
+    }
+    seen_generation = generation_;
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
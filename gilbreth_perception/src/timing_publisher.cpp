@@ -0,0 +1,85 @@
+#include "gilbreth_perception/timing_publisher.h"
+#include "gilbreth_msgs/OperatingPoint.h"
+#include "gilbreth_msgs/PipelineTiming.h"
+
+static const std::string TOTAL_STAGE = "total";
+
+namespace
+{
+
+gilbreth_msgs::StageTiming toMessage(const std::string& name, double duration,
+                                     const gilbreth::perception::LatencyStatistics::Percentiles& percentiles)
+{
+  gilbreth_msgs::StageTiming stage;
+  stage.name = name;
+  stage.duration = duration;
+  stage.p50 = percentiles.p50;
+  stage.p95 = percentiles.p95;
+  stage.p99 = percentiles.p99;
+  stage.samples = static_cast<uint32_t>(percentiles.samples);
+  return stage;
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+TimingPublisher::TimingPublisher(ros::NodeHandle& nh, const std::string& topic, const std::string& node,
+                                 std::size_t window):
+  publisher_(nh.advertise<gilbreth_msgs::PipelineTiming>(topic, 10)),
+  node_(node),
+  statistics_(window)
+{
+}
+
+void TimingPublisher::publish(const std_msgs::Header& header, const StageTimer& timer)
+{
+  const double total = timer.elapsed();
+  const std::vector<StageTimer::Stage> stages = timer.getStages();
+  for(const StageTimer::Stage& stage : stages)
+  {
+    statistics_.add(stage.name, stage.duration);
+  }
+  statistics_.add(TOTAL_STAGE, total);
+
+  gilbreth_msgs::PipelineTiming msg;
+  msg.header = header;
+  msg.node = node_;
+  msg.result = timer.getResult();
+  msg.points = static_cast<uint32_t>(timer.getPoints());
+  msg.keypoints = static_cast<uint32_t>(timer.getKeypoints());
+  for(const StageTimer::Stage& stage : stages)
+  {
+    msg.stages.push_back(toMessage(stage.name, stage.duration, statistics_.getPercentiles(stage.name)));
+  }
+  msg.total = toMessage(TOTAL_STAGE, total, statistics_.getPercentiles(TOTAL_STAGE));
+  publisher_.publish(msg);
+}
+
+OperatingPointPublisher::OperatingPointPublisher(ros::NodeHandle& nh, const std::string& topic,
+                                                 const std::string& node):
+  publisher_(nh.advertise<gilbreth_msgs::OperatingPoint>(topic, 10)),
+  node_(node)
+{
+}
+
+void OperatingPointPublisher::publish(const std_msgs::Header& header, const LatencyController& controller)
+{
+  const OperatingPoint point = controller.getOperatingPoint();
+  gilbreth_msgs::OperatingPoint msg;
+  msg.header = header;
+  msg.node = node_;
+  msg.target_latency = controller.getParameters().target_latency;
+  msg.predicted_latency = point.predicted_latency;
+  msg.queue_depth = static_cast<uint32_t>(point.queue_depth);
+  msg.leaf_size = point.leaf_size;
+  msg.keypoint_budget = static_cast<uint32_t>(point.keypoint_budget);
+  msg.icp_iterations = static_cast<uint32_t>(point.icp_iterations);
+  publisher_.publish(msg);
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,246 @@
+#include "gilbreth_perception/descriptor_index.h"
+#include "gilbreth_perception/vocabulary_tree.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <pcl/common/transforms.h>
+#include <pcl/console/parse.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/keypoints/uniform_sampling.h>
+#include <random>
+
+/**
+ * Measures how the model matching of the correspondence grouping scales with the catalogue size. Catalogues of the
+ * requested sizes are synthesized from the given models by random anisotropic scaling, and every scene is a rigidly
+ * moved noisy copy of one of the catalogue models. The full SHOT matching queries every model while the vocabulary
+ * shortlists the models by voting with visual words first. Recall is the fraction of the scenes whose model is in
+ * the shortlist, top1 the fraction whose model gets the most correspondences.
+ */
+
+typedef pcl::PointXYZ PointType;
+typedef pcl::Normal NormalType;
+typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+
+struct Parameters
+{
+  float down_sample = 0.01f;
+  float key_point_sampling = 0.01f;
+  float descr_rad = 0.1f;
+  float descr_dis_thrd = 0.2f;
+  int k_nearest_neighbors = 10;
+  int scenes = 10;
+  float noise = 0.001f;
+  float min_scale = 0.7f;
+  float max_scale = 1.3f;
+  gilbreth::perception::VocabularyParameters vocabulary;
+  int shortlist = 10;
+};
+
+static void printUsage(const char* program)
+{
+  std::cout << "Usage: " << program << " model.pcd [model.pcd ...] [options]\n"
+            << "  -models <int>     catalogue size, may be given several times (default 5 50 500)\n"
+            << "  -scenes <int>     scenes matched per catalogue (10)\n"
+            << "  -noise <m>        standard deviation of the scene noise (0.001)\n"
+            << "  -scale <min,max>  range of the per axis scaling of the synthesized models (0.7,1.3)\n"
+            << "  -branching <int>  vocabulary branching (10)\n"
+            << "  -depth <int>      vocabulary depth (4)\n"
+            << "  -shortlist <int>  models kept by the vocabulary (10)\n"
+            << "  -down_sample <m>  voxel size (0.01)\n"
+            << "  -key_point_sampling <m> (0.01)\n"
+            << "  -descr_rad <m>    SHOT radius (0.1)\n"
+            << "  -descr_dis_thrd <d> squared descriptor distance threshold (0.2)\n"
+            << "  -k <int>          normal estimation neighbors (10)\n";
+}
+
+static double elapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static DescriptorCloud::Ptr computeDescriptors(const pcl::PointCloud<PointType>::ConstPtr& cloud,
+                                               const Parameters& params)
+{
+  pcl::PointCloud<NormalType>::Ptr normals(new pcl::PointCloud<NormalType>());
+  pcl::NormalEstimationOMP<PointType, NormalType> norm_est;
+  norm_est.setKSearch(params.k_nearest_neighbors);
+  norm_est.setInputCloud(cloud);
+  norm_est.compute(*normals);
+
+  pcl::PointCloud<PointType>::Ptr keypoints(new pcl::PointCloud<PointType>());
+  pcl::UniformSampling<PointType> uniform_sampling;
+  uniform_sampling.setInputCloud(cloud);
+  uniform_sampling.setRadiusSearch(params.key_point_sampling);
+  uniform_sampling.filter(*keypoints);
+
+  DescriptorCloud::Ptr descriptors(new DescriptorCloud());
+  pcl::SHOTEstimationOMP<PointType, NormalType, pcl::SHOT352> descr_est;
+  descr_est.setRadiusSearch(params.descr_rad);
+  descr_est.setInputCloud(keypoints);
+  descr_est.setInputNormals(normals);
+  descr_est.setSearchSurface(cloud);
+  descr_est.compute(*descriptors);
+  return descriptors;
+}
+
+/**
+ * Model with the most correspondences, or -1
+ */
+static int mostMatched(const std::vector<pcl::CorrespondencesPtr>& corrs)
+{
+  int best = -1;
+  std::size_t best_size = 0;
+  for(std::size_t m = 0; m < corrs.size(); m++)
+  {
+    if(corrs[m]->size() > best_size)
+    {
+      best_size = corrs[m]->size();
+      best = static_cast<int>(m);
+    }
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<int> pcd_args = pcl::console::parse_file_extension_argument(argc, argv, ".pcd");
+  if(pcd_args.empty())
+  {
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  Parameters params;
+  std::vector<int> sizes;
+  pcl::console::parse_multiple_arguments(argc, argv, "-models", sizes);
+  pcl::console::parse_argument(argc, argv, "-scenes", params.scenes);
+  pcl::console::parse_argument(argc, argv, "-noise", params.noise);
+  pcl::console::parse_2x_arguments(argc, argv, "-scale", params.min_scale, params.max_scale);
+  pcl::console::parse_argument(argc, argv, "-branching", params.vocabulary.branching);
+  pcl::console::parse_argument(argc, argv, "-depth", params.vocabulary.depth);
+  pcl::console::parse_argument(argc, argv, "-shortlist", params.shortlist);
+  pcl::console::parse_argument(argc, argv, "-down_sample", params.down_sample);
+  pcl::console::parse_argument(argc, argv, "-key_point_sampling", params.key_point_sampling);
+  pcl::console::parse_argument(argc, argv, "-descr_rad", params.descr_rad);
+  pcl::console::parse_argument(argc, argv, "-descr_dis_thrd", params.descr_dis_thrd);
+  pcl::console::parse_argument(argc, argv, "-k", params.k_nearest_neighbors);
+  if(sizes.empty())
+  {
+    sizes = {5, 50, 500};
+  }
+
+  std::vector<pcl::PointCloud<PointType>::Ptr> inputs;
+  for(int arg : pcd_args)
+  {
+    pcl::PointCloud<PointType>::Ptr raw(new pcl::PointCloud<PointType>());
+    if(pcl::io::loadPCDFile(argv[arg], *raw) < 0)
+    {
+      std::cerr << "Failed to load " << argv[arg] << std::endl;
+      return -1;
+    }
+
+    pcl::PointCloud<PointType>::Ptr cloud(new pcl::PointCloud<PointType>());
+    pcl::VoxelGrid<PointType> sor;
+    sor.setInputCloud(raw);
+    sor.setLeafSize(params.down_sample, params.down_sample, params.down_sample);
+    sor.filter(*cloud);
+    inputs.push_back(cloud);
+  }
+
+  std::cout << std::left << std::setw(8) << "models" << std::setw(13) << "descriptors" << std::setw(8) << "words"
+            << std::setw(12) << "full build" << std::setw(12) << "voc build" << std::setw(12) << "full ms"
+            << std::setw(12) << "voc ms" << std::setw(8) << "recall" << std::setw(11) << "full top1"
+            << "voc top1\n";
+
+  for(int size : sizes)
+  {
+    // the given models come first, the others are scaled copies so that every catalogue holds distinct shapes
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> scale(params.min_scale, params.max_scale);
+    std::vector<pcl::PointCloud<PointType>::Ptr> models;
+    std::vector<DescriptorCloud::Ptr> model_descriptors;
+    std::size_t descriptor_count = 0;
+    for(int i = 0; i < size; i++)
+    {
+      pcl::PointCloud<PointType>::Ptr model(new pcl::PointCloud<PointType>(*inputs[i % inputs.size()]));
+      if(i >= static_cast<int>(inputs.size()))
+      {
+        Eigen::Affine3f stretch = Eigen::Affine3f::Identity();
+        stretch.scale(Eigen::Vector3f(scale(generator), scale(generator), scale(generator)));
+        pcl::transformPointCloud(*model, *model, stretch);
+      }
+      models.push_back(model);
+      model_descriptors.push_back(computeDescriptors(model, params));
+      descriptor_count += model_descriptors.back()->size();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    gilbreth::perception::DescriptorIndex full_index;
+    full_index.build(model_descriptors);
+    const double full_build = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    gilbreth::perception::VocabularyTree vocabulary(params.vocabulary);
+    if(!vocabulary.build(model_descriptors))
+    {
+      std::cerr << "No model descriptors to learn a vocabulary from" << std::endl;
+      return -1;
+    }
+    const double vocabulary_build = elapsedMs(start);
+
+    std::vector<int> all(size);
+    for(int i = 0; i < size; i++)
+    {
+      all[i] = i;
+    }
+
+    double full_time = 0.0;
+    double vocabulary_time = 0.0;
+    int shortlisted = 0;
+    int full_top1 = 0;
+    int vocabulary_top1 = 0;
+    std::normal_distribution<float> noise(0.0f, params.noise);
+    std::uniform_real_distribution<float> angle(-static_cast<float>(M_PI), static_cast<float>(M_PI));
+    for(int s = 0; s < params.scenes; s++)
+    {
+      const int truth = static_cast<int>((static_cast<long>(s) * size) / params.scenes);
+      Eigen::Affine3f pose = Eigen::Translation3f(0.5f, 0.0f, 0.0f) *
+                             Eigen::AngleAxisf(angle(generator), Eigen::Vector3f::UnitZ()) *
+                             Eigen::AngleAxisf(angle(generator), Eigen::Vector3f::UnitX());
+      pcl::PointCloud<PointType>::Ptr scene(new pcl::PointCloud<PointType>());
+      pcl::transformPointCloud(*models[truth], *scene, pose);
+      for(PointType& p : scene->points)
+      {
+        p.x += noise(generator);
+        p.y += noise(generator);
+        p.z += noise(generator);
+      }
+      DescriptorCloud::Ptr scene_descriptors = computeDescriptors(scene, params);
+
+      std::vector<pcl::CorrespondencesPtr> corrs;
+      start = std::chrono::steady_clock::now();
+      full_index.match(*scene_descriptors, params.descr_dis_thrd, all, corrs);
+      full_time += elapsedMs(start);
+      full_top1 += mostMatched(corrs) == truth;
+
+      start = std::chrono::steady_clock::now();
+      const std::vector<int> shortlist = vocabulary.shortlist(*scene_descriptors, params.shortlist, all);
+      vocabulary.match(*scene_descriptors, params.descr_dis_thrd, shortlist, corrs);
+      vocabulary_time += elapsedMs(start);
+      shortlisted += std::binary_search(shortlist.begin(), shortlist.end(), truth);
+      vocabulary_top1 += mostMatched(corrs) == truth;
+    }
+
+    const double scenes = std::max(params.scenes, 1);
+    std::cout << std::setw(8) << size << std::setw(13) << descriptor_count << std::setw(8)
+              << vocabulary.getWordCount() << std::setw(12) << full_build << std::setw(12) << vocabulary_build
+              << std::setw(12) << full_time / scenes << std::setw(12) << vocabulary_time / scenes
+              << std::setw(8) << shortlisted / scenes << std::setw(11) << full_top1 / scenes
+              << vocabulary_top1 / scenes << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,432 @@
+#include "gilbreth_perception/vocabulary_tree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+static const unsigned int KMEANS_SEED = 5489u;
+
+namespace
+{
+
+/**
+ * @brief Squared euclidean distance, stops accumulating once it exceeds the bound.
+ */
+float sqrDistance(const float* a, const float* b, int size, float bound = std::numeric_limits<float>::max())
+{
+  float d = 0.0f;
+  for(int i = 0; i < size; i++)
+  {
+    const float diff = a[i] - b[i];
+    d += diff * diff;
+    if(d > bound)
+    {
+      break;
+    }
+  }
+  return d;
+}
+
+bool isFinite(const pcl::SHOT352& descriptor)
+{
+  return pcl_isfinite(descriptor.descriptor[0]);
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+VocabularyTree::VocabularyTree(const VocabularyParameters& params):
+  params_(params)
+{
+}
+
+bool VocabularyTree::build(const std::vector<DescriptorCloud::Ptr>& model_descriptors)
+{
+  nodes_.clear();
+  centers_.clear();
+  idf_.clear();
+  inverted_file_.clear();
+  word_entries_.clear();
+  models_ = model_descriptors;
+
+  std::vector<const float*> training;
+  for(const DescriptorCloud::Ptr& descriptors : model_descriptors)
+  {
+    for(const pcl::SHOT352& descriptor : descriptors->points)
+    {
+      if(isFinite(descriptor))
+      {
+        training.push_back(descriptor.descriptor);
+      }
+    }
+  }
+
+  if(training.empty())
+  {
+    return false;
+  }
+
+  std::mt19937 generator(KMEANS_SEED);
+  if(params_.max_training_descriptors > 0 && training.size() > params_.max_training_descriptors)
+  {
+    std::shuffle(training.begin(), training.end(), generator);
+    training.resize(params_.max_training_descriptors);
+  }
+
+  // root, its center is never compared against
+  Node root = {-1, 0, -1};
+  nodes_.push_back(root);
+  centers_.assign(DESCRIPTOR_SIZE, 0.0f);
+  split(0, training, 0);
+
+  // inverted file, every model descriptor is filed under its word
+  inverted_file_.resize(word_entries_.size());
+  idf_.assign(word_entries_.size(), 0.0f);
+  std::vector<std::vector<float> > term_frequencies(models_.size());
+  std::vector<int> document_frequency(word_entries_.size(), 0);
+  for(std::size_t m = 0; m < models_.size(); m++)
+  {
+    std::vector<float>& tf = term_frequencies[m];
+    tf.assign(word_entries_.size(), 0.0f);
+    const DescriptorCloud& descriptors = *models_[m];
+    for(std::size_t j = 0; j < descriptors.size(); j++)
+    {
+      const int word = quantize(descriptors[j]);
+      if(word < 0)
+      {
+        continue;
+      }
+
+      Entry entry = {static_cast<int>(m), static_cast<int>(j)};
+      word_entries_[word].push_back(entry);
+      if(tf[word] == 0.0f)
+      {
+        document_frequency[word]++;
+      }
+      tf[word] += 1.0f;
+    }
+  }
+
+  for(std::size_t w = 0; w < idf_.size(); w++)
+  {
+    if(document_frequency[w] > 0)
+    {
+      idf_[w] = std::log(static_cast<float>(models_.size()) / document_frequency[w]);
+    }
+  }
+
+  // L1 normalized tf-idf histograms so that models with more descriptors are not favored
+  for(std::size_t m = 0; m < models_.size(); m++)
+  {
+    std::vector<float>& tf = term_frequencies[m];
+    float norm = 0.0f;
+    for(std::size_t w = 0; w < tf.size(); w++)
+    {
+      tf[w] *= idf_[w];
+      norm += tf[w];
+    }
+
+    if(norm <= 0.0f)
+    {
+      continue;
+    }
+
+    for(std::size_t w = 0; w < tf.size(); w++)
+    {
+      if(tf[w] > 0.0f)
+      {
+        Posting posting = {static_cast<int>(m), tf[w] / norm};
+        inverted_file_[w].push_back(posting);
+      }
+    }
+  }
+  return true;
+}
+
+void VocabularyTree::split(int node, std::vector<const float*>& descriptors, int level)
+{
+  const std::size_t k = static_cast<std::size_t>(std::max(params_.branching, 2));
+  if(level >= params_.depth || descriptors.size() <= k)
+  {
+    nodes_[node].word = static_cast<int>(word_entries_.size());
+    word_entries_.push_back(std::vector<Entry>());
+    return;
+  }
+
+  // k-means++ seeding
+  std::mt19937 generator(KMEANS_SEED + static_cast<unsigned int>(node));
+  std::vector<float> centers;
+  centers.reserve(k * DESCRIPTOR_SIZE);
+  std::uniform_int_distribution<std::size_t> pick(0, descriptors.size() - 1);
+  const float* first = descriptors[pick(generator)];
+  centers.insert(centers.end(), first, first + DESCRIPTOR_SIZE);
+  std::vector<float> closest(descriptors.size(), std::numeric_limits<float>::max());
+  for(std::size_t c = 1; c < k; c++)
+  {
+    const float* last = &centers[(c - 1) * DESCRIPTOR_SIZE];
+    for(std::size_t i = 0; i < descriptors.size(); i++)
+    {
+      closest[i] = std::min(closest[i], sqrDistance(descriptors[i], last, DESCRIPTOR_SIZE, closest[i]));
+    }
+
+    // duplicated descriptors can leave nothing to weight, the next center is then drawn uniformly
+    const float* next = descriptors[pick(generator)];
+    if(std::accumulate(closest.begin(), closest.end(), 0.0) > 0.0)
+    {
+      std::discrete_distribution<std::size_t> weighted(closest.begin(), closest.end());
+      next = descriptors[weighted(generator)];
+    }
+    centers.insert(centers.end(), next, next + DESCRIPTOR_SIZE);
+  }
+
+  // Lloyd iterations
+  std::vector<std::size_t> assignment(descriptors.size(), 0);
+  std::vector<std::size_t> counts(k);
+  for(int it = 0; it < params_.kmeans_iterations; it++)
+  {
+    bool changed = false;
+    for(std::size_t i = 0; i < descriptors.size(); i++)
+    {
+      float best = std::numeric_limits<float>::max();
+      std::size_t best_c = 0;
+      for(std::size_t c = 0; c < k; c++)
+      {
+        const float d = sqrDistance(descriptors[i], &centers[c * DESCRIPTOR_SIZE], DESCRIPTOR_SIZE, best);
+        if(d < best)
+        {
+          best = d;
+          best_c = c;
+        }
+      }
+      changed = changed || assignment[i] != best_c || it == 0;
+      assignment[i] = best_c;
+    }
+
+    if(!changed)
+    {
+      break;
+    }
+
+    // empty clusters keep their previous center
+    std::fill(counts.begin(), counts.end(), 0);
+    std::vector<float> sums(k * DESCRIPTOR_SIZE, 0.0f);
+    for(std::size_t i = 0; i < descriptors.size(); i++)
+    {
+      float* sum = &sums[assignment[i] * DESCRIPTOR_SIZE];
+      for(int d = 0; d < DESCRIPTOR_SIZE; d++)
+      {
+        sum[d] += descriptors[i][d];
+      }
+      counts[assignment[i]]++;
+    }
+
+    for(std::size_t c = 0; c < k; c++)
+    {
+      if(counts[c] > 0)
+      {
+        for(int d = 0; d < DESCRIPTOR_SIZE; d++)
+        {
+          centers[c * DESCRIPTOR_SIZE + d] = sums[c * DESCRIPTOR_SIZE + d] / counts[c];
+        }
+      }
+    }
+  }
+
+  // children are only created for the clusters that received descriptors
+  std::vector<std::vector<const float*> > members(k);
+  for(std::size_t i = 0; i < descriptors.size(); i++)
+  {
+    members[assignment[i]].push_back(descriptors[i]);
+  }
+  descriptors.clear();
+  descriptors.shrink_to_fit();
+
+  const int first_child = static_cast<int>(nodes_.size());
+  std::vector<std::size_t> used;
+  for(std::size_t c = 0; c < k; c++)
+  {
+    if(!members[c].empty())
+    {
+      Node child = {-1, 0, -1};
+      nodes_.push_back(child);
+      centers_.insert(centers_.end(), centers.begin() + c * DESCRIPTOR_SIZE,
+                      centers.begin() + (c + 1) * DESCRIPTOR_SIZE);
+      used.push_back(c);
+    }
+  }
+  nodes_[node].first_child = first_child;
+  nodes_[node].child_count = static_cast<int>(used.size());
+
+  for(std::size_t i = 0; i < used.size(); i++)
+  {
+    split(first_child + static_cast<int>(i), members[used[i]], level + 1);
+  }
+}
+
+int VocabularyTree::quantize(const pcl::SHOT352& descriptor) const
+{
+  if(nodes_.empty() || !isFinite(descriptor))
+  {
+    return -1;
+  }
+
+  int node = 0;
+  while(nodes_[node].first_child >= 0)
+  {
+    const Node& parent = nodes_[node];
+    float best = std::numeric_limits<float>::max();
+    int best_child = parent.first_child;
+    for(int c = parent.first_child; c < parent.first_child + parent.child_count; c++)
+    {
+      const float d = sqrDistance(descriptor.descriptor, center(c), DESCRIPTOR_SIZE, best);
+      if(d < best)
+      {
+        best = d;
+        best_child = c;
+      }
+    }
+    node = best_child;
+  }
+  return nodes_[node].word;
+}
+
+std::vector<int> VocabularyTree::shortlist(const DescriptorCloud& scene_descriptors, std::size_t top_k,
+                                           const std::vector<int>& candidates) const
+{
+  std::vector<bool> allowed(models_.size(), false);
+  for(int id : candidates)
+  {
+    if(id >= 0 && static_cast<std::size_t>(id) < models_.size())
+    {
+      allowed[id] = true;
+    }
+  }
+
+  // scene histogram, kept sparse since a cluster only touches a few of the words
+  std::vector<std::pair<int, float> > query;
+  query.reserve(scene_descriptors.size());
+  for(const pcl::SHOT352& descriptor : scene_descriptors.points)
+  {
+    const int word = quantize(descriptor);
+    if(word >= 0 && idf_[word] > 0.0f)
+    {
+      query.push_back(std::make_pair(word, idf_[word]));
+    }
+  }
+  std::sort(query.begin(), query.end());
+
+  std::vector<std::pair<int, float> > histogram;
+  float norm = 0.0f;
+  for(const std::pair<int, float>& q : query)
+  {
+    if(!histogram.empty() && histogram.back().first == q.first)
+    {
+      histogram.back().second += q.second;
+    }
+    else
+    {
+      histogram.push_back(q);
+    }
+    norm += q.second;
+  }
+
+  // histogram intersection accumulated over the posting lists of the scene words only
+  std::vector<float> scores(models_.size(), 0.0f);
+  std::vector<int> voted;
+  for(const std::pair<int, float>& word : histogram)
+  {
+    const float weight = word.second / norm;
+    for(const Posting& posting : inverted_file_[word.first])
+    {
+      if(!allowed[posting.model])
+      {
+        continue;
+      }
+
+      if(scores[posting.model] == 0.0f)
+      {
+        voted.push_back(posting.model);
+      }
+      scores[posting.model] += std::min(weight, posting.weight);
+    }
+  }
+
+  // ties keep the lower id so the selection is deterministic
+  std::sort(voted.begin(), voted.end());
+  if(top_k > 0 && top_k < voted.size())
+  {
+    std::stable_sort(voted.begin(), voted.end(), [&scores](int a, int b) { return scores[a] > scores[b]; });
+    voted.resize(top_k);
+    std::sort(voted.begin(), voted.end());
+  }
+  return voted;
+}
+
+void VocabularyTree::match(const DescriptorCloud& scene_descriptors, float max_sqr_distance,
+                           const std::vector<int>& models, std::vector<pcl::CorrespondencesPtr>& model_scene_corrs) const
+{
+  model_scene_corrs.resize(models_.size());
+  for(pcl::CorrespondencesPtr& corrs : model_scene_corrs)
+  {
+    corrs.reset(new pcl::Correspondences());
+  }
+
+  std::vector<bool> allowed(models_.size(), false);
+  for(int id : models)
+  {
+    if(id >= 0 && static_cast<std::size_t>(id) < models_.size())
+    {
+      allowed[id] = true;
+    }
+  }
+
+  // nearest model descriptor of each model within the word, the best entries are reset through the touched list
+  std::vector<pcl::Correspondence> best(models_.size());
+  std::vector<int> touched;
+  for(std::size_t i = 0; i < scene_descriptors.size(); ++i)
+  {
+    const int word = quantize(scene_descriptors[i]);
+    if(word < 0)
+    {
+      continue;
+    }
+
+    touched.clear();
+    for(const Entry& entry : word_entries_[word])
+    {
+      if(!allowed[entry.model])
+      {
+        continue;
+      }
+
+      const bool first = best[entry.model].index_match < 0;
+      const float bound = first ? max_sqr_distance : best[entry.model].distance;
+      const float d = sqrDistance(scene_descriptors[i].descriptor, (*models_[entry.model])[entry.index].descriptor,
+                                  DESCRIPTOR_SIZE, bound);
+      if(d > bound || (!first && d == bound))
+      {
+        continue;
+      }
+
+      if(first)
+      {
+        touched.push_back(entry.model);
+      }
+      best[entry.model] = pcl::Correspondence(entry.index, static_cast<int>(i), d);
+    }
+
+    for(int model : touched)
+    {
+      model_scene_corrs[model]->push_back(best[model]);
+      best[model] = pcl::Correspondence();
+    }
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
@@ -0,0 +1,51 @@
+#include "gilbreth_perception/voxel_pyramid.h"
+#include <pcl/filters/voxel_grid.h>
+
+static const std::size_t MIN_LEVEL_POINTS = 30;
+
+namespace gilbreth
+{
+namespace perception
+{
+
+CloudPyramid buildPyramid(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr& cloud, float leaf_size, int levels)
+{
+  CloudPyramid pyramid(1, cloud);
+  if(leaf_size <= 0.0f)
+  {
+    return pyramid;
+  }
+
+  pcl::VoxelGrid<pcl::PointXYZ> sor;
+  float leaf = leaf_size;
+  for(int level = 1; level < levels; level++)
+  {
+    // each level is voxelized from the previous one, which is already close to its size
+    leaf *= 2.0f;
+    pcl::PointCloud<pcl::PointXYZ>::Ptr coarse(new pcl::PointCloud<pcl::PointXYZ>());
+    sor.setInputCloud(pyramid.back());
+    sor.setLeafSize(leaf, leaf, leaf);
+    sor.filter(*coarse);
+    if(coarse->size() < MIN_LEVEL_POINTS)
+    {
+      break;
+    }
+    pyramid.push_back(coarse);
+  }
+  return pyramid;
+}
+
+int finestLevel(float leaf_size, float cloud_leaf_size, int levels)
+{
+  int level = 0;
+  float leaf = leaf_size;
+  while(level + 1 < levels && leaf > 0.0f && leaf < cloud_leaf_size)
+  {
+    leaf *= 2.0f;
+    level++;
+  }
+  return level;
+}
+
+} // namespace perception
+} // namespace gilbreth
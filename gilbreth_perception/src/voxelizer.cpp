@@ -0,0 +1,101 @@
+#include "gilbreth_perception/voxelizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+/**
+ * Grid coordinate of a point along one axis. Computed signed since the index can be slightly negative, it is
+ * then clamped to the grid.
+ */
+unsigned int gridIndex(float value, float translate, unsigned int grid_size, float scale)
+{
+  const int i = std::round(static_cast<float>(grid_size) * ((value - translate) / scale) - 0.5);
+  return static_cast<unsigned int>(std::min(std::max(i, 0), static_cast<int>(grid_size) - 1));
+}
+
+} // namespace
+
+namespace gilbreth
+{
+namespace perception
+{
+
+void voxelize(const pcl::PointCloud<pcl::PointXYZ>& cloud, unsigned int grid_size, OccupancyGrid& grid)
+{
+  voxelize(XyzView::fromCloud(cloud), grid_size, grid);
+}
+
+void voxelize(const XyzView& cloud, unsigned int grid_size, OccupancyGrid& grid)
+{
+  Eigen::Vector3f min_point = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_point = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+  for(std::size_t r = 0; r < cloud.getHeight(); r++)
+  {
+    const std::uint8_t* row = cloud.row(r);
+    for(std::size_t c = 0; c < cloud.getWidth(); c++)
+    {
+      const Eigen::Vector3f point = cloud.point(row, c);
+      if(cloud.isDense() || point.allFinite())
+      {
+        min_point = min_point.cwiseMin(point);
+        max_point = max_point.cwiseMax(point);
+      }
+    }
+  }
+
+  // Calculate the scale factor so the longest side of the volume
+  // is split into the desired number of voxels
+  const float x_range = max_point.x() - min_point.x();
+  const float y_range = max_point.y() - min_point.y();
+  const float z_range = max_point.z() - min_point.z();
+  const float max_cloud_extent = std::max(std::max(x_range, y_range), z_range);
+  const float voxel_size = max_cloud_extent / (static_cast<float>(grid_size) - 1.0);
+  const float scale = (static_cast<float>(grid_size) * max_cloud_extent) / (static_cast<float>(grid_size) - 1.0);
+
+  // Calculate the PointCloud's translation from the origin.
+  // We need to subtract half the voxel size, because points
+  // are located in the center of the voxel grid.
+  float tx = min_point.x() - voxel_size / 2.0;
+  float ty = min_point.y() - voxel_size / 2.0;
+  float tz = min_point.z() - voxel_size / 2.0;
+  // Hack, change -0.0 to 0.0
+  const float epsilon = 0.0000001;
+  if((tx > -epsilon) && (tx < 0.0))
+  {
+    tx = -1.0 * tx;
+  }
+  if((ty > -epsilon) && (ty < 0.0))
+  {
+    ty = -1.0 * ty;
+  }
+  if((tz > -epsilon) && (tz < 0.0))
+  {
+    tz = -1.0 * tz;
+  }
+
+  grid.size = grid_size;
+  grid.voxel_size = voxel_size;
+  grid.occupancy.assign(grid_size * grid_size * grid_size, 0);
+  for(std::size_t r = 0; r < cloud.getHeight(); r++)
+  {
+    const std::uint8_t* row = cloud.row(r);
+    for(std::size_t c = 0; c < cloud.getWidth(); c++)
+    {
+      const Eigen::Vector3f point = cloud.point(row, c);
+      if(!cloud.isDense() && !point.allFinite())
+      {
+        continue;
+      }
+      const unsigned int x = gridIndex(point.x(), tx, grid_size, scale);
+      const unsigned int y = gridIndex(point.y(), ty, grid_size, scale);
+      const unsigned int z = gridIndex(point.z(), tz, grid_size, scale);
+      grid.occupancy[x * (grid_size * grid_size) + z * grid_size + y] = 1;
+    }
+  }
+}
+
+} // namespace perception
+} // namespace gilbreth
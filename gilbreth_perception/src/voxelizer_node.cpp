@@ -1,136 +1,39 @@
 #include "gilbreth_msgs/ObjectVoxel.h"
+#include "gilbreth_perception/point_cloud2_view.h"
+#include "gilbreth_perception/ros_log.h"
+#include "gilbreth_perception/voxelizer.h"
 #include "std_msgs/Int32MultiArray.h"
 #include "std_msgs/MultiArrayDimension.h"
-#include <XmlRpcException.h>
-#include <array>
-#include <boost/dynamic_bitset.hpp>
-#include <cstdlib>
-#include <cstring>
-#include <fstream>
-#include <iomanip> // setprecision
-#include <iostream>
-#include <pcl/common/common.h>
-#include <pcl/console/parse.h>
-#include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
-#include <string>
-#include <vector>
 
 // Algorithm params
 static const unsigned int VOXEL_GRID_SIZE = 32;
-static const unsigned int VOXEL_SQUARE = std::pow(VOXEL_GRID_SIZE,2);
-static const unsigned int VOXEL_CUBE = std::pow(VOXEL_GRID_SIZE,3);
+static const unsigned int VOXEL_SQUARE = VOXEL_GRID_SIZE * VOXEL_GRID_SIZE;
+static const unsigned int VOXEL_CUBE = VOXEL_SQUARE * VOXEL_GRID_SIZE;
 
 
 ros::Publisher pub;
 
-//pcd to voxel functions
-struct Voxel {
-  unsigned int x;
-  unsigned int y;
-  unsigned int z;
-  Voxel() : x(0), y(0), z(0){};
-  Voxel(const unsigned int _x, const unsigned int _y, const unsigned int _z) : x(_x), y(_y), z(_z){};
-};
-
-template <typename PointT>
-const bool loadPointCloud(const std::string &file_path,
-                          typename pcl::PointCloud<PointT> &cloud_out) {
-  if (pcl::io::loadPCDFile<pcl::PointXYZ>(file_path.c_str(), cloud_out) == -1) {
-    PCL_ERROR("Failed to load PCD file \n");
-    return false;
-  }
-
-  return true;
-}
-
-// Get the linear index into a 1D array of voxels,
-// for a voxel at location (ix, iy, iz).
-const unsigned int getLinearIndex(const Voxel &voxel, const int grid_size) {
-  return voxel.x * (grid_size * grid_size) + voxel.z * grid_size + voxel.y;
-}
-
-const Voxel getGridIndex(const pcl::PointXYZ &point, const pcl::PointXYZ &translate, const uint VOXEL_GRID_SIZE, const float scale) {
-  // Needs to be signed to prevent overflow, because index can
-  // be slightly negative which then gets rounded to zero.
-  const int i = std::round(static_cast<float>(VOXEL_GRID_SIZE) * ((point.x - translate.x) / scale) - 0.5);
-  const int j = std::round(static_cast<float>(VOXEL_GRID_SIZE) * ((point.y - translate.y) / scale) - 0.5);
-  const int k = std::round(static_cast<float>(VOXEL_GRID_SIZE) * ((point.z - translate.z) / scale) - 0.5);
-  return Voxel(i, j, k);
-}
-
-// Format a float number to ensure it always has at least one decimal place
-// 0 --> 0.0
-// 1.1 --> 1.1
-// 1.10 --> 1.1
-const std::string formatFloat(const float value) {
-  std::stringstream ss;
-  ss << std::setprecision(6) << std::fixed << value;
-  std::string str;
-  ss.str().swap(str);
-  size_t last_zero_idx = str.find_last_not_of("0") + 1;
-  if (last_zero_idx == str.length()) {
-    // No trailing zeros
-    return str;
+void cloudCb(const sensor_msgs::PointCloud2ConstPtr &cloud_msg) {
+  // the cluster is voxelized in place and forwarded as received
+  gilbreth::perception::XyzView scene;
+  if (!gilbreth::perception::makeXyzView(*cloud_msg, scene)) {
+    return;
   }
-  if (str[last_zero_idx - 1] == '.') {
-    // Last zero is after decimal point
-    last_zero_idx += 1;
+  if (scene.empty()) {
+    ROS_WARN("Voxelizer received an empty cloud");
+    return;
   }
-  str.resize(last_zero_idx);
-  return str;
-}
 
-void cloudCb(const sensor_msgs::PointCloud2ConstPtr &cloud_msg) {
-  pcl::PointCloud<pcl::PointXYZ>::Ptr scene(new pcl::PointCloud<pcl::PointXYZ>());
-  pcl::fromROSMsg(*cloud_msg, *scene);
   //create and publish voxel
   ros::Time start_time = ros::Time::now();
-  pcl::PointXYZ min_point;
-  pcl::PointXYZ max_point;
-  pcl::getMinMax3D(*scene, min_point, max_point);
-  // Calculate the scale factor so the longest side of the volume
-  // is split into the desired number of voxels
-  const float x_range = max_point.x - min_point.x;
-  const float y_range = max_point.y - min_point.y;
-  const float z_range = max_point.z - min_point.z;
-
-  const float max_cloud_extent = std::max(std::max(x_range, y_range), z_range);
-  const float voxel_size = max_cloud_extent / (static_cast<float>(VOXEL_GRID_SIZE) - 1.0);
-  ROS_INFO("voxel size is %f", voxel_size);
+  gilbreth::perception::OccupancyGrid grid;
+  gilbreth::perception::voxelize(scene, VOXEL_GRID_SIZE, grid);
+  ROS_INFO("voxel size is %f", grid.voxel_size);
 
-  const float scale = (static_cast<float>(VOXEL_GRID_SIZE) * max_cloud_extent) / (static_cast<float>(VOXEL_GRID_SIZE) - 1.0);
-
-  // Calculate the PointCloud's translation from the origin.
-  // We need to subtract half the voxel size, because points
-  // are located in the center of the voxel grid.
-  float tx = min_point.x - voxel_size / 2.0;
-  float ty = min_point.y - voxel_size / 2.0;
-  float tz = min_point.z - voxel_size / 2.0;
-  // Hack, change -0.0 to 0.0
-  const float epsilon = 0.0000001;
-  if ((tx > -epsilon) && (tx < 0.0)) {
-    tx = -1.0 * tx;
-  }
-  if ((ty > -epsilon) && (ty < 0.0)) {
-    ty = -1.0 * ty;
-  }
-  if ((tz > -epsilon) && (tz < 0.0)) {
-    tz = -1.0 * tz;
-  }
-  const pcl::PointXYZ translate(tx, ty, tz);
-
-  // Voxelize the PointCloud into a linear array
-  boost::dynamic_bitset<> voxels_bitset(VOXEL_CUBE);
-  for (pcl::PointCloud<pcl::PointXYZ>::iterator it = scene->begin(); it != scene->end(); ++it) {
-    const Voxel voxel = getGridIndex(*it, translate, VOXEL_GRID_SIZE, scale);
-    const unsigned int idx = getLinearIndex(voxel, VOXEL_GRID_SIZE);
-    voxels_bitset[idx] = 1;
-  }
   gilbreth_msgs::ObjectVoxel voxel_data;
   std_msgs::Int32MultiArray dat;
   // fill voxel into message:
@@ -147,17 +50,12 @@ void cloudCb(const sensor_msgs::PointCloud2ConstPtr &cloud_msg) {
   dat.layout.dim[1].stride = VOXEL_SQUARE;
   dat.layout.dim[1].stride = VOXEL_GRID_SIZE;
   dat.layout.data_offset = 0;
-  std::vector<int> vec(VOXEL_CUBE, 0);
-  for (int i = 0; i < VOXEL_CUBE; i++)
-    vec[i] = voxels_bitset[i];
-  dat.data = vec;
+  dat.data.swap(grid.occupancy);
   voxel_data.voxel = dat;
   voxel_data.header.stamp = ros::Time::now();
   voxel_data.detection_time = cloud_msg->header.stamp;
   //fill pcd into msg
-  sensor_msgs::PointCloud2 pcd_output;
-  pcl::toROSMsg(*scene, pcd_output);
-  voxel_data.pcd = pcd_output;
+  voxel_data.pcd = *cloud_msg;
   //publish
   pub.publish(voxel_data);
   double elapsed_time = (ros::Time::now() - start_time).toSec();
@@ -169,9 +67,10 @@ int main(int argc, char **argv) {
   // Initialize ROS
   ros::init(argc, argv, "voxelizer_node");
   ros::NodeHandle nh;
+  gilbreth::perception::forwardLogToRos();
 
   // Create a ROS subscriber for the input point cloud
-  ros::Subscriber sub_1 = nh.subscribe<sensor_msgs::PointCloud2>("segmentation_result", 1, cloudCb);
+  ros::Subscriber sub_1 = nh.subscribe<sensor_msgs::PointCloud2>("segmentation_result", 100, cloudCb);
   // ROS publisher
   pub = nh.advertise<gilbreth_msgs::ObjectVoxel>("voxel_data", 10);
   ROS_INFO("Voxelizer Node subscribed to %s", pub.getTopic().c_str());
@@ -0,0 +1,120 @@
+#include "gilbreth_perception/binary_descriptor_index.h"
+#include "gilbreth_perception/compressed_descriptor_index.h"
+#include "gilbreth_perception/descriptor_index.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::SHOT352> DescriptorCloud;
+
+const int DESCRIPTORS = 40;
+
+/**
+ * Deterministic descriptors in [0, 1], the offset moves every bin of every descriptor by the same amount
+ */
+DescriptorCloud::Ptr makeDescriptors(float offset)
+{
+  DescriptorCloud::Ptr descriptors(new DescriptorCloud);
+  for(int i = 0; i < DESCRIPTORS; i++)
+  {
+    pcl::SHOT352 descriptor;
+    for(int b = 0; b < 352; b++)
+    {
+      descriptor.descriptor[b] = 0.5f + 0.4f * std::sin(0.37f * (i + 1) * (b + 1)) + offset;
+    }
+    for(float& value : descriptor.rf)
+    {
+      value = 0.0f;
+    }
+    descriptors->push_back(descriptor);
+  }
+  return descriptors;
+}
+
+/**
+ * Model 0 holds the scene descriptors themselves and is the nearest to every one of them, models 1 and 2 are
+ * slightly offset copies
+ */
+class DescriptorIndexFixture : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    scene_ = makeDescriptors(0.0f);
+    models_.push_back(makeDescriptors(0.0f));
+    models_.push_back(makeDescriptors(0.01f));
+    models_.push_back(makeDescriptors(-0.01f));
+    candidates_ = {1};
+  }
+
+  /**
+   * Only the candidate model is matched, every scene descriptor finds its copy in it
+   */
+  static void expectOnlyTheCandidate(const std::vector<pcl::CorrespondencesPtr>& corrs)
+  {
+    ASSERT_EQ(corrs.size(), 3u);
+    EXPECT_TRUE(corrs[0]->empty());
+    EXPECT_TRUE(corrs[2]->empty());
+    ASSERT_EQ(corrs[1]->size(), static_cast<std::size_t>(DESCRIPTORS));
+    for(const pcl::Correspondence& corr : *corrs[1])
+    {
+      EXPECT_EQ(corr.index_query, corr.index_match);
+    }
+  }
+
+  DescriptorCloud::Ptr scene_;
+  std::vector<DescriptorCloud::Ptr> models_;
+  std::vector<int> candidates_;
+};
+
+} // namespace
+
+TEST_F(DescriptorIndexFixture, FlannMatchesOnlyTheCandidates)
+{
+  DescriptorIndex index;
+  index.build(models_);
+  std::vector<pcl::CorrespondencesPtr> corrs;
+  index.match(*scene_, 1.0f, candidates_, corrs);
+  expectOnlyTheCandidate(corrs);
+}
+
+TEST_F(DescriptorIndexFixture, CompressedMatchesOnlyTheCandidates)
+{
+  CompressedDescriptorIndex index;
+  ASSERT_TRUE(index.build(models_, 16));
+  std::vector<pcl::CorrespondencesPtr> corrs;
+  index.match(*scene_, 1.0f, candidates_, corrs);
+  expectOnlyTheCandidate(corrs);
+}
+
+TEST_F(DescriptorIndexFixture, BinaryMatchesOnlyTheCandidates)
+{
+  BinaryDescriptorIndex index;
+  index.build(models_);
+  std::vector<pcl::CorrespondencesPtr> corrs;
+  index.match(*scene_, 352, candidates_, corrs);
+  expectOnlyTheCandidate(corrs);
+}
+
+TEST_F(DescriptorIndexFixture, NoCandidatesMatchesNothing)
+{
+  BinaryDescriptorIndex index;
+  index.build(models_);
+  std::vector<pcl::CorrespondencesPtr> corrs;
+  index.match(*scene_, 352, std::vector<int>(), corrs);
+  ASSERT_EQ(corrs.size(), 3u);
+  for(const pcl::CorrespondencesPtr& model_corrs : corrs)
+  {
+    EXPECT_TRUE(model_corrs->empty());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
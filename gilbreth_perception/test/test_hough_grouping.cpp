@@ -0,0 +1,178 @@
+#include "gilbreth_perception/hough_grouping.h"
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <pcl/recognition/cg/hough_3d.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+const int KEYPOINTS = 60;
+const int OUTLIERS = 10;
+
+void setFrame(const Eigen::Matrix3f& axes, pcl::ReferenceFrame& frame)
+{
+  Eigen::Map<Eigen::Vector3f>(frame.x_axis) = axes.col(0);
+  Eigen::Map<Eigen::Vector3f>(frame.y_axis) = axes.col(1);
+  Eigen::Map<Eigen::Vector3f>(frame.z_axis) = axes.col(2);
+}
+
+/**
+ * Model keypoints with arbitrary reference frames, and the same keypoints and frames moved into the scene by a
+ * known pose. The first KEYPOINTS correspondences pair every model keypoint with its own scene keypoint, the last
+ * OUTLIERS pair it with the next keypoint, at least 7 cm away.
+ */
+class HoughGroupingFixture : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    model_.reset(new HoughGrouping::Cloud);
+    model_rf_.reset(new HoughGrouping::Frames);
+    scene_.reset(new HoughGrouping::Cloud);
+    scene_rf_.reset(new HoughGrouping::Frames);
+
+    Eigen::Affine3f pose(Eigen::AngleAxisf(0.7f, Eigen::Vector3f::UnitZ()));
+    pose.translation() = Eigen::Vector3f(0.3f, -0.1f, 0.5f);
+    pose_ = pose.matrix();
+
+    for(int i = 0; i < KEYPOINTS; i++)
+    {
+      // deterministic spread over a 10 cm box
+      const Eigen::Vector3f p(0.1f * ((i * 7) % 11) / 10.0f, 0.1f * ((i * 5) % 13) / 12.0f,
+                              0.1f * ((i * 3) % 7) / 6.0f);
+      const Eigen::Matrix3f axes = Eigen::AngleAxisf(0.37f * i, Eigen::Vector3f(1.0f, 2.0f, 3.0f).normalized())
+                                   .toRotationMatrix();
+      pcl::PointXYZ model_point, scene_point;
+      model_point.getVector3fMap() = p;
+      scene_point.getVector3fMap() = pose * p;
+      model_->push_back(model_point);
+      scene_->push_back(scene_point);
+
+      pcl::ReferenceFrame model_frame, scene_frame;
+      setFrame(axes, model_frame);
+      setFrame(pose.linear() * axes, scene_frame);
+      model_rf_->push_back(model_frame);
+      scene_rf_->push_back(scene_frame);
+
+      corrs_.push_back(pcl::Correspondence(i, i, 0.1f));
+    }
+    for(int i = 0; i < OUTLIERS; i++)
+    {
+      corrs_.push_back(pcl::Correspondence(i, i + 1, 0.2f));
+    }
+
+    params_.bin_size = 0.02f;
+    params_.threshold = 5.0f;
+  }
+
+  /**
+   * Indices of the model keypoints of an instance, sorted
+   */
+  static std::vector<int> modelIndices(const pcl::Correspondences& corrs)
+  {
+    std::vector<int> indices;
+    for(const pcl::Correspondence& corr : corrs)
+    {
+      indices.push_back(corr.index_query);
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+  }
+
+  HoughGrouping::Cloud::Ptr model_;
+  HoughGrouping::Frames::Ptr model_rf_;
+  HoughGrouping::Cloud::Ptr scene_;
+  HoughGrouping::Frames::Ptr scene_rf_;
+  pcl::Correspondences corrs_;
+  Eigen::Matrix4f pose_;
+  HoughParameters params_;
+};
+
+} // namespace
+
+TEST_F(HoughGroupingFixture, FindsThePose)
+{
+  const HoughModel model(model_, model_rf_);
+  ASSERT_TRUE(model.isValid());
+
+  HoughInstances instances;
+  HoughGrouping(params_).recognize(model, scene_, *scene_rf_, corrs_, instances);
+  ASSERT_FALSE(instances.transformations.empty());
+  ASSERT_EQ(instances.transformations.size(), instances.clustered_corrs.size());
+  EXPECT_TRUE(instances.transformations[0].isApprox(pose_, 1e-3f));
+
+  std::vector<int> expected(KEYPOINTS);
+  for(int i = 0; i < KEYPOINTS; i++)
+  {
+    expected[i] = i;
+  }
+  EXPECT_EQ(modelIndices(instances.clustered_corrs[0]), expected);
+}
+
+TEST_F(HoughGroupingFixture, MatchesPclHough3DGrouping)
+{
+  pcl::Hough3DGrouping<pcl::PointXYZ, pcl::PointXYZ, pcl::ReferenceFrame, pcl::ReferenceFrame> reference;
+  reference.setInputCloud(model_);
+  reference.setInputRf(model_rf_);
+  reference.setSceneCloud(scene_);
+  reference.setSceneRf(scene_rf_);
+  reference.setModelSceneCorrespondences(pcl::CorrespondencesConstPtr(new pcl::Correspondences(corrs_)));
+  reference.setHoughBinSize(params_.bin_size);
+  reference.setHoughThreshold(params_.threshold);
+  reference.setUseInterpolation(params_.interpolation);
+  reference.setUseDistanceWeight(params_.distance_weight);
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > reference_transformations;
+  std::vector<pcl::Correspondences> reference_corrs;
+  ASSERT_TRUE(reference.recognize(reference_transformations, reference_corrs));
+  ASSERT_FALSE(reference_transformations.empty());
+
+  // the bins are anchored differently, so only the strongest instance is compared
+  const HoughModel model(model_, model_rf_);
+  HoughInstances instances;
+  HoughGrouping(params_).recognize(model, scene_, *scene_rf_, corrs_, instances);
+  ASSERT_FALSE(instances.transformations.empty());
+  EXPECT_TRUE(instances.transformations[0].isApprox(reference_transformations[0], 1e-3f));
+  EXPECT_EQ(modelIndices(instances.clustered_corrs[0]), modelIndices(reference_corrs[0]));
+}
+
+TEST_F(HoughGroupingFixture, ThreadPoolMatchesSingleModel)
+{
+  const HoughModel model(model_, model_rf_);
+  const HoughGrouping grouping(params_);
+  HoughInstances single;
+  grouping.recognize(model, scene_, *scene_rf_, corrs_, single);
+
+  // the same model twice, so that the votes of both are spread over the workers
+  ThreadPool pool(3);
+  const std::vector<const HoughModel*> models(2, &model);
+  const std::vector<pcl::CorrespondencesConstPtr> corrs(2, pcl::CorrespondencesConstPtr(
+                                                          new pcl::Correspondences(corrs_)));
+  std::vector<HoughInstances> instances;
+  grouping.recognize(models, scene_, *scene_rf_, corrs, pool, CancellationToken(), instances);
+  ASSERT_EQ(instances.size(), 2u);
+  for(const HoughInstances& pooled : instances)
+  {
+    ASSERT_EQ(pooled.transformations.size(), single.transformations.size());
+    ASSERT_FALSE(pooled.transformations.empty());
+    EXPECT_TRUE(pooled.transformations[0].isApprox(single.transformations[0], 1e-3f));
+    EXPECT_EQ(modelIndices(pooled.clustered_corrs[0]), modelIndices(single.clustered_corrs[0]));
+  }
+}
+
+TEST_F(HoughGroupingFixture, ThresholdAboveTheVotesFindsNothing)
+{
+  params_.threshold = KEYPOINTS + OUTLIERS + 1.0f;
+  const HoughModel model(model_, model_rf_);
+  HoughInstances instances;
+  HoughGrouping(params_).recognize(model, scene_, *scene_rf_, corrs_, instances);
+  EXPECT_TRUE(instances.transformations.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+#include "gilbreth_perception/hypothesis_verifier.h"
+#include <Eigen/Geometry>
+#include <gtest/gtest.h>
+#include <pcl/search/kdtree.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+/**
+ * Feeds a stream with one outlier every period points, or one inlier every period points, and returns the
+ * number of points added until the rejection, 0 when the whole stream passed
+ */
+std::size_t pointsUntilRejection(SequentialInlierTest& test, int period, bool periodic_inlier, std::size_t length)
+{
+  for(std::size_t i = 0; i < length; i++)
+  {
+    const bool periodic = i % period == 0;
+    if(!test.add(periodic == periodic_inlier))
+    {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+HypothesisVerifier::Cloud::Ptr makeGrid()
+{
+  HypothesisVerifier::Cloud::Ptr cloud(new HypothesisVerifier::Cloud);
+  for(int i = 0; i < 20; i++)
+  {
+    for(int j = 0; j < 20; j++)
+    {
+      cloud->push_back(pcl::PointXYZ(i * 0.005f, j * 0.005f, 0.0f));
+    }
+  }
+  return cloud;
+}
+
+} // namespace
+
+TEST(SequentialInlierTest, RejectsAKnownBadRatio)
+{
+  // an inlier ratio of 0.2 against a target of 0.8, every outlier raises the log ratio by log(0.6 / 0.2)
+  SequentialInlierTest test(0.8f, VerificationParameters());
+  const std::size_t rejected_after = pointsUntilRejection(test, 5, true, 1000);
+  EXPECT_GT(rejected_after, 0u);
+  EXPECT_LE(rejected_after, 20u);
+}
+
+TEST(SequentialInlierTest, KeepsAGoodRatio)
+{
+  SequentialInlierTest test(0.8f, VerificationParameters());
+  EXPECT_EQ(pointsUntilRejection(test, 10, false, 1000), 0u);
+}
+
+TEST(SequentialInlierTest, ZeroTargetNeverRejects)
+{
+  SequentialInlierTest test(0.0f, VerificationParameters());
+  EXPECT_EQ(pointsUntilRejection(test, 1000, true, 1000), 0u);
+}
+
+TEST(HypothesisVerifier, ScoresTheRightPose)
+{
+  const HypothesisVerifier::Cloud::Ptr scene = makeGrid();
+  pcl::search::KdTree<pcl::PointXYZ> scene_tree;
+  scene_tree.setInputCloud(scene);
+
+  HypothesisVerifier verifier;
+  const std::size_t model_id = verifier.addModel(*scene);
+  VerificationResult result;
+  ASSERT_TRUE(verifier.verify(model_id, scene_tree, Eigen::Matrix4f::Identity(), 0.9f, result));
+  EXPECT_FALSE(result.rejected);
+  EXPECT_EQ(result.evaluated, scene->size());
+  EXPECT_FLOAT_EQ(result.inlier_ratio, 1.0f);
+  EXPECT_NEAR(result.fitness_score, 0.0f, 1e-9f);
+}
+
+TEST(HypothesisVerifier, InlierDistanceIsSquared)
+{
+  const HypothesisVerifier::Cloud::Ptr scene = makeGrid();
+  pcl::search::KdTree<pcl::PointXYZ> scene_tree;
+  scene_tree.setInputCloud(scene);
+
+  // 1 cm inlier distance, a model 5 mm above the scene is within it and one 2 cm above is not
+  VerificationParameters params;
+  params.max_sqr_distance = 0.01f * 0.01f;
+  HypothesisVerifier verifier(params);
+  const std::size_t model_id = verifier.addModel(*scene);
+
+  Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+  pose(2, 3) = 0.005f;
+  VerificationResult result;
+  ASSERT_TRUE(verifier.verify(model_id, scene_tree, pose, 0.0f, result));
+  EXPECT_FLOAT_EQ(result.inlier_ratio, 1.0f);
+
+  pose(2, 3) = 0.02f;
+  verifier.verify(model_id, scene_tree, pose, 0.0f, result);
+  EXPECT_FLOAT_EQ(result.inlier_ratio, 0.0f);
+}
+
+TEST(HypothesisVerifier, RejectsAWrongPoseEarly)
+{
+  const HypothesisVerifier::Cloud::Ptr scene = makeGrid();
+  pcl::search::KdTree<pcl::PointXYZ> scene_tree;
+  scene_tree.setInputCloud(scene);
+
+  HypothesisVerifier verifier;
+  const std::size_t model_id = verifier.addModel(*scene);
+  Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+  pose(0, 3) = 0.5f;
+  VerificationResult result;
+  EXPECT_FALSE(verifier.verify(model_id, scene_tree, pose, 0.9f, result));
+  EXPECT_TRUE(result.rejected);
+  EXPECT_LT(result.evaluated, 20u);
+  EXPECT_FLOAT_EQ(result.inlier_ratio, 0.0f);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include "gilbreth_perception/keypoint_detector.h"
+#include <gtest/gtest.h>
+#include <pcl/search/kdtree.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+const float STEP = 0.005f;
+const int SIDE = 11;  // samples per face side, 5 cm faces
+
+/**
+ * Faces x = 0, y = 0 and z = 0 of a cube meeting at the origin, with their normals
+ */
+void makeCorner(KeypointDetector::Cloud& cloud, KeypointDetector::Normals& normals)
+{
+  for(int axis = 0; axis < 3; axis++)
+  {
+    for(int i = 0; i < SIDE; i++)
+    {
+      for(int j = 0; j < SIDE; j++)
+      {
+        Eigen::Vector3f p = Eigen::Vector3f::Zero();
+        p[(axis + 1) % 3] = i * STEP;
+        p[(axis + 2) % 3] = j * STEP;
+        pcl::PointXYZ point;
+        point.getVector3fMap() = p;
+        cloud.push_back(point);
+
+        pcl::Normal normal;
+        normal.getNormalVector3fMap() = Eigen::Vector3f::Unit(axis);
+        normals.push_back(normal);
+      }
+    }
+  }
+}
+
+void makePlane(KeypointDetector::Cloud& cloud, KeypointDetector::Normals& normals)
+{
+  for(int i = 0; i < SIDE; i++)
+  {
+    for(int j = 0; j < SIDE; j++)
+    {
+      cloud.push_back(pcl::PointXYZ(i * STEP, j * STEP, 0.0f));
+      pcl::Normal normal;
+      normal.getNormalVector3fMap() = Eigen::Vector3f::UnitZ();
+      normals.push_back(normal);
+    }
+  }
+}
+
+std::vector<int> allIndices(const KeypointDetector::Cloud& cloud)
+{
+  std::vector<int> indices(cloud.size());
+  for(std::size_t i = 0; i < indices.size(); i++)
+  {
+    indices[i] = static_cast<int>(i);
+  }
+  return indices;
+}
+
+} // namespace
+
+TEST(HarrisKeypointDetector, CornerRanksAbovePlane)
+{
+  const HarrisKeypointDetector detector((KeypointParameters()));
+
+  KeypointDetector::Cloud corner, plane;
+  KeypointDetector::Normals corner_normals, plane_normals;
+  makeCorner(corner, corner_normals);
+  makePlane(plane, plane_normals);
+
+  float corner_value, plane_value;
+  ASSERT_TRUE(detector.saliency(corner, corner_normals, allIndices(corner), corner_value));
+  ASSERT_TRUE(detector.saliency(plane, plane_normals, allIndices(plane), plane_value));
+  EXPECT_NEAR(plane_value, -detector.getParameters().harris_k, 1e-6f);
+  EXPECT_GT(corner_value, plane_value);
+}
+
+TEST(HarrisKeypointDetector, DetectsTheCornerFirst)
+{
+  KeypointParameters params;
+  params.method = "harris";
+  const std::unique_ptr<KeypointDetector> detector = createKeypointDetector(params);
+  ASSERT_TRUE(detector != nullptr);
+
+  KeypointDetector::Cloud::Ptr corner(new KeypointDetector::Cloud());
+  KeypointDetector::Normals corner_normals;
+  makeCorner(*corner, corner_normals);
+  pcl::search::KdTree<pcl::PointXYZ> search;
+  search.setInputCloud(corner);
+
+  KeypointDetector::Cloud keypoints;
+  detector->detect(corner, corner_normals, search, 1, keypoints);
+  ASSERT_EQ(keypoints.size(), 1u);
+  EXPECT_LT(keypoints[0].getVector3fMap().norm(), 2.0f * STEP);
+}
+
+TEST(HarrisKeypointDetector, DetectsKeypointsOnAPlane)
+{
+  KeypointParameters params;
+  params.method = "harris";
+  const std::unique_ptr<KeypointDetector> detector = createKeypointDetector(params);
+  ASSERT_TRUE(detector != nullptr);
+
+  KeypointDetector::Cloud::Ptr plane(new KeypointDetector::Cloud());
+  KeypointDetector::Normals plane_normals;
+  makePlane(*plane, plane_normals);
+  pcl::search::KdTree<pcl::PointXYZ> search;
+  search.setInputCloud(plane);
+
+  // every point ties, the spacing still spreads the keypoints and the budget bounds them
+  KeypointDetector::Cloud keypoints;
+  detector->detect(plane, plane_normals, search, 4, keypoints);
+  EXPECT_EQ(keypoints.size(), 4u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+#include "gilbreth_perception/object_tracker.h"
+#include <gtest/gtest.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+/**
+ * Corners of a box of the given size starting at the origin, shifted by offset
+ */
+ObjectTracker::Cloud makeBox(const Eigen::Vector3f& size, const Eigen::Vector3f& offset)
+{
+  ObjectTracker::Cloud cloud;
+  for(int corner = 0; corner < 8; corner++)
+  {
+    pcl::PointXYZ point;
+    for(int axis = 0; axis < 3; axis++)
+    {
+      point.getVector3fMap()[axis] = offset[axis] + ((corner >> axis) & 1 ? size[axis] : 0.0f);
+    }
+    cloud.push_back(point);
+  }
+  return cloud;
+}
+
+TrackingParameters beltParameters()
+{
+  TrackingParameters params;
+  params.belt_velocity = Eigen::Vector3f(0.0f, -1.0f, 0.0f);
+  params.max_centroid_distance = 0.03f;
+  params.max_extent_difference = 0.02f;
+  params.max_age = 5.0;
+  return params;
+}
+
+const Eigen::Vector3f BOX(0.1f, 0.05f, 0.02f);
+
+} // namespace
+
+TEST(ObjectTracker, MatchesTheObjectMovedAlongTheBelt)
+{
+  ObjectTracker tracker(beltParameters());
+  Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+  pose(0, 3) = 0.2f;
+  const int track_id = tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 1.0, pose);
+  EXPECT_EQ(tracker.size(), 1u);
+
+  // 0.5 s later the belt moved it 0.5 m along -y
+  TrackPrediction prediction;
+  ASSERT_TRUE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.005f, -0.5f, 0.0f)), 1.5, prediction));
+  EXPECT_EQ(prediction.track_id, track_id);
+  EXPECT_EQ(prediction.name, "gear");
+  EXPECT_TRUE(prediction.pose.col(3).head<3>().isApprox(Eigen::Vector3f(0.2f, -0.5f, 0.0f)));
+  EXPECT_EQ(tracker.getStats().matched, 1u);
+
+  // the track is claimed for this stamp
+  EXPECT_FALSE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.005f, -0.5f, 0.0f)), 1.5, prediction));
+  EXPECT_EQ(tracker.getStats().unmatched, 1u);
+
+  // the observation moves the track, the next prediction starts from it
+  EXPECT_EQ(tracker.update(track_id, "gear", makeBox(BOX, Eigen::Vector3f(0.005f, -0.5f, 0.0f)), 1.5, pose),
+            track_id);
+  EXPECT_EQ(tracker.size(), 1u);
+  EXPECT_TRUE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.005f, -0.6f, 0.0f)), 1.6, prediction));
+}
+
+TEST(ObjectTracker, RejectsFarOrDifferentClusters)
+{
+  ObjectTracker tracker(beltParameters());
+  tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 0.0, Eigen::Matrix4f::Identity());
+
+  TrackPrediction prediction;
+  // off the predicted centroid
+  EXPECT_FALSE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.1f, -0.1f, 0.0f)), 0.1, prediction));
+  // at the predicted centroid with larger extents
+  const Eigen::Vector3f larger = BOX + Eigen::Vector3f(0.04f, 0.0f, 0.0f);
+  EXPECT_FALSE(tracker.match(makeBox(larger, Eigen::Vector3f(-0.02f, -0.2f, 0.0f)), 0.2, prediction));
+  // without a finite point
+  ObjectTracker::Cloud empty;
+  EXPECT_FALSE(tracker.match(empty, 0.3, prediction));
+  EXPECT_EQ(tracker.getStats().unmatched, 3u);
+  EXPECT_EQ(tracker.getStats().matched, 0u);
+}
+
+TEST(ObjectTracker, TwoCandidatesAreAmbiguous)
+{
+  ObjectTracker tracker(beltParameters());
+  tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 0.0, Eigen::Matrix4f::Identity());
+  tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f(0.01f, 0.0f, 0.0f)), 0.0, Eigen::Matrix4f::Identity());
+  EXPECT_EQ(tracker.size(), 2u);
+
+  TrackPrediction prediction;
+  EXPECT_FALSE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.005f, -0.1f, 0.0f)), 0.1, prediction));
+  EXPECT_EQ(tracker.getStats().ambiguous, 1u);
+}
+
+TEST(ObjectTracker, DropsTracksOlderThanMaxAge)
+{
+  ObjectTracker tracker(beltParameters());
+  tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 0.0, Eigen::Matrix4f::Identity());
+  tracker.update(-1, "pulley", makeBox(BOX, Eigen::Vector3f(0.5f, 0.0f, 0.0f)), 4.0, Eigen::Matrix4f::Identity());
+
+  // the gear is 6 s old, the pulley 2 s
+  TrackPrediction prediction;
+  EXPECT_FALSE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.0f, -6.0f, 0.0f)), 6.0, prediction));
+  EXPECT_EQ(tracker.size(), 1u);
+  ASSERT_TRUE(tracker.match(makeBox(BOX, Eigen::Vector3f(0.5f, -2.0f, 0.0f)), 6.0, prediction));
+  EXPECT_EQ(prediction.name, "pulley");
+}
+
+TEST(ObjectTracker, DroppedTrackStartsOver)
+{
+  ObjectTracker tracker(beltParameters());
+  const int track_id = tracker.update(-1, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 0.0,
+                                      Eigen::Matrix4f::Identity());
+  tracker.drop(track_id);
+  EXPECT_EQ(tracker.size(), 0u);
+
+  const int new_id = tracker.update(track_id, "gear", makeBox(BOX, Eigen::Vector3f::Zero()), 0.1,
+                                    Eigen::Matrix4f::Identity());
+  EXPECT_NE(new_id, track_id);
+  EXPECT_EQ(tracker.size(), 1u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
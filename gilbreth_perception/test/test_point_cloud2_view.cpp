@@ -0,0 +1,128 @@
+#include "gilbreth_perception/point_cloud2_view.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <limits>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+bool hostIsBigendian()
+{
+  const std::uint16_t probe = 1;
+  return *reinterpret_cast<const std::uint8_t*>(&probe) == 0;
+}
+
+sensor_msgs::PointField makeField(const std::string& name, std::uint32_t offset, std::uint8_t datatype)
+{
+  sensor_msgs::PointField field;
+  field.name = name;
+  field.offset = offset;
+  field.datatype = datatype;
+  field.count = 1;
+  return field;
+}
+
+/**
+ * Row of points with x, y, z and 4 bytes of padding each, the second point is invalid
+ */
+sensor_msgs::PointCloud2 makeMessage()
+{
+  sensor_msgs::PointCloud2 msg;
+  msg.header.frame_id = "kinect";
+  msg.height = 1;
+  msg.width = 3;
+  msg.point_step = 16;
+  msg.row_step = msg.width * msg.point_step;
+  msg.is_bigendian = hostIsBigendian();
+  msg.is_dense = false;
+  msg.fields.push_back(makeField("x", 0, sensor_msgs::PointField::FLOAT32));
+  msg.fields.push_back(makeField("y", 4, sensor_msgs::PointField::FLOAT32));
+  msg.fields.push_back(makeField("z", 8, sensor_msgs::PointField::FLOAT32));
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float points[3][4] = {{0.1f, 0.2f, 0.3f, 0.0f}, {nan, nan, nan, 0.0f}, {-0.4f, 0.5f, 0.6f, 0.0f}};
+  msg.data.resize(msg.row_step * msg.height);
+  std::memcpy(msg.data.data(), points, msg.data.size());
+  return msg;
+}
+
+} // namespace
+
+TEST(PointCloud2View, ViewsTheBufferInPlace)
+{
+  const sensor_msgs::PointCloud2 msg = makeMessage();
+  XyzView view;
+  ASSERT_TRUE(makeXyzView(msg, view));
+  EXPECT_EQ(view.size(), 3u);
+  EXPECT_EQ(view.getWidth(), 3u);
+  EXPECT_EQ(view.getHeight(), 1u);
+  EXPECT_FALSE(view.isDense());
+  EXPECT_EQ(view.row(0), msg.data.data());
+  EXPECT_TRUE(view.point(2).isApprox(Eigen::Vector3f(-0.4f, 0.5f, 0.6f)));
+}
+
+TEST(PointCloud2View, CopiesTheFinitePoints)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  ASSERT_TRUE(copyToCloud(makeMessage(), cloud));
+  ASSERT_EQ(cloud.size(), 2u);
+  EXPECT_TRUE(cloud.points[0].getVector3fMap().isApprox(Eigen::Vector3f(0.1f, 0.2f, 0.3f)));
+  EXPECT_TRUE(cloud.points[1].getVector3fMap().isApprox(Eigen::Vector3f(-0.4f, 0.5f, 0.6f)));
+  EXPECT_EQ(cloud.header.frame_id, "kinect");
+}
+
+TEST(PointCloud2View, RejectsANonFloat32Field)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.fields[2].datatype = sensor_msgs::PointField::FLOAT64;
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+TEST(PointCloud2View, RejectsAFieldBeyondThePointStep)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.fields[2].offset = 14;
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+TEST(PointCloud2View, RejectsAMissingField)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.fields.pop_back();
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+TEST(PointCloud2View, RejectsTheOtherByteOrder)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.is_bigendian = !hostIsBigendian();
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+TEST(PointCloud2View, RejectsAShortBuffer)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.data.pop_back();
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+TEST(PointCloud2View, RejectsRowsShorterThanThePoints)
+{
+  sensor_msgs::PointCloud2 msg = makeMessage();
+  msg.row_step = msg.width * msg.point_step - 1;
+  XyzView view;
+  EXPECT_FALSE(makeXyzView(msg, view));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,70 @@
+#include "gilbreth_perception/segmentation.h"
+#include <gtest/gtest.h>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+/**
+ * Two 5 cm squares on a plane half a meter from the camera, 20 cm apart, in the kinect frame
+ */
+Segmenter::Cloud::Ptr makeScene()
+{
+  Segmenter::Cloud::Ptr scene(new Segmenter::Cloud);
+  for(float x0 : {-0.12f, 0.08f})
+  {
+    for(int i = 0; i < 10; i++)
+    {
+      for(int j = 0; j < 10; j++)
+      {
+        scene->push_back(pcl::PointXYZ(x0 + i * 0.005f, j * 0.005f, 0.5f));
+      }
+    }
+  }
+  scene->header.frame_id = "kinect";
+  return scene;
+}
+
+SegmentationParameters smallParts()
+{
+  SegmentationParameters params;
+  params.min_cluster_size = 5;
+  params.cluster_tolerance = 0.02f;
+  return params;
+}
+
+} // namespace
+
+TEST(Segmenter, ClustersKeepTheFrameOfTheCloud)
+{
+  const Segmenter segmenter(smallParts());
+  StageTimer timer;
+  std::vector<Segmenter::Cloud::Ptr> clusters;
+  ASSERT_TRUE(segmenter.segment(makeScene(), timer, clusters));
+  ASSERT_EQ(clusters.size(), 2u);
+  for(const Segmenter::Cloud::Ptr& cluster : clusters)
+  {
+    EXPECT_EQ(cluster->header.frame_id, "kinect");
+  }
+}
+
+TEST(Segmenter, ClustersOfAViewKeepTheFrameOfTheMessage)
+{
+  const Segmenter::Cloud::Ptr scene = makeScene();
+  const Segmenter segmenter(smallParts());
+  StageTimer timer;
+  std::vector<Segmenter::Cloud::Ptr> clusters;
+  ASSERT_TRUE(segmenter.segment(XyzView::fromCloud(*scene), scene->header, timer, clusters));
+  ASSERT_EQ(clusters.size(), 2u);
+  for(const Segmenter::Cloud::Ptr& cluster : clusters)
+  {
+    EXPECT_EQ(cluster->header.frame_id, "kinect");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+#include "gilbreth_perception/thread_pool.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace gilbreth::perception;
+
+TEST(ThreadPool, RunsEveryItemOnce)
+{
+  ThreadPool pool(4);
+  ASSERT_EQ(pool.size(), 4u);
+
+  const std::size_t count = 1000;
+  std::vector<std::atomic<int> > runs(count);
+  for(std::atomic<int>& run : runs)
+  {
+    run = 0;
+  }
+  pool.parallelFor(count, [&runs](std::size_t worker_id, std::size_t item)
+  {
+    runs[item]++;
+  });
+
+  for(std::size_t i = 0; i < count; i++)
+  {
+    EXPECT_EQ(runs[i], 1) << "item " << i;
+  }
+}
+
+TEST(ThreadPool, WorkerIdsAreBelowSize)
+{
+  ThreadPool pool(3);
+  std::vector<std::atomic<int> > items_per_worker(pool.size());
+  for(std::atomic<int>& items : items_per_worker)
+  {
+    items = 0;
+  }
+  std::atomic<bool> out_of_range(false);
+  pool.parallelFor(300, [&](std::size_t worker_id, std::size_t item)
+  {
+    if(worker_id >= items_per_worker.size())
+    {
+      out_of_range = true;
+      return;
+    }
+    items_per_worker[worker_id]++;
+  });
+
+  EXPECT_FALSE(out_of_range);
+  int total = 0;
+  for(const std::atomic<int>& items : items_per_worker)
+  {
+    total += items;
+  }
+  EXPECT_EQ(total, 300);
+}
+
+TEST(ThreadPool, WorkerStateIsNotShared)
+{
+  // every worker only touches its own slot, so unsynchronized per-worker sums add up to the whole range
+  ThreadPool pool(4);
+  std::vector<std::size_t> sums(pool.size(), 0);
+  const std::size_t count = 10000;
+  pool.parallelFor(count, [&sums](std::size_t worker_id, std::size_t item)
+  {
+    sums[worker_id] += item;
+  });
+
+  std::size_t total = 0;
+  for(std::size_t sum : sums)
+  {
+    total += sum;
+  }
+  EXPECT_EQ(total, count * (count - 1) / 2);
+}
+
+TEST(ThreadPool, EmptyRangeReturns)
+{
+  ThreadPool pool(2);
+  std::atomic<int> runs(0);
+  pool.parallelFor(0, [&runs](std::size_t worker_id, std::size_t item)
+  {
+    runs++;
+  });
+  EXPECT_EQ(runs, 0);
+}
+
+TEST(ThreadPool, RethrowsTaskErrorAndStaysUsable)
+{
+  ThreadPool pool(2);
+  std::atomic<int> runs(0);
+  EXPECT_THROW(pool.parallelFor(10, [&runs](std::size_t worker_id, std::size_t item)
+               {
+                 runs++;
+                 if(item == 5)
+                 {
+                   throw std::runtime_error("item 5");
+                 }
+               }), std::runtime_error);
+  EXPECT_EQ(runs, 10);
+
+  runs = 0;
+  pool.parallelFor(10, [&runs](std::size_t worker_id, std::size_t item)
+  {
+    runs++;
+  });
+  EXPECT_EQ(runs, 10);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
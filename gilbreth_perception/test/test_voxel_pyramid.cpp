@@ -0,0 +1,29 @@
+#include "gilbreth_perception/voxel_pyramid.h"
+#include <gtest/gtest.h>
+
+using namespace gilbreth::perception;
+
+TEST(VoxelPyramid, FinestLevelOfTheNominalLeafIsZero)
+{
+  EXPECT_EQ(finestLevel(0.01f, 0.01f, 3), 0);
+  EXPECT_EQ(finestLevel(0.01f, 0.005f, 3), 0);
+}
+
+TEST(VoxelPyramid, FinestLevelReachesTheCoarsenedLeaf)
+{
+  EXPECT_EQ(finestLevel(0.01f, 0.015f, 3), 1);
+  EXPECT_EQ(finestLevel(0.01f, 0.02f, 3), 1);
+  EXPECT_EQ(finestLevel(0.01f, 0.03f, 3), 2);
+}
+
+TEST(VoxelPyramid, FinestLevelStaysWithinTheLevels)
+{
+  EXPECT_EQ(finestLevel(0.01f, 0.1f, 3), 2);
+  EXPECT_EQ(finestLevel(0.01f, 0.02f, 1), 0);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include "gilbreth_perception/work_queue.h"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace gilbreth::perception;
+
+namespace
+{
+
+std::vector<int> drain(WorkQueue<int>& queue)
+{
+  queue.close();
+  std::vector<int> items;
+  int item;
+  while(queue.pop(item))
+  {
+    items.push_back(item);
+  }
+  return items;
+}
+
+/**
+ * Waits until a producer is parked in push(), false after a second
+ */
+bool waitForBlockedPush(const WorkQueue<int>& queue, std::uint64_t blocked)
+{
+  for(int i = 0; i < 1000; i++)
+  {
+    if(queue.getStats().blocked >= blocked)
+    {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+} // namespace
+
+TEST(WorkQueue, ParsesPolicies)
+{
+  OverflowPolicy policy;
+  ASSERT_TRUE(parseOverflowPolicy("drop_oldest", policy));
+  EXPECT_EQ(policy, OverflowPolicy::DROP_OLDEST);
+  ASSERT_TRUE(parseOverflowPolicy("drop_newest", policy));
+  EXPECT_EQ(policy, OverflowPolicy::DROP_NEWEST);
+  ASSERT_TRUE(parseOverflowPolicy("block", policy));
+  EXPECT_EQ(policy, OverflowPolicy::BLOCK);
+  EXPECT_FALSE(parseOverflowPolicy("drop", policy));
+}
+
+TEST(WorkQueue, DropOldestKeepsTheNewestItems)
+{
+  WorkQueue<int> queue(3, OverflowPolicy::DROP_OLDEST);
+  for(int i = 0; i < 5; i++)
+  {
+    EXPECT_TRUE(queue.push(i));
+  }
+  EXPECT_EQ(queue.size(), 3u);
+
+  const WorkQueueStats stats = queue.getStats();
+  EXPECT_EQ(stats.pushed, 5u);
+  EXPECT_EQ(stats.dropped_oldest, 2u);
+  EXPECT_EQ(stats.dropped_newest, 0u);
+  EXPECT_EQ(stats.high_water_mark, 3u);
+  EXPECT_EQ(drain(queue), std::vector<int>({2, 3, 4}));
+}
+
+TEST(WorkQueue, DropNewestKeepsTheOldestItems)
+{
+  WorkQueue<int> queue(3, OverflowPolicy::DROP_NEWEST);
+  for(int i = 0; i < 5; i++)
+  {
+    EXPECT_EQ(queue.push(i), i < 3);
+  }
+
+  const WorkQueueStats stats = queue.getStats();
+  EXPECT_EQ(stats.pushed, 3u);
+  EXPECT_EQ(stats.dropped_oldest, 0u);
+  EXPECT_EQ(stats.dropped_newest, 2u);
+  EXPECT_EQ(drain(queue), std::vector<int>({0, 1, 2}));
+}
+
+TEST(WorkQueue, BlockWaitsForRoom)
+{
+  WorkQueue<int> queue(2, OverflowPolicy::BLOCK);
+  ASSERT_TRUE(queue.push(0));
+  ASSERT_TRUE(queue.push(1));
+
+  bool pushed = false;
+  std::thread producer([&queue, &pushed]()
+  {
+    pushed = queue.push(2);
+  });
+  ASSERT_TRUE(waitForBlockedPush(queue, 1));
+  EXPECT_EQ(queue.size(), 2u);
+
+  int item;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 0);
+  producer.join();
+  EXPECT_TRUE(pushed);
+
+  const WorkQueueStats stats = queue.getStats();
+  EXPECT_EQ(stats.pushed, 3u);
+  EXPECT_EQ(stats.dropped(), 0u);
+  EXPECT_EQ(stats.high_water_mark, 2u);
+  EXPECT_EQ(drain(queue), std::vector<int>({1, 2}));
+}
+
+TEST(WorkQueue, CloseReleasesABlockedProducer)
+{
+  WorkQueue<int> queue(1, OverflowPolicy::BLOCK);
+  ASSERT_TRUE(queue.push(0));
+
+  bool pushed = true;
+  std::thread producer([&queue, &pushed]()
+  {
+    pushed = queue.push(1);
+  });
+  ASSERT_TRUE(waitForBlockedPush(queue, 1));
+  queue.close();
+  producer.join();
+
+  EXPECT_FALSE(pushed);
+  EXPECT_EQ(queue.getStats().dropped_newest, 1u);
+  EXPECT_FALSE(queue.push(2));
+  EXPECT_EQ(drain(queue), std::vector<int>({0}));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}